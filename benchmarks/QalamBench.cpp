@@ -0,0 +1,208 @@
+// Editor performance benchmarks on synthetic Baa sources.
+//
+// Usage: qalam_bench [--lines 1000,10000,100000] [--output results.json]
+//
+// Prints one JSON document so results can be archived and compared release
+// to release. Every result carries a stable "name", the corpus size in
+// "lines", a "value" and its "unit".
+
+#include "TLexer.h"
+#include "TScanKernels.h"
+#include "TSyntaxHighlighter.h"
+#include "ThemeManager.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// Lines per visible page, as in a typical editor window.
+constexpr int ViewportLines = 50;
+constexpr int Keystrokes = 200;
+// Lower bound on measured time for the throughput loop.
+constexpr qint64 MinimumLexNanoseconds = 200'000'000;
+
+// Repeats a small Baa program with functions, loops, strings, numbers and
+// comments until the requested line count is reached.
+QStringList generateCorpus(int lines)
+{
+    const QStringList unit = {
+        QStringLiteral("#تضمين \"مكتبة.baa\""),
+        QStringLiteral("// دالة تحسب مجموع عناصر الجدول %1"),
+        QStringLiteral("صحيح مجموع_%1(صحيح جدول[]، صحيح طول) {"),
+        QStringLiteral("    صحيح المجموع = ٠."),
+        QStringLiteral("    لكل (صحيح ع = 0؛ ع < طول؛ ع++) {"),
+        QStringLiteral("        إذا (جدول[ع] >= 0x1F) {"),
+        QStringLiteral("            المجموع += جدول[ع] * ٤٢."),
+        QStringLiteral("        } وإلا {"),
+        QStringLiteral("            اطبع(\"قيمة صغيرة: \\\"%1\\\" في الموضع \")."),
+        QStringLiteral("        }"),
+        QStringLiteral("    }"),
+        QStringLiteral("    إرجع المجموع."),
+        QStringLiteral("}"),
+        QString(),
+    };
+
+    QStringList corpus;
+    corpus.reserve(lines);
+    for (int i = 0; corpus.size() < lines; ++i) {
+        const QString &line = unit[i % unit.size()];
+        corpus << (line.contains(QLatin1String("%1")) ? line.arg(i / unit.size()) : line);
+    }
+    return corpus;
+}
+
+QJsonObject result(const QString &name, int lines, double value, const QString &unit)
+{
+    return QJsonObject{{"name", name}, {"lines", lines}, {"value", value}, {"unit", unit}};
+}
+
+double percentile(QList<qint64> samples, double fraction)
+{
+    std::sort(samples.begin(), samples.end());
+    const qsizetype index = qMin(samples.size() - 1, qsizetype(fraction * samples.size()));
+    return double(samples[index]);
+}
+
+// Runs the event loop until the highlighter has no background work left.
+void waitForHighlighter(const TSyntaxHighlighter &highlighter)
+{
+    while (highlighter.hasPendingBlocks()) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+}
+
+void benchmarkLexer(const QStringList &corpus, QJsonArray &results)
+{
+    TLexer lexer;
+    QVector<TTokenSpan> spans;
+    qint64 bytes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        int state = StateMasks::Normal;
+        for (const QString &line : corpus) {
+            state = lexer.tokenize(line, state, spans);
+            // Throughput is over the UTF-16 text the lexer actually reads.
+            bytes += line.size() * qint64(sizeof(QChar));
+        }
+    } while (timer.nsecsElapsed() < MinimumLexNanoseconds);
+
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    results.append(result("lexer_throughput", int(corpus.size()), bytes / seconds / 1e6, "MB/s"));
+}
+
+void benchmarkHighlighter(const QStringList &corpus, QJsonArray &results)
+{
+    const int lines = int(corpus.size());
+    QTextDocument document;
+    TSyntaxHighlighter highlighter(&document);
+    highlighter.setTheme(ThemeManager::getThemeByIndex(0));
+    highlighter.setVisibleBlocks(0, ViewportLines - 1);
+
+    // Opening a file: everything is lexed and colored.
+    QElapsedTimer timer;
+    timer.start();
+    document.setPlainText(corpus.join('\n'));
+    const qint64 visible = timer.nsecsElapsed();
+    waitForHighlighter(highlighter);
+    results.append(result("open_visible_ms", lines, visible / 1e6, "ms"));
+    results.append(result("open_full_highlight_ms", lines, timer.nsecsElapsed() / 1e6, "ms"));
+
+    // Full rehighlight, e.g. after a theme switch.
+    timer.restart();
+    highlighter.setTheme(ThemeManager::getThemeByIndex(1));
+    waitForHighlighter(highlighter);
+    results.append(result("full_rehighlight_ms", lines, timer.nsecsElapsed() / 1e6, "ms"));
+
+    // Single keystrokes in the middle of the viewport; only the synchronous
+    // part is on the typing path.
+    QList<qint64> latencies;
+    latencies.reserve(Keystrokes);
+    QTextCursor cursor(document.findBlockByNumber(ViewportLines / 2));
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    for (int i = 0; i < Keystrokes; ++i) {
+        timer.restart();
+        cursor.insertText(QStringLiteral("س"));
+        latencies.append(timer.nsecsElapsed());
+    }
+    waitForHighlighter(highlighter);
+    results.append(result("keystroke_median_us", lines, percentile(latencies, 0.5) / 1e3, "us"));
+    results.append(result("keystroke_p95_us", lines, percentile(latencies, 0.95) / 1e3, "us"));
+
+    // A quote turns the rest of the document into a string: the worst case
+    // for a single keystroke.
+    cursor.movePosition(QTextCursor::StartOfBlock);
+    timer.restart();
+    cursor.insertText(QStringLiteral("\""));
+    const qint64 quoteLatency = timer.nsecsElapsed();
+    waitForHighlighter(highlighter);
+    results.append(result("open_string_keystroke_us", lines, quoteLatency / 1e3, "us"));
+    results.append(result("open_string_settle_ms", lines, timer.nsecsElapsed() / 1e6, "ms"));
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName("qalam_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Qalam editor performance benchmarks");
+    parser.addHelpOption();
+    parser.addOption({"lines", "Comma-separated corpus sizes in lines.", "sizes", "1000,10000,100000"});
+    parser.addOption({"output", "Write the JSON results to <file> instead of stdout.", "file"});
+    parser.process(app);
+
+    QList<int> sizes;
+    for (const QString &size : parser.value("lines").split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int lines = size.toInt(&ok);
+        if (!ok || lines <= 0) {
+            qCritical("Invalid corpus size: %s", qPrintable(size));
+            return 2;
+        }
+        sizes.append(lines);
+    }
+
+    QJsonArray results;
+    for (int lines : sizes) {
+        const QStringList corpus = generateCorpus(lines);
+        benchmarkLexer(corpus, results);
+        benchmarkHighlighter(corpus, results);
+    }
+
+    const QJsonObject report{
+        {"benchmark", "qalam_bench"},
+        {"version", QStringLiteral(QALAM_VERSION)},
+        {"qt", QString::fromLatin1(qVersion())},
+        {"cpu", QSysInfo::currentCpuArchitecture()},
+        {"scan_kernels", QString::fromLatin1(TScanKernels::activeVariant())},
+        {"results", results},
+    };
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet("output")) {
+        QFile file(parser.value("output"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical("Cannot write %s", qPrintable(file.fileName()));
+            return 1;
+        }
+        file.write(json);
+    } else {
+        fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    }
+    return 0;
+}
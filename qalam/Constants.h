@@ -15,6 +15,7 @@ namespace Constants {
     const QString SettingsKeySidebarWidth = "sidebarWidth";
     const QString SettingsKeyPanelHeight = "panelHeight";
     const QString SettingsKeyShowWelcome = "ShowWelcomeOnStartup";
+    const QString SettingsKeyLargeFileThreshold = "largeFileThresholdMB";
 
     // Session Keys
     const QString SessionKeyOpenFiles = "session/openFiles";
@@ -44,6 +45,8 @@ namespace Constants {
     // Defaults
     const int DefaultFontSize = 18;
     const QString DefaultFontType = "Kawkab Mono";
+    // Files larger than this (in MB) open in the read-only large-file view.
+    const int DefaultLargeFileThresholdMB = 10;
 
     // ==========================================================================
     // UI Colors - VS Code Dark+ (RTL-first)
@@ -217,6 +220,26 @@ namespace Constants {
         constexpr int AutoSaveInterval = 30000;
         constexpr int SearchDebounce = 300;
         constexpr int HoverDelay = 500;
+        // Syntax highlighting: per-slice work budget for off-screen blocks,
+        // and the typing pause before that background pass resumes.
+        constexpr int HighlightSliceBudget = 8;
+        constexpr int HighlightIdleDelay = 100;
+        // Folding: per-slice budget for analyzing blocks off the typing path.
+        constexpr int FoldSliceBudget = 8;
+        // Large-file view: per-slice budget for indexing line breaks.
+        constexpr int LargeFileIndexSliceBudget = 8;
+        // Opening a file: per-slice budget for appending its text.
+        constexpr int LoadSliceBudget = 8;
+    }
+
+    // ==========================================================================
+    // Completion
+    // ==========================================================================
+    namespace Completion {
+        // Items shown in the popup, best first.
+        constexpr int MaxItems = 50;
+        // Accepted labels remembered for ranking.
+        constexpr int HistorySize = 256;
     }
 
     // ==========================================================================
@@ -37,6 +37,7 @@
 #include "DiagnosticParser.h"
 #include "DiagnosticsModel.h"
 #include "WorkspaceIndexer.h"
+#include "WorkspaceWordIndex.h"
 #include "BreakpointModel.h"
 #include "TCommandPalette.h"
 
@@ -125,13 +126,16 @@ Qalam::Qalam(const QString& filePath, QWidget *parent)
         }
 
         // Restore open files
-        bool restoredAny = false;
+        // Tabs are placeholders until shown, so only the active one reads
+        // its file and builds an editor now.
+        QStringList restoredFiles;
         for (const QString &file : session.openFiles) {
             if (QFile::exists(file)) {
-                m_fileManager->openFile(file);
-                restoredAny = true;
+                restoredFiles.append(file);
             }
         }
+        m_fileManager->restoreFiles(restoredFiles);
+        const bool restoredAny = not restoredFiles.isEmpty();
 
         // Restore active tab
         if (restoredAny and session.activeTabIndex >= 0
@@ -188,6 +192,26 @@ void Qalam::connectSignals()
         if (TEditor* editor = currentEditor()) editor->moveLineDown();
     });
 
+    auto *nextOccurrenceShortcut = new QShortcut(QKeySequence("Alt+J"), this);
+    connect(nextOccurrenceShortcut, &QShortcut::activated, this, [this](){
+        if (TEditor* editor = currentEditor()) editor->addNextOccurrence();
+    });
+
+    auto *allOccurrencesShortcut = new QShortcut(QKeySequence("Ctrl+Shift+L"), this);
+    connect(allOccurrencesShortcut, &QShortcut::activated, this, [this](){
+        if (TEditor* editor = currentEditor()) editor->selectAllOccurrences();
+    });
+
+    auto *cursorAboveShortcut = new QShortcut(QKeySequence("Ctrl+Alt+Up"), this);
+    connect(cursorAboveShortcut, &QShortcut::activated, this, [this](){
+        if (TEditor* editor = currentEditor()) editor->addCursorAbove();
+    });
+
+    auto *cursorBelowShortcut = new QShortcut(QKeySequence("Ctrl+Alt+Down"), this);
+    connect(cursorBelowShortcut, &QShortcut::activated, this, [this](){
+        if (TEditor* editor = currentEditor()) editor->addCursorBelow();
+    });
+
     auto *stopToolingShortcut = new QShortcut(QKeySequence("Shift+F5"), this);
     connect(stopToolingShortcut, &QShortcut::activated, this, [this]() {
         if (m_buildManager and m_buildManager->isRunning()) m_buildManager->stop();
@@ -295,6 +319,19 @@ void Qalam::connectSignals()
     });
     connect(m_fileManager, &FileManager::openEditorsChanged, this, &Qalam::syncOpenEditors);
 
+    // --- Workspace completion words ---
+    connect(m_workspaceIndexer, &WorkspaceIndexer::indexUpdated, this, [this]() {
+        WorkspaceWordIndex::instance()->setFiles(m_workspaceIndexer->files());
+    });
+    connect(m_fileManager, &FileManager::fileSaved, this,
+            [this](const QString &filePath, const TDocumentSnapshot &content) {
+        const QString root = m_workspaceIndexer->rootPath();
+        if (root.isEmpty() or m_workspaceIndexer->isIgnoredPath(filePath)) return;
+        const QString canonicalRoot = QFileInfo(root).canonicalFilePath();
+        if (!QFileInfo(filePath).canonicalFilePath().startsWith(canonicalRoot + QLatin1Char('/'))) return;
+        WorkspaceWordIndex::instance()->updateFile(filePath, content);
+    });
+
     // --- Layout component signals ---
     auto *activityBar = m_layoutManager->activityBar();
     auto *sidebar = m_layoutManager->sidebar();
@@ -367,16 +404,21 @@ bool Qalam::eventFilter(QObject *object, QEvent *event)
 void Qalam::goToLine()
 {
     TEditor *editor = currentEditor();
-    if (!editor) return;
+    auto *largeFileView = qobject_cast<TLargeFileView*>(tabWidget->currentWidget());
+    if (!editor and !largeFileView) return;
 
     bool ok;
-    int maxLine = editor->blockCount();
+    if (largeFileView) largeFileView->finishIndexing();
+    int maxLine = editor ? editor->blockCount() : largeFileView->lineCount();
 
     int lineNumber = QInputDialog::getInt(this, "الذهاب إلى سطر",
                                           QString("أدخل رقم السطر (1 - %1):").arg(maxLine),
                                           1, 1, maxLine, 1, &ok);
 
-    if (ok) {
+    if (ok and largeFileView) {
+        largeFileView->goToLine(lineNumber - 1);
+        largeFileView->setFocus();
+    } else if (ok) {
         QTextCursor cursor = editor->textCursor();
         cursor.setPosition(0);
         cursor.movePosition(QTextCursor::Down, QTextCursor::MoveAnchor, lineNumber - 1);
@@ -387,7 +429,11 @@ void Qalam::goToLine()
 }
 
 void Qalam::showFindBar() {
-    searchBar->setEditor(currentEditor());
+    if (auto *largeFileView = qobject_cast<TLargeFileView*>(tabWidget->currentWidget())) {
+        searchBar->setLargeFileView(largeFileView);
+    } else {
+        searchBar->setEditor(currentEditor());
+    }
     searchBar->show();
     searchBar->setFocusToInput();
 }
@@ -396,6 +442,8 @@ void Qalam::hideFindBar() {
     searchBar->hide();
     if (TEditor* editor = currentEditor()) {
         editor->setFocus();
+    } else if (QWidget *tab = qobject_cast<TLargeFileView*>(tabWidget->currentWidget())) {
+        tab->setFocus();
     }
 }
 
@@ -492,6 +540,11 @@ void Qalam::onCurrentTabChanged()
             m_layoutManager->breadcrumb()->setVisible(!editor->currentFilePath().isEmpty());
         }
         applyDiagnosticsToEditors();
+    } else if (auto *largeFileView = qobject_cast<TLargeFileView*>(tabWidget->currentWidget())) {
+        searchBar->setLargeFileView(largeFileView);
+        if (m_layoutManager->breadcrumb()) {
+            m_layoutManager->breadcrumb()->hide();
+        }
     } else {
         searchBar->setEditor(nullptr);
         if (m_layoutManager->breadcrumb()) {
@@ -652,7 +705,8 @@ bool Qalam::shouldShowWelcome() const
 bool Qalam::hasAnyEditorTabs() const
 {
     for (int i = 0; i < tabWidget->count(); ++i) {
-        if (qobject_cast<TEditor*>(tabWidget->widget(i))) {
+        QWidget *tab = tabWidget->widget(i);
+        if (qobject_cast<TEditor*>(tab) or qobject_cast<TLargeFileView*>(tab) or qobject_cast<TEditorPlaceholder*>(tab)) {
             return true;
         }
     }
@@ -736,14 +790,16 @@ void Qalam::closeTab(int index)
         return;
     }
 
+    // Large-file views and restored placeholders never need saving, but
+    // they count as open files like an editor does.
     TEditor* editor = qobject_cast<TEditor*>(tab);
-    if (!editor) {
+    if (!editor and !qobject_cast<TLargeFileView*>(tab) and !qobject_cast<TEditorPlaceholder*>(tab)) {
         tabWidget->removeTab(index);
         tab->deleteLater();
         return;
     }
 
-    if (editor->document()->isModified()) {
+    if (editor and editor->document()->isModified()) {
         const int previousIndex = tabWidget->currentIndex();
         tabWidget->setCurrentIndex(index);
         auto saveResult = m_fileManager->needSave(editor);
@@ -759,7 +815,7 @@ void Qalam::closeTab(int index)
     }
 
     tabWidget->removeTab(index);
-    editor->deleteLater();
+    tab->deleteLater();
     syncOpenEditors();
 
     if (not hasAnyEditorTabs()) {
@@ -807,6 +863,13 @@ void Qalam::goToLocation(const QString &filePath, int line, int column)
     TEditor *editor = currentEditor();
     if (!editor) return;
 
+    if (editor->isLoading()) {
+        connect(editor, &TEditor::loadingFinished, this, [this, filePath, line, column]() {
+            goToLocation(filePath, line, column);
+        }, Qt::SingleShotConnection);
+        return;
+    }
+
     QTextCursor cursor(editor->document());
     const int targetLine = qMax(1, line);
     cursor.movePosition(QTextCursor::Down, QTextCursor::MoveAnchor, targetLine - 1);
@@ -823,10 +886,10 @@ void Qalam::closeEditorByPath(const QString &filePath)
     const QString targetClean = QDir::cleanPath(filePath);
 
     for (int i = 0; i < tabWidget->count(); ++i) {
-        TEditor *editor = qobject_cast<TEditor*>(tabWidget->widget(i));
-        if (!editor) continue;
+        QWidget *tab = tabWidget->widget(i);
+        const QString editorPath = FileManager::filePathOf(tab);
+        if (!qobject_cast<TEditor*>(tab) and editorPath.isEmpty()) continue;
 
-        const QString editorPath = editor->currentFilePath();
         const QString editorCanonical = QFileInfo(editorPath).canonicalFilePath();
         const QString editorClean = QDir::cleanPath(editorPath);
 
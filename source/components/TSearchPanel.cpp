@@ -1,5 +1,6 @@
 #include "TSearchPanel.h"
 #include "Constants.h"
+#include "TLargeFileView.h"
 #include <QApplication>
 #include <QTextDocument>
 #include <QStyle>
@@ -83,10 +84,28 @@ SearchPanel::SearchPanel(QWidget *parent) : QWidget(parent) {
 
 void SearchPanel::setEditor(QPlainTextEdit *editor) {
     m_editor = editor;
+    m_largeFileView = nullptr;
+}
+
+void SearchPanel::setLargeFileView(TLargeFileView *view) {
+    m_editor = nullptr;
+    m_largeFileView = view;
+}
+
+bool SearchPanel::find(const QString &text, QTextDocument::FindFlags flags, bool fromEdge) {
+    const bool backward = flags & QTextDocument::FindBackward;
+    if (m_largeFileView) {
+        if (fromEdge and backward) m_largeFileView->moveToEnd();
+        else if (fromEdge) m_largeFileView->moveToStart();
+        return m_largeFileView->find(text, flags);
+    }
+
+    if (fromEdge) m_editor->moveCursor(backward ? QTextCursor::End : QTextCursor::Start);
+    return m_editor->find(text, flags);
 }
 
 void SearchPanel::performFind() {
-    if (!m_editor) return;
+    if (!m_editor and !m_largeFileView) return;
 
     QString text = getText();
     if (text.isEmpty()) return;
@@ -95,8 +114,7 @@ void SearchPanel::performFind() {
     if (isCaseSensitive()) flags |= QTextDocument::FindCaseSensitively;
     if (isWholeWord()) flags |= QTextDocument::FindWholeWords;
 
-    m_editor->moveCursor(QTextCursor::Start);
-    bool found = m_editor->find(text, flags);
+    bool found = find(text, flags, true);
 
     if (!found) {
         QApplication::beep();
@@ -104,7 +122,7 @@ void SearchPanel::performFind() {
 }
 
 void SearchPanel::performFindNext() {
-    if (!m_editor) return;
+    if (!m_editor and !m_largeFileView) return;
 
     QString text = getText();
     if (text.isEmpty()) return;
@@ -113,12 +131,11 @@ void SearchPanel::performFindNext() {
     if (isCaseSensitive()) flags |= QTextDocument::FindCaseSensitively;
     if (isWholeWord()) flags |= QTextDocument::FindWholeWords;
 
-    bool found = m_editor->find(text, flags);
+    bool found = find(text, flags, false);
 
     if (!found) {
         // Wrap around to start
-        m_editor->moveCursor(QTextCursor::Start);
-        found = m_editor->find(text, flags);
+        found = find(text, flags, true);
         if (!found) {
             QApplication::beep();
         }
@@ -126,7 +143,7 @@ void SearchPanel::performFindNext() {
 }
 
 void SearchPanel::performFindPrev() {
-    if (!m_editor) return;
+    if (!m_editor and !m_largeFileView) return;
 
     QString text = getText();
     if (text.isEmpty()) return;
@@ -135,12 +152,11 @@ void SearchPanel::performFindPrev() {
     if (isCaseSensitive()) flags |= QTextDocument::FindCaseSensitively;
     if (isWholeWord()) flags |= QTextDocument::FindWholeWords;
 
-    bool found = m_editor->find(text, flags);
+    bool found = find(text, flags, false);
 
     if (!found) {
         // Wrap around to end
-        m_editor->moveCursor(QTextCursor::End);
-        found = m_editor->find(text, flags);
+        found = find(text, flags, true);
         if (!found) QApplication::beep();
     }
 }
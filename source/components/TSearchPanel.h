@@ -6,6 +6,9 @@
 #include <QCheckBox>
 #include <QHBoxLayout>
 #include <QPlainTextEdit>
+#include <QTextDocument>
+
+class TLargeFileView;
 
 class SearchPanel : public QWidget {
     Q_OBJECT
@@ -21,6 +24,8 @@ public:
     // Set the editor that search operations apply to.
     // Called by Qalam whenever the active tab changes.
     void setEditor(QPlainTextEdit *editor);
+    // Same for a large file's read-only view; clears the editor.
+    void setLargeFileView(TLargeFileView *view);
 
 signals:
     void closed();
@@ -38,5 +43,10 @@ private:
     QCheckBox *checkCase;
     QCheckBox *checkWord;
 
+    // Runs a search on whichever target is set; `fromEdge` restarts at the
+    // start, or at the end when searching backward.
+    bool find(const QString &text, QTextDocument::FindFlags flags, bool fromEdge);
+
     QPlainTextEdit *m_editor{};
+    TLargeFileView *m_largeFileView{};
 };
@@ -0,0 +1,56 @@
+#include "FileLoader.h"
+#include "Constants.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QStringConverter>
+#include <QTextStream>
+
+FileLoader::FileLoader(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<FileLoadResult>();
+}
+
+FileLoader::~FileLoader()
+{
+    m_pool.waitForDone();
+}
+
+quint64 FileLoader::load(const QString &filePath)
+{
+    const quint64 requestId = ++m_lastRequestId;
+    m_pool.start([this, filePath, requestId]() {
+        FileLoadResult result = read(filePath);
+        result.requestId = requestId;
+        // The destructor waits for this task, so `this` is still alive.
+        QMetaObject::invokeMethod(this, [this, result = std::move(result)]() {
+            emit loaded(result);
+        }, Qt::QueuedConnection);
+    });
+    return requestId;
+}
+
+FileLoadResult FileLoader::read(const QString &filePath)
+{
+    FileLoadResult result;
+    result.filePath = filePath;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        result.errorString = file.errorString();
+        return result;
+    }
+
+    QTextStream in(&file);
+    in.setEncoding(QStringConverter::Utf8);
+    result.text = in.readAll();
+    file.close();
+
+    const QFileInfo backupInfo(filePath + Constants::BackupExtension);
+    if (backupInfo.exists()) {
+        result.hasBackup = true;
+        result.backupIsNewer = backupInfo.lastModified() > QFileInfo(filePath).lastModified();
+    }
+    return result;
+}
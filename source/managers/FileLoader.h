@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+/// Outcome of reading one file for an editor tab
+struct FileLoadResult {
+    quint64 requestId{};         ///< As returned by FileLoader::load()
+    QString filePath{};
+    QString text{};
+    QString errorString{};   ///< Empty on success
+    bool hasBackup{false};       ///< A `.~` auto-save backup exists next to the file
+    bool backupIsNewer{false};   ///< ...and was written after the file
+};
+
+Q_DECLARE_METATYPE(FileLoadResult)
+
+/**
+ * @brief Reads and decodes files on a thread pool so opening a tab never
+ *        blocks the GUI thread.
+ *
+ * Several loads run in parallel, e.g. when a session restores many tabs.
+ * Results are delivered through loaded() on the loader's own thread, in
+ * completion order.
+ */
+class FileLoader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FileLoader(QObject *parent = nullptr);
+    /// Waits for reads still running.
+    ~FileLoader() override;
+
+    /// Queue `filePath` for reading. Returns the id its result will carry,
+    /// so a file opened again while an older read is in flight can tell
+    /// the two results apart.
+    quint64 load(const QString &filePath);
+
+    /// Read and decode `filePath` on the calling thread.
+    static FileLoadResult read(const QString &filePath);
+
+signals:
+    void loaded(const FileLoadResult &result);
+
+private:
+    QThreadPool m_pool{};
+    quint64 m_lastRequestId{};
+};
@@ -18,7 +18,20 @@ FileManager::FileManager(QTabWidget *tabWidget, QWidget *parentWindow, QObject *
     : QObject(parent)
     , m_tabWidget(tabWidget)
     , m_parentWindow(parentWindow)
+    , m_loader(new FileLoader(this))
 {
+    connect(m_loader, &FileLoader::loaded, this, &FileManager::finishLoading);
+
+    // Restored tabs become real editors when first shown. Wait until the
+    // tab widget has finished switching, and skip tabs passed through on
+    // the way, e.g. while the session's active tab is selected.
+    connect(m_tabWidget, &QTabWidget::currentChanged, this, [this](int index) {
+        auto *placeholder = qobject_cast<TEditorPlaceholder*>(m_tabWidget->widget(index));
+        if (!placeholder) return;
+        QMetaObject::invokeMethod(this, [this, placeholder = QPointer<TEditorPlaceholder>(placeholder)]() {
+            if (placeholder and m_tabWidget->currentWidget() == placeholder) materialize(placeholder);
+        }, Qt::QueuedConnection);
+    });
 }
 
 TEditor *FileManager::currentEditor() const
@@ -169,74 +182,168 @@ void FileManager::openFile(QString filePath)
 
     // Check if file is already open in a tab
     for (int i = 0; i < m_tabWidget->count(); ++i) {
-        TEditor *editor = qobject_cast<TEditor*>(m_tabWidget->widget(i));
-        if (editor and normalizePath(editor->currentFilePath()) == normalizedPath) {
-            m_tabWidget->setCurrentIndex(i);
+        QWidget *tab = m_tabWidget->widget(i);
+        const QString tabPath = filePathOf(tab);
+        if (!tabPath.isEmpty() and normalizePath(tabPath) == normalizedPath) {
+            if (auto *placeholder = qobject_cast<TEditorPlaceholder*>(tab)) {
+                materialize(placeholder);
+            } else {
+                m_tabWidget->setCurrentIndex(i);
+            }
             return;
         }
     }
 
-    // File size safety check
-    constexpr qint64 WarnThreshold = 10 * 1024 * 1024;   // 10 MB
-    constexpr qint64 RejectThreshold = 50 * 1024 * 1024;  // 50 MB
-    QFileInfo fileCheck(normalizedPath);
-    qint64 fileSize = fileCheck.size();
-
-    if (fileSize > RejectThreshold) {
-        QMessageBox::warning(m_parentWindow, "ملف كبير جداً",
-            QString("حجم الملف (%1 MB) يتجاوز الحد المسموح (50 MB).\n"
-                    "لا يمكن فتح هذا الملف.")
-                .arg(fileSize / (1024 * 1024)));
-        return;
+    QWidget *tab = createFileTab(normalizedPath);
+    if (!tab) return;
+
+    QFileInfo fileInfo(normalizedPath);
+    const int index = m_tabWidget->addTab(tab, fileInfo.fileName());
+    m_tabWidget->setCurrentIndex(index);
+    m_tabWidget->setTabToolTip(index, qobject_cast<TLargeFileView*>(tab)
+                                          ? QString("%1\n(للقراءة فقط: ملف كبير)").arg(normalizedPath)
+                                          : normalizedPath);
+
+    addRecentFile(normalizedPath);
+
+    emit fileStateChanged();
+    emit openEditorsChanged();
+}
+
+void FileManager::restoreFiles(const QStringList &filePaths)
+{
+    for (const QString &filePath : filePaths) {
+        const QString normalizedPath = normalizePath(filePath);
+        if (normalizedPath.isEmpty()) continue;
+
+        bool alreadyOpen = false;
+        for (int i = 0; i < m_tabWidget->count() and !alreadyOpen; ++i) {
+            alreadyOpen = normalizePath(filePathOf(m_tabWidget->widget(i))) == normalizedPath;
+        }
+        if (alreadyOpen) continue;
+
+        auto *placeholder = new TEditorPlaceholder(normalizedPath, m_parentWindow);
+        const int index = m_tabWidget->addTab(placeholder, QFileInfo(normalizedPath).fileName());
+        m_tabWidget->setTabToolTip(index, normalizedPath);
     }
 
-    if (fileSize > WarnThreshold) {
-        auto reply = QMessageBox::question(m_parentWindow, "ملف كبير",
-            QString("حجم الملف (%1 MB) كبير وقد يؤثر على الأداء.\n"
-                    "هل تريد المتابعة؟")
-                .arg(fileSize / (1024 * 1024)),
-            QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
-        if (reply != QMessageBox::Yes) return;
+    emit fileStateChanged();
+    emit openEditorsChanged();
+}
+
+QString FileManager::filePathOf(QWidget *tab)
+{
+    if (auto *editor = qobject_cast<TEditor*>(tab)) return editor->currentFilePath();
+    if (auto *view = qobject_cast<TLargeFileView*>(tab)) return view->currentFilePath();
+    if (auto *placeholder = qobject_cast<TEditorPlaceholder*>(tab)) return placeholder->currentFilePath();
+    return QString();
+}
+
+QWidget *FileManager::createFileTab(const QString &filePath)
+{
+    // Files above the threshold are mapped into a read-only view instead of
+    // being loaded into an editor.
+    QSettings settings(Constants::OrgName, Constants::AppName);
+    const qint64 thresholdMB = settings.value(Constants::SettingsKeyLargeFileThreshold,
+                                              Constants::DefaultLargeFileThresholdMB).toLongLong();
+    if (QFileInfo(filePath).size() > thresholdMB * 1024 * 1024) {
+        auto *view = new TLargeFileView(m_parentWindow);
+        if (!view->openFile(filePath)) {
+            QMessageBox::warning(m_parentWindow, "خطأ",
+                                 "لا يمكن فتح الملف:\n" + view->errorString());
+            delete view;
+            return nullptr;
+        }
+        return view;
     }
 
-    QFile file(normalizedPath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    // The editor is read-only until the file, read and decoded off the GUI
+    // thread, lands in finishLoading().
+    TEditor *editor = createEditor(filePath);
+    editor->setLoading(true);
+    const quint64 requestId = m_loader->load(filePath);
+    m_loadingEditors.insert(requestId, editor);
+    // Closed before its text is in: a read still in flight finds no editor,
+    // even if the same file has been opened again meanwhile.
+    connect(editor, &QObject::destroyed, this, [this, requestId]() {
+        m_loadingEditors.remove(requestId);
+    });
+    return editor;
+}
+
+void FileManager::materialize(TEditorPlaceholder *placeholder)
+{
+    const int index = m_tabWidget->indexOf(placeholder);
+    if (index == -1) return;
+
+    QWidget *tab = createFileTab(placeholder->currentFilePath());
+    if (tab) {
+        // Insert first so the current tab moves straight to the new one.
+        m_tabWidget->insertTab(index, tab, m_tabWidget->tabText(index));
+        m_tabWidget->setTabToolTip(index, m_tabWidget->tabToolTip(index + 1));
+        m_tabWidget->setCurrentIndex(index);
+        m_tabWidget->removeTab(index + 1);
+    } else {
+        m_tabWidget->removeTab(index);
+    }
+    placeholder->deleteLater();
+
+    emit fileStateChanged();
+    emit openEditorsChanged();
+}
+
+void FileManager::finishLoading(const FileLoadResult &result)
+{
+    TEditor *newEditor = m_loadingEditors.value(result.requestId);
+    if (!newEditor) {
+        // The tab was closed while loading.
+        m_loadingEditors.remove(result.requestId);
+        return;
+    }
+
+    if (!result.errorString.isEmpty()) {
+        m_loadingEditors.remove(result.requestId);
+        const int index = m_tabWidget->indexOf(newEditor);
+        if (index != -1) m_tabWidget->removeTab(index);
+        newEditor->deleteLater();
         QMessageBox::warning(m_parentWindow, "خطأ",
-                             "لا يمكن فتح الملف:\n" + file.errorString());
+                             "لا يمكن فتح الملف:\n" + result.errorString);
+        emit fileStateChanged();
+        emit openEditorsChanged();
         return;
     }
 
-    QTextStream in(&file);
-    in.setEncoding(QStringConverter::Utf8);
-    QString content = in.readAll();
-    file.close();
+    // The text goes in over several event loop passes; the file counts as
+    // loading until the last one.
+    connect(newEditor, &TEditor::loadingFinished, this, [this, newEditor, result]() {
+        m_loadingEditors.remove(result.requestId);
+        offerBackup(newEditor, result);
+    }, Qt::SingleShotConnection);
+    newEditor->setLoadedText(result.text);
+}
 
-    TEditor *newEditor = createEditor(normalizedPath);
-    newEditor->setPlainText(content);
-    newEditor->document()->setModified(false);
+bool FileManager::hasPendingLoads() const
+{
+    return !m_loadingEditors.isEmpty();
+}
 
+void FileManager::offerBackup(TEditor *newEditor, const FileLoadResult &result)
+{
     // Check for backup recovery. Only prompt when the backup is newer than the file.
-    const QString backupPath = normalizedPath + Constants::BackupExtension;
-    if (QFile::exists(backupPath)) {
-        const QFileInfo sourceInfo(normalizedPath);
-        const QFileInfo backupInfo(backupPath);
-        const bool backupIsNewer = backupInfo.lastModified() > sourceInfo.lastModified();
-
-        if (backupIsNewer) {
+    const QString backupPath = result.filePath + Constants::BackupExtension;
+    if (result.hasBackup) {
+        if (result.backupIsNewer) {
             QMessageBox::StandardButton reply;
             reply = QMessageBox::warning(m_parentWindow, "استعادة ملف",
-                                         "يبدو أن البرنامج أُغلق بشكل غير متوقع.\n"
-                                         "يوجد نسخة محفوظة تلقائيًا أحدث من الملف الأصلي.\n\n"
-                                         "هل تريد استعادتها؟",
+                                         QString("يبدو أن البرنامج أُغلق بشكل غير متوقع.\n"
+                                                 "يوجد نسخة محفوظة تلقائيًا أحدث من الملف الأصلي:\n%1\n\n"
+                                                 "هل تريد استعادتها؟").arg(QFileInfo(result.filePath).fileName()),
                                          QMessageBox::Yes | QMessageBox::No);
             if (reply == QMessageBox::Yes) {
-                QFile backup(backupPath);
-                if (backup.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                    QTextStream backupIn(&backup);
-                    backupIn.setEncoding(QStringConverter::Utf8);
-                    newEditor->setPlainText(backupIn.readAll());
+                const FileLoadResult backup = FileLoader::read(backupPath);
+                if (backup.errorString.isEmpty()) {
+                    newEditor->setPlainText(backup.text);
                     newEditor->document()->setModified(true);
-                    backup.close();
                 }
             } else {
                 QFile::remove(backupPath);
@@ -245,24 +352,16 @@ void FileManager::openFile(QString filePath)
             QFile::remove(backupPath);
         }
     }
-
-    QFileInfo fileInfo(normalizedPath);
-    const int index = m_tabWidget->addTab(newEditor, fileInfo.fileName());
-    m_tabWidget->setCurrentIndex(index);
-    m_tabWidget->setTabToolTip(index, normalizedPath);
-
-    addRecentFile(normalizedPath);
-
-    emit fileStateChanged();
-    emit openEditorsChanged();
+    // A restored backup marks the document modified, which already
+    // notifies through modificationChanged.
 }
 
 bool FileManager::saveEditor(TEditor *editor)
 {
-    if (!editor) return false;
+    if (!editor or editor->isLoading()) return false;
 
     QString filePath = editor->currentFilePath();
-    QString content = editor->toPlainText();
+    const TDocumentSnapshot content = editor->snapshot();
 
     if (filePath.isEmpty()) {
         return saveEditorAs(editor);
@@ -278,7 +377,7 @@ bool FileManager::saveEditor(TEditor *editor)
 
     QTextStream out(&file);
     out.setEncoding(QStringConverter::Utf8);
-    out << content;
+    content.write(out);
 
     if (!file.commit()) {
         QMessageBox::warning(m_parentWindow, "خطأ",
@@ -298,6 +397,7 @@ bool FileManager::saveEditor(TEditor *editor)
 
     editor->removeBackupFile();
     addRecentFile(filePath);
+    emit fileSaved(filePath, content);
     emit fileStateChanged();
     emit openEditorsChanged();
     return true;
@@ -310,9 +410,9 @@ void FileManager::saveFile()
 
 bool FileManager::saveEditorAs(TEditor *editor)
 {
-    if (!editor) return false;
+    if (!editor or editor->isLoading()) return false;
 
-    QString content = editor->toPlainText();
+    const TDocumentSnapshot content = editor->snapshot();
     const QString oldPath = editor->currentFilePath();
     QString currentPath = oldPath;
     QString currentName = currentPath.isEmpty() ? "ملف جديد.baa" : QFileInfo(currentPath).fileName();
@@ -331,7 +431,7 @@ bool FileManager::saveEditorAs(TEditor *editor)
 
     QTextStream out(&file);
     out.setEncoding(QStringConverter::Utf8);
-    out << content;
+    content.write(out);
 
     if (!file.commit()) {
         QMessageBox::warning(m_parentWindow, "خطأ",
@@ -354,6 +454,7 @@ bool FileManager::saveEditorAs(TEditor *editor)
         removeBackupForPath(oldPath);
     }
     addRecentFile(normalizedPath);
+    emit fileSaved(normalizedPath, content);
     emit fileStateChanged();
     emit openEditorsChanged();
     return true;
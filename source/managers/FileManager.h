@@ -1,7 +1,12 @@
 #pragma once
 
 #include "TEditor.h"
+#include "TLargeFileView.h"
+#include "TEditorPlaceholder.h"
+#include "FileLoader.h"
 #include "Constants.h"
+#include <QHash>
+#include <QPointer>
 #include <QTabWidget>
 
 class FileManager : public QObject {
@@ -28,9 +33,18 @@ public:
     bool saveEditor(TEditor *editor);
     bool saveEditorAs(TEditor *editor);
 
+    /// File shown by an editor, large-file or placeholder tab; empty otherwise
+    static QString filePathOf(QWidget *tab);
+
+    /// True while some editor is still waiting for its file to be read
+    bool hasPendingLoads() const;
+
 public slots:
     void newFile();
     void openFile(QString filePath);
+    /// Add tabs for a restored session without reading any file; each
+    /// becomes an editor when first shown
+    void restoreFiles(const QStringList &filePaths);
     void saveFile();
     void saveFileAs();
 
@@ -39,14 +53,28 @@ signals:
     void fileStateChanged();
     /// Emitted when the set of open editors changes (tab added/removed)
     void openEditorsChanged();
+    /// Emitted after `filePath` was written with `content`
+    void fileSaved(const QString &filePath, const TDocumentSnapshot &content);
 
 private:
     TEditor *createEditor(const QString &filePath = QString());
+    /// Editor for `filePath` in its loading state, or a read-only
+    /// TLargeFileView above the large-file threshold; nullptr on error
+    QWidget *createFileTab(const QString &filePath);
+    /// Replace a restored placeholder tab with its editor and show it
+    void materialize(TEditorPlaceholder *placeholder);
     QString normalizePath(const QString &filePath) const;
     QString nextUntitledName() const;
     void removeBackupForPath(const QString &filePath) const;
     void addRecentFile(const QString &filePath);
+    /// Fill in an editor whose file was read by m_loader
+    void finishLoading(const FileLoadResult &result);
+    /// Once `newEditor` holds its file, restore or drop a leftover backup
+    void offerBackup(TEditor *newEditor, const FileLoadResult &result);
 
     QTabWidget *m_tabWidget{};
     QWidget *m_parentWindow{};
+    FileLoader *m_loader{};
+    /// Editors shown in a loading state, by the id of their FileLoader request
+    QHash<quint64, QPointer<TEditor>> m_loadingEditors{};
 };
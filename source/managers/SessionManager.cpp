@@ -1,5 +1,7 @@
 #include "SessionManager.h"
 #include "TExplorerView.h"
+#include "FileManager.h"
+#include "TEditorSettings.h"
 
 #include <QSettings>
 #include <QFileInfo>
@@ -17,12 +19,10 @@ void SessionManager::saveSession(const QString &folderPath, const QByteArray &wi
     // Collect file paths of all open tabs
     QStringList openFiles;
     for (int i = 0; i < m_tabWidget->count(); ++i) {
-        TEditor *editor = qobject_cast<TEditor*>(m_tabWidget->widget(i));
-        if (editor) {
-            QString filePath = editor->currentFilePath();
-            if (not filePath.isEmpty()) {
-                openFiles.append(filePath);
-            }
+        // Restored tabs never shown this run still belong to the session.
+        const QString filePath = FileManager::filePathOf(m_tabWidget->widget(i));
+        if (not filePath.isEmpty()) {
+            openFiles.append(filePath);
         }
     }
 
@@ -49,11 +49,7 @@ void SessionManager::savePreferences(TEditor *editor, int themeIndex)
 {
     if (not editor) return;
 
-    QSettings settings(Constants::OrgName, Constants::AppName);
-    settings.setValue(Constants::SettingsKeyFontSize, editor->font().pixelSize());
-    settings.setValue(Constants::SettingsKeyFontType, editor->font().family());
-    settings.setValue(Constants::SettingsKeyTheme, themeIndex);
-    settings.sync();
+    TEditorSettings::save(editor->font().pixelSize(), editor->font().family(), themeIndex);
 }
 
 void SessionManager::syncOpenEditors(TExplorerView *explorerView)
@@ -76,6 +72,8 @@ void SessionManager::syncOpenEditors(TExplorerView *explorerView)
                 }
             }
             explorerView->addOpenEditor(filePath, modified);
+        } else if (const QString filePath = FileManager::filePathOf(m_tabWidget->widget(i)); not filePath.isEmpty()) {
+            explorerView->addOpenEditor(filePath, false);
         }
     }
 }
@@ -1,5 +1,6 @@
 #include "TSettings.h"
 #include "../../qalam/Constants.h"
+#include "../texteditor/TEditorSettings.h"
 
 TSettings::TSettings(QWidget* parent) : QWidget(parent) {
     setWindowTitle("الإعدادات");
@@ -36,11 +37,7 @@ TSettings::TSettings(QWidget* parent) : QWidget(parent) {
 
 void TSettings::closeEvent(QCloseEvent* event) {
     Q_UNUSED(event)
-    QSettings settings(Constants::OrgName, Constants::AppName);
-    settings.setValue(Constants::SettingsKeyFontSize, fontSpin->value());
-    settings.setValue(Constants::SettingsKeyFontType, fontCombo->currentText());
-    settings.setValue(Constants::SettingsKeyTheme, themeCombo->currentIndex());
-    settings.sync();
+    TEditorSettings::save(fontSpin->value(), fontCombo->currentText(), themeCombo->currentIndex());
 
     // emit windowClosed();
     // event->accept();
@@ -5,22 +5,23 @@
 #include <QTextStream>
 #include <QStringConverter>
 #include "Constants.h"
+#include "TDocumentSnapshot.h"
+#include "TEditorScheduler.h"
 
 TAutoSave::TAutoSave(QPlainTextEdit *editor, QObject *parent)
     : QObject(parent), m_editor(editor) {
-    m_timer = new QTimer(this);
-    m_timer->setInterval(Constants::Timing::AutoSaveInterval);
-    connect(m_timer, &QTimer::timeout, this, &TAutoSave::performAutoSave);
 }
 
 void TAutoSave::start() {
-    if (!m_timer->isActive()) {
-        m_timer->start();
+    auto *scheduler = TEditorScheduler::instance();
+    if (!scheduler->isPending(this, TEditorScheduler::Task::AutoSave)) {
+        scheduler->schedule(this, TEditorScheduler::Task::AutoSave, Constants::Timing::AutoSaveInterval,
+                            [this]() { performAutoSave(); });
     }
 }
 
 void TAutoSave::stop() {
-    m_timer->stop();
+    TEditorScheduler::instance()->cancel(this, TEditorScheduler::Task::AutoSave);
 }
 
 void TAutoSave::onContentChanged() {
@@ -30,23 +31,31 @@ void TAutoSave::onContentChanged() {
 void TAutoSave::performAutoSave() {
     if (filePath.isEmpty() or !m_editor->document()->isModified()) return;
 
-    QString backupPath = filePath + Constants::BackupExtension;
-
-    QFile file(backupPath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&file);
-        out.setEncoding(QStringConverter::Utf8);
-        out << m_editor->toPlainText();
-        file.close();
-    }
+    // The write happens off the GUI thread, from a snapshot of the text.
+    const QString backupPath = filePath + Constants::BackupExtension;
+    const TDocumentSnapshot snapshot = TDocumentMirror::of(m_editor->document())->snapshot();
+    TEditorScheduler::instance()->runInBackground(this, TEditorScheduler::Task::AutoSave, [backupPath, snapshot]() {
+        QFile file(backupPath);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            QTextStream out(&file);
+            out.setEncoding(QStringConverter::Utf8);
+            snapshot.write(out);
+            file.close();
+        }
+        return std::function<void()>();
+    });
 }
 
 void TAutoSave::removeBackupFile() {
     if (filePath.isEmpty()) return;
-
-    QString backupPath = filePath + Constants::BackupExtension;
-    if (QFile::exists(backupPath)) {
-        QFile::remove(backupPath);
-    }
     stop();
+
+    // Queued behind any backup write still in flight.
+    const QString backupPath = filePath + Constants::BackupExtension;
+    TEditorScheduler::instance()->runInBackground(this, TEditorScheduler::Task::AutoSave, [backupPath]() {
+        if (QFile::exists(backupPath)) {
+            QFile::remove(backupPath);
+        }
+        return std::function<void()>();
+    });
 }
@@ -1,12 +1,13 @@
 #pragma once
 
 #include <QObject>
-#include <QTimer>
 
 class QPlainTextEdit;
 
 // Manages periodic auto-save of editor content to a backup file.
-// Extracted from TEditor to isolate file-backup concerns.
+// Extracted from TEditor to isolate file-backup concerns. The backup is
+// written AutoSaveInterval after the first unsaved change, through the
+// shared TEditorScheduler rather than a timer per editor.
 class TAutoSave : public QObject {
     Q_OBJECT
 
@@ -29,5 +30,4 @@ private slots:
 
 private:
     QPlainTextEdit *m_editor{};
-    QTimer *m_timer{};
 };
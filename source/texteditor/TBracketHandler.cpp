@@ -1,11 +1,13 @@
 #include "TBracketHandler.h"
+#include "TSyntaxHighlighter.h"
 
 TBracketHandler::TBracketHandler(QPlainTextEdit *editor) : m_editor(editor) {}
 
 bool TBracketHandler::handleAutoPairing(QKeyEvent *e) {
     QString text = e->text();
 
-    if (!text.isEmpty()) {
+    // Comments are free text: brackets and quotes are typed as-is.
+    if (!text.isEmpty() && !isInsideComment()) {
         QChar typedChar = text.at(0);
 
         // Handle opening brackets
@@ -111,3 +113,11 @@ bool TBracketHandler::handleBracketSkip(QChar typedChar) {
 
     return false;
 }
+
+bool TBracketHandler::isInsideComment() const {
+    if (!m_highlighter) return false;
+    const QTextCursor cursor = m_editor->textCursor();
+    const int column = cursor.positionInBlock();
+    if (column == 0) return false;
+    return m_highlighter->tokenAt(cursor.block(), column - 1).type == TokenType::Comment;
+}
@@ -3,6 +3,8 @@
 #include <QPlainTextEdit>
 #include <QKeyEvent>
 
+class TSyntaxHighlighter;
+
 // Handles bracket/quote auto-pairing and skip-over for TEditor.
 // Extracted from TEditor to reduce its size and isolate bracket logic.
 class TBracketHandler {
@@ -12,10 +14,15 @@ public:
     // Returns true if the key event was consumed (bracket/quote handled).
     bool handleAutoPairing(QKeyEvent *e);
 
+    // Source of cached tokens; without one, pairing applies everywhere.
+    void setHighlighter(TSyntaxHighlighter *highlighter) { m_highlighter = highlighter; }
+
 private:
     bool handleBracketCompletion(QChar openingBracket, QChar closingBracket);
     bool handleQuoteCompletion(QChar quoteChar);
     bool handleBracketSkip(QChar typedChar);
+    bool isInsideComment() const;
 
     QPlainTextEdit *m_editor{};
+    TSyntaxHighlighter *m_highlighter{};
 };
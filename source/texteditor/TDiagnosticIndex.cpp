@@ -0,0 +1,44 @@
+#include "TDiagnosticIndex.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+bool lineBefore(const TEditorDiagnostic &diagnostic, int line) {
+    return diagnostic.line < line;
+}
+
+bool lineAfter(int line, const TEditorDiagnostic &diagnostic) {
+    return line < diagnostic.line;
+}
+}
+
+void TDiagnosticIndex::setDiagnostics(const QVector<TEditorDiagnostic> &diagnostics) {
+    m_diagnostics = diagnostics;
+    // Out-of-range positions are shown on the first line and column.
+    for (TEditorDiagnostic &diagnostic : m_diagnostics) {
+        diagnostic.line = qMax(1, diagnostic.line);
+        diagnostic.column = qMax(1, diagnostic.column);
+    }
+    std::stable_sort(m_diagnostics.begin(), m_diagnostics.end(),
+                     [](const TEditorDiagnostic &a, const TEditorDiagnostic &b) {
+                         return a.line < b.line || (a.line == b.line && a.column < b.column);
+                     });
+}
+
+std::pair<TDiagnosticIndex::const_iterator, TDiagnosticIndex::const_iterator>
+TDiagnosticIndex::onLines(int firstLine, int lastLine) const {
+    const auto begin = std::lower_bound(m_diagnostics.cbegin(), m_diagnostics.cend(), firstLine, lineBefore);
+    const auto end = std::upper_bound(begin, m_diagnostics.cend(), lastLine, lineAfter);
+    return {begin, end};
+}
+
+const TEditorDiagnostic *TDiagnosticIndex::at(int line, int column) const {
+    const auto [begin, end] = onLines(line, line);
+    // Hover anywhere from two columns before a diagnostic on.
+    const auto after = std::upper_bound(begin, end, column + 2,
+                                        [](int reach, const TEditorDiagnostic &diagnostic) {
+                                            return reach < diagnostic.column;
+                                        });
+    return after == begin ? nullptr : &*std::prev(after);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <utility>
+
+// A build diagnostic as TEditor shows it; lines and columns are 1-based.
+struct TEditorDiagnostic {
+    QString file;
+    int line = 1;
+    int column = 1;
+    QString severity;
+    QString message;
+};
+
+// Diagnostics of one editor, sorted by line and column.
+// Extracted from TEditor so a cursor move or hover never walks every
+// diagnostic: decorations are built only for the lines in view, and hover
+// lookups are binary searches.
+class TDiagnosticIndex {
+public:
+    using const_iterator = QVector<TEditorDiagnostic>::const_iterator;
+
+    void setDiagnostics(const QVector<TEditorDiagnostic> &diagnostics);
+    void clear() { m_diagnostics.clear(); }
+    bool isEmpty() const { return m_diagnostics.isEmpty(); }
+    qsizetype size() const { return m_diagnostics.size(); }
+
+    // Diagnostics on lines [firstLine, lastLine], in line and column order.
+    std::pair<const_iterator, const_iterator> onLines(int firstLine, int lastLine) const;
+
+    // The diagnostic closest before `column` on `line`, allowing it to start
+    // up to two columns to the right; nullptr if the line has none in reach.
+    const TEditorDiagnostic *at(int line, int column) const;
+
+private:
+    QVector<TEditorDiagnostic> m_diagnostics{};
+};
@@ -0,0 +1,172 @@
+#include "TDocumentSnapshot.h"
+
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+// Block text as QTextDocument::toPlainText() spells it, so saved files do
+// not change with the switch to snapshots.
+QString plainText(const QTextBlock &block) {
+    QString text = block.text();
+    const auto special = [](QChar ch) {
+        return ch == QChar::Nbsp or ch == QChar::LineSeparator or ch == QChar::ParagraphSeparator;
+    };
+    if (std::any_of(text.cbegin(), text.cend(), special)) {
+        for (QChar &ch : text) {
+            if (ch == QChar::Nbsp) ch = QLatin1Char(' ');
+            else if (special(ch)) ch = QLatin1Char('\n');
+        }
+    }
+    return text;
+}
+}
+
+const QString &TDocumentSnapshot::line(int index) const {
+    const int chunk = chunkAt(index);
+    return m_chunks[chunk]->at(index - m_chunkStarts[chunk]);
+}
+
+QString TDocumentSnapshot::toPlainText() const {
+    QString text;
+    text.reserve(length());
+    bool first = true;
+    forEachLine([&](const QString &line) {
+        if (!first) text += QLatin1Char('\n');
+        text += line;
+        first = false;
+    });
+    return text;
+}
+
+void TDocumentSnapshot::write(QTextStream &out) const {
+    bool first = true;
+    forEachLine([&](const QString &line) {
+        if (!first) out << '\n';
+        out << line;
+        first = false;
+    });
+}
+
+int TDocumentSnapshot::chunkAt(int line) const {
+    const auto it = std::upper_bound(m_chunkStarts.cbegin(), m_chunkStarts.cend(), line);
+    return std::clamp(int(it - m_chunkStarts.cbegin()) - 1, 0, int(m_chunks.size()) - 1);
+}
+
+void TDocumentSnapshot::replaceLines(int first, int count, QList<QString> lines) {
+    for (int i = first; i < first + count; ++i) m_charCount -= line(i).size();
+    for (const QString &text : std::as_const(lines)) m_charCount += text.size();
+    m_lineCount += int(lines.size()) - count;
+
+    // Rebuild the chunks the range touches from their untouched head and
+    // tail plus the new lines; every other chunk is kept as is.
+    int firstChunk = 0;
+    int endChunk = 0;
+    QList<QString> merged;
+    if (m_chunks.isEmpty()) {
+        merged = std::move(lines);
+    } else {
+        firstChunk = chunkAt(first);
+        const int lastChunk = count > 0 ? chunkAt(first + count - 1) : firstChunk;
+        endChunk = lastChunk + 1;
+
+        const QList<QString> &head = *m_chunks[firstChunk];
+        const QList<QString> &tail = *m_chunks[lastChunk];
+        const int tailFrom = first + count - m_chunkStarts[lastChunk];
+        merged.reserve(first - m_chunkStarts[firstChunk] + lines.size() + tail.size() - tailFrom);
+        merged.append(head.first(first - m_chunkStarts[firstChunk]));
+        merged.append(std::move(lines));
+        merged.append(tail.sliced(tailFrom));
+
+        // Absorb a neighbour rather than leave a run of tiny chunks behind
+        // repeated deletions.
+        if (merged.size() < MinChunkLines && endChunk < m_chunks.size()) {
+            merged.append(*m_chunks[endChunk]);
+            ++endChunk;
+        }
+    }
+
+    const qsizetype parts = (merged.size() + ChunkLines - 1) / ChunkLines;
+    QList<Chunk> chunks;
+    chunks.reserve(m_chunks.size() - (endChunk - firstChunk) + parts);
+    chunks.append(m_chunks.first(firstChunk));
+    for (qsizetype part = 0; part < parts; ++part) {
+        const qsizetype from = merged.size() * part / parts;
+        const qsizetype to = merged.size() * (part + 1) / parts;
+        chunks.append(std::make_shared<const QList<QString>>(merged.sliced(from, to - from)));
+    }
+    chunks.append(m_chunks.sliced(endChunk));
+    m_chunks = std::move(chunks);
+    updateChunkStarts(firstChunk);
+}
+
+void TDocumentSnapshot::updateChunkStarts(int fromChunk) {
+    m_chunkStarts.resize(m_chunks.size());
+    for (int k = fromChunk; k < m_chunks.size(); ++k) {
+        m_chunkStarts[k] = k == 0 ? 0 : m_chunkStarts[k - 1] + int(m_chunks[k - 1]->size());
+    }
+}
+
+TDocumentMirror *TDocumentMirror::of(QTextDocument *document) {
+    if (auto *mirror = document->findChild<TDocumentMirror*>(QString(), Qt::FindDirectChildrenOnly)) return mirror;
+    return new TDocumentMirror(document);
+}
+
+TDocumentMirror::TDocumentMirror(QTextDocument *document)
+    : QObject(document), m_document(document) {
+    connect(document, &QTextDocument::contentsChange, this, &TDocumentMirror::onContentsChange);
+    reset();
+}
+
+void TDocumentMirror::onContentsChange(int position, int charsRemoved, int charsAdded) {
+    Q_UNUSED(charsRemoved)
+    // The change spans these blocks now; the block count delta says how
+    // many it spanned before.
+    QTextBlock firstBlock = m_document->findBlock(position);
+    QTextBlock lastBlock = m_document->findBlock(position + charsAdded);
+    if (!firstBlock.isValid()) firstBlock = m_document->lastBlock();
+    if (!lastBlock.isValid()) lastBlock = m_document->lastBlock();
+    const int first = firstBlock.blockNumber();
+    const int oldLast = lastBlock.blockNumber() - (m_document->blockCount() - m_snapshot.lineCount());
+    if (oldLast < first or oldLast >= m_snapshot.lineCount()) {
+        const TDocumentSnapshot before = m_snapshot;
+        ++m_snapshot.m_revision;
+        reset();
+        emit linesReplaced(before, 0, before.lineCount(), m_snapshot.lineCount());
+        return;
+    }
+
+    QList<QString> lines;
+    lines.reserve(lastBlock.blockNumber() - first + 1);
+    for (QTextBlock block = firstBlock; block.isValid(); block = block.next()) {
+        lines.append(plainText(block));
+        if (block == lastBlock) break;
+    }
+
+    // The highlighter and fold engine report restyled blocks the same way
+    // as edits; those leave the text and the revision alone.
+    if (lines.size() == oldLast - first + 1) {
+        bool same = true;
+        for (int i = 0; same and i < lines.size(); ++i) same = lines[i] == m_snapshot.line(first + i);
+        if (same) return;
+    }
+    const TDocumentSnapshot before = m_snapshot;
+    const int added = int(lines.size());
+    ++m_snapshot.m_revision;
+    m_snapshot.replaceLines(first, oldLast - first + 1, std::move(lines));
+    emit linesReplaced(before, first, oldLast - first + 1, added);
+}
+
+void TDocumentMirror::reset() {
+    QList<QString> lines;
+    lines.reserve(m_document->blockCount());
+    for (QTextBlock block = m_document->begin(); block.isValid(); block = block.next()) {
+        lines.append(plainText(block));
+    }
+
+    const quint64 revision = m_snapshot.m_revision;
+    m_snapshot = TDocumentSnapshot();
+    m_snapshot.replaceLines(0, 0, std::move(lines));
+    m_snapshot.m_revision = revision;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <memory>
+
+class QTextDocument;
+class QTextStream;
+
+// Immutable copy of a document's text, safe to hand to another thread.
+//
+// Lines are kept in chunks of about ChunkLines implicitly shared QStrings,
+// each chunk behind a shared_ptr. Copying a snapshot copies the chunk list
+// only, and an edit replaces just the chunk it touches, so consecutive
+// snapshots share everything else.
+class TDocumentSnapshot {
+public:
+    // Lines, i.e. QTextDocument blocks; zero only for a default snapshot.
+    int lineCount() const { return m_lineCount; }
+    const QString &line(int index) const;
+    // Characters of the joined text, line breaks included.
+    qsizetype length() const { return m_lineCount ? m_charCount + m_lineCount - 1 : 0; }
+    // Number of edits the document had seen when this was taken.
+    quint64 revision() const { return m_revision; }
+
+    // The lines joined with '\n', like QPlainTextEdit::toPlainText().
+    QString toPlainText() const;
+    // Streams the joined text without building it in memory.
+    void write(QTextStream &out) const;
+
+    template <typename Function>
+    void forEachLine(Function &&function) const {
+        for (const auto &chunk : m_chunks) {
+            for (const QString &text : *chunk) function(text);
+        }
+    }
+
+private:
+    friend class TDocumentMirror;
+    using Chunk = std::shared_ptr<const QList<QString>>;
+
+    static constexpr int ChunkLines = 256;
+    static constexpr int MinChunkLines = ChunkLines / 4;
+
+    int chunkAt(int line) const;
+    // Replaces lines [first, first + count) with `lines`.
+    void replaceLines(int first, int count, QList<QString> lines);
+    void updateChunkStarts(int fromChunk);
+
+    QList<Chunk> m_chunks{};
+    // m_chunkStarts[k] is the first line of m_chunks[k].
+    QList<int> m_chunkStarts{};
+    int m_lineCount{};
+    // Characters of all lines, line breaks excluded.
+    qsizetype m_charCount{};
+    quint64 m_revision{};
+};
+
+// Follows a QTextDocument's contentsChange and keeps a TDocumentSnapshot of
+// it current, re-reading only the blocks each change touched. Lives as a
+// child of the document; of() creates it on first use.
+class TDocumentMirror : public QObject {
+    Q_OBJECT
+public:
+    static TDocumentMirror *of(QTextDocument *document);
+
+    TDocumentSnapshot snapshot() const { return m_snapshot; }
+
+signals:
+    // Lines [first, first + removed) of `before` are now lines
+    // [first, first + added) of snapshot(). Restyling emits nothing.
+    void linesReplaced(const TDocumentSnapshot &before, int first, int removed, int added);
+
+private:
+    explicit TDocumentMirror(QTextDocument *document);
+
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void reset();
+
+    QTextDocument *m_document{};
+    TDocumentSnapshot m_snapshot{};
+};
@@ -4,7 +4,6 @@
 #include <QTextBlock>
 #include <QScrollBar>
 #include <QMimeData>
-#include <QSettings>
 #include <QPainterPath>
 #include <QMenu>
 #include <QAction>
@@ -12,9 +11,12 @@
 #include <QUrl>
 #include <QHash>
 #include <QToolTip>
+#include <QElapsedTimer>
+#include <algorithm>
 #include "Constants.h"
 #include "highlighter/ThemeManager.h"
-#include "highlighter/TSyntaxDefinition.h"
+#include "TEditorSettings.h"
+#include "TEditorScheduler.h"
 #include <QTextCharFormat>
 #include "ui/QalamTheme.h"
 
@@ -24,13 +26,17 @@ bool isCompletionCharacter(QChar ch)
 {
     return ch.isLetterOrNumber() || ch == '_' || ch == '#';
 }
+
+// Most text setLoadedText() appends at once; slices end after a line break.
+constexpr qsizetype LoadChunkChars = 1 << 16;
 }
 
 
 TEditor::TEditor(QWidget* parent)
     : QPlainTextEdit(parent),
       m_bracketHandler(this),
-      m_snippetManager(this) {
+      m_snippetManager(this),
+      m_multiCursor(this) {
     setAcceptDrops(true);
     setMouseTracking(true);
     this->setStyleSheet(QalamTheme::editorStyleSheet());
@@ -43,7 +49,10 @@ TEditor::TEditor(QWidget* parent)
     editorDocument->setDefaultTextOption(option);
 
 
+    // Follows every edit, so snapshot() never has to copy the whole text.
+    TDocumentMirror::of(editorDocument);
     highlighter = new TSyntaxHighlighter(editorDocument);
+    m_bracketHandler.setHighlighter(highlighter);
     lineNumberArea = new LineNumberArea(this);
 
     // ضبط الإكمال التلقائي
@@ -52,57 +61,24 @@ TEditor::TEditor(QWidget* parent)
     connect(this, &TEditor::blockCountChanged, this, &TEditor::updateLineNumberAreaWidth);
     connect(this, &TEditor::updateRequest, this, &TEditor::updateLineNumberArea);
     connect(this, &TEditor::cursorPositionChanged, this, &TEditor::highlightCurrentLine);
-    connect(this->document(), &QTextDocument::contentsChanged, this, &TEditor::updateFoldRegions);
+    m_foldEngine = std::make_unique<TFoldEngine>(editorDocument, highlighter);
+    connect(m_foldEngine.get(), &TFoldEngine::regionsChanged, this, [this]() {
+        updateGutterBand();
+        viewport()->update();
+    });
 
     updateLineNumberAreaWidth();
     highlightCurrentLine();
 
-    // set saved setting font size to the editor
-    QSettings settingsVal(Constants::OrgName, Constants::AppName);
-    int savedSize = settingsVal.value(Constants::SettingsKeyFontSize).toInt();
-    updateFontSize(savedSize);
-    // set saved setting font type to the editor
-    QString savedFont = settingsVal.value(Constants::SettingsKeyFontType).toString();
-    updateFontType(savedFont);
-    // set saved setting theme to the editor
-    int savedThemeIdx = settingsVal.value(Constants::SettingsKeyTheme).toInt();
-    if (savedThemeIdx < 0) savedThemeIdx = 0;
-    auto theme = ThemeManager::getThemeByIndex(savedThemeIdx);
-    updateHighlighterTheme(theme);
+    // Font and theme come from the process-wide settings snapshot.
+    const TEditorSettings &settings = TEditorSettings::current();
+    updateFontSize(settings.fontSize);
+    updateFontType(settings.fontFamily);
+    updateHighlighterTheme(ThemeManager::getThemeByIndex(settings.themeIndex));
 
     // Auto-save (delegated to TAutoSave helper)
     m_autoSave = new TAutoSave(this, this);
     connect(this->document(), &QTextDocument::contentsChanged, m_autoSave, &TAutoSave::onContentChanged);
-    
-    // Initial index build
-    if (dynamicStrategy) {
-        dynamicStrategy->rebuildIndex(this->toPlainText());
-    }
-    
-    // Debounced timer to rebuild word index when text is deleted
-    // (so the index shrinks and doesn't grow forever)
-    m_indexRebuildTimer = new QTimer(this);
-    m_indexRebuildTimer->setSingleShot(true);
-    m_indexRebuildTimer->setInterval(2000); // 2 seconds after last deletion
-    connect(m_indexRebuildTimer, &QTimer::timeout, this, [this]() {
-        if (dynamicStrategy) {
-            dynamicStrategy->rebuildIndex(this->toPlainText());
-        }
-    });
-
-    // Connect document changes to update the autocomplete index
-    connect(this->document(), &QTextDocument::contentsChange, this, [this](int position, int charsRemoved, int charsAdded) {
-        if (dynamicStrategy && charsAdded > 0) {
-            QTextCursor cursor(this->document());
-            cursor.setPosition(position);
-            cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, charsAdded);
-            dynamicStrategy->updateIndex(cursor.selectedText());
-        }
-        // Schedule a full rebuild when text is deleted so stale words are pruned
-        if (dynamicStrategy && charsRemoved > 0) {
-            m_indexRebuildTimer->start();
-        }
-    });
 
     installEventFilter(this);
 }
@@ -154,15 +130,66 @@ void TEditor::setFilePath(const QString &path) {
     }
 }
 
+void TEditor::setLoading(bool loading) {
+    if (m_loading == loading) return;
+    m_loading = loading;
+    setReadOnly(loading);
+    setPlaceholderText(loading ? QStringLiteral("جارٍ تحميل الملف...") : QString());
+    m_multiCursor.clear();
+    if (loading) return;
+
+    // Diagnostics may have arrived while the document was still empty.
+    const auto [first, last] = visibleBlockRange();
+    updateDiagnosticSelections(first, last, true);
+    emit loadingFinished();
+}
+
+void TEditor::setLoadedText(const QString &text) {
+    // Loading is not an edit anyone should undo.
+    document()->setUndoRedoEnabled(false);
+    appendLoadedText(text, 0);
+}
+
+void TEditor::appendLoadedText(const QString &text, qsizetype from) {
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (from < text.size() && !elapsed.hasExpired(Constants::Timing::LoadSliceBudget)) {
+        qsizetype to = std::min(from + LoadChunkChars, text.size());
+        if (to < text.size()) {
+            const qsizetype lineBreak = text.lastIndexOf(QLatin1Char('\n'), to - 1);
+            if (lineBreak >= from) {
+                to = lineBreak + 1;
+            } else if (text.at(to - 1).isHighSurrogate()) {
+                --to;
+            }
+        }
+        cursor.insertText(text.mid(from, to - from));
+        from = to;
+    }
+    // Appending is not a change to the file; keeps the tab title clean.
+    document()->setModified(false);
+
+    if (from < text.size()) {
+        TEditorScheduler::instance()->schedule(this, TEditorScheduler::Task::Load, 0,
+                                               [this, text, from]() { appendLoadedText(text, from); });
+        return;
+    }
+    document()->setUndoRedoEnabled(true);
+    setLoading(false);
+}
+
 void TEditor::setDiagnostics(const QVector<Diagnostic> &diagnostics) {
-    m_diagnostics = diagnostics;
-    applyEditorDecorations();
+    m_diagnosticIndex.setDiagnostics(diagnostics);
+    const auto [first, last] = visibleBlockRange();
+    updateDiagnosticSelections(first, last, true);
     viewport()->update();
 }
 
 void TEditor::clearDiagnostics() {
-    m_diagnostics.clear();
-    applyEditorDecorations();
+    m_diagnosticIndex.clear();
+    updateDiagnosticSelections(0, -1, true);
     viewport()->update();
 }
 
@@ -191,31 +218,15 @@ void TEditor::updateFontType(QString font) {
 // 1. دالة تعليق/إلغاء تعليق الأكواد
 void TEditor::toggleComment()
 {
-    QTextCursor cursor = textCursor();
-    cursor.beginEditBlock(); // لبدء عملية تراجع (Undo) واحدة
-
-    int startPos = cursor.selectionStart();
-    int endPos = cursor.selectionEnd();
-
-    // تحديد بداية ونهاية الأسطر المحددة
-    cursor.setPosition(startPos);
-    int startBlock = cursor.blockNumber();
-    cursor.setPosition(endPos, QTextCursor::KeepAnchor);
-    int endBlock = cursor.blockNumber();
-
-    if (cursor.atBlockStart() && endBlock > startBlock) {
-        endBlock--;
-    }
+    const QList<QTextBlock> blocks = cursorBlocks();
+    if (blocks.isEmpty()) return;
 
-    bool shouldComment = false;
+    const bool shouldComment = !blocks.first().text().trimmed().startsWith("//");
 
-    QTextBlock block = document()->findBlockByNumber(startBlock);
-    if (!block.text().trimmed().startsWith("//")) {
-        shouldComment = true;
-    }
+    QTextCursor cursor = textCursor();
+    cursor.beginEditBlock(); // لبدء عملية تراجع (Undo) واحدة
 
-    for (int i = startBlock; i <= endBlock; ++i) {
-        block = document()->findBlockByNumber(i);
+    for (const QTextBlock &block : blocks) {
         QTextCursor lineCursor(block);
 
         if (shouldComment) {
@@ -245,20 +256,70 @@ void TEditor::toggleComment()
 
 void TEditor::duplicateLine()
 {
+    const QList<QTextBlock> blocks = cursorBlocks();
+
     QTextCursor cursor = textCursor();
     cursor.beginEditBlock();
 
-    QString lineText = cursor.block().text();
+    for (const QTextBlock &block : blocks) {
+        QTextCursor lineCursor(block);
+        lineCursor.movePosition(QTextCursor::EndOfBlock);
+        lineCursor.insertText("\n" + block.text());
+    }
+
+    cursor.endEditBlock();
+}
 
-    cursor.movePosition(QTextCursor::EndOfBlock);
+QList<QTextBlock> TEditor::cursorBlocks() const {
+    QList<QTextBlock> blocks;
+    for (const QTextCursor &cursor : m_multiCursor.cursors()) {
+        QTextBlock block = document()->findBlock(cursor.selectionStart());
+        QTextBlock last = document()->findBlock(cursor.selectionEnd());
+        // A selection ending at the start of a line leaves that line out.
+        if (cursor.hasSelection() and last != block and last.position() == cursor.selectionEnd()) {
+            last = last.previous();
+        }
+        if (!blocks.isEmpty() and block.blockNumber() <= blocks.last().blockNumber()) {
+            block = blocks.last().next();
+        }
+        for (; block.isValid() and block.blockNumber() <= last.blockNumber(); block = block.next()) {
+            blocks.append(block);
+        }
+    }
+    return blocks;
+}
 
-    cursor.insertText("\n" + lineText);
+void TEditor::addNextOccurrence() {
+    m_multiCursor.addNextOccurrence();
+    multiCursorChanged();
+}
 
-    cursor.endEditBlock();
+void TEditor::selectAllOccurrences() {
+    m_multiCursor.selectAllOccurrences();
+    multiCursorChanged();
+}
+
+void TEditor::addCursorAbove() {
+    m_multiCursor.addCursorVertically(-1);
+    multiCursorChanged();
+}
+
+void TEditor::addCursorBelow() {
+    m_multiCursor.addCursorVertically(1);
+    multiCursorChanged();
+}
+
+void TEditor::multiCursorChanged() {
+    applyEditorDecorations();
+    viewport()->update();
 }
 
 void TEditor::moveLineUp()
 {
+    if (m_multiCursor.isActive()) {
+        m_multiCursor.clear();
+        multiCursorChanged();
+    }
     QTextCursor cursor = textCursor();
     const QTextBlock currentBlock = cursor.block();
     const QTextBlock prevBlock = currentBlock.previous();
@@ -286,6 +347,10 @@ void TEditor::moveLineUp()
 
 void TEditor::moveLineDown()
 {
+    if (m_multiCursor.isActive()) {
+        m_multiCursor.clear();
+        multiCursorChanged();
+    }
     QTextCursor cursor = textCursor();
     const QTextBlock currentBlock = cursor.block();
     const QTextBlock nextBlock = currentBlock.next();
@@ -319,6 +384,7 @@ bool TEditor::eventFilter(QObject* obj, QEvent* event) {
              or keyEvent->key() == Qt::Key_Enter) {
             if ((c and c->popup() and c->popup()->isVisible())
                 or m_snippetManager.hasActiveSnippet()
+                or m_multiCursor.isActive()
                 or (keyEvent->modifiers() & (Qt::ControlModifier | Qt::AltModifier | Qt::MetaModifier))) {
                 return false;
             }
@@ -346,6 +412,11 @@ void TEditor::contextMenuEvent(QContextMenuEvent *event)
     connect(duplicateAction, &QAction::triggered, this, &TEditor::duplicateLine);
     menu->addAction(duplicateAction);
 
+    QAction *allOccurrencesAction = new QAction("تحديد كل التكرارات", this);
+    allOccurrencesAction->setShortcut(QKeySequence("Ctrl+Shift+L"));
+    connect(allOccurrencesAction, &QAction::triggered, this, &TEditor::selectAllOccurrences);
+    menu->addAction(allOccurrencesAction);
+
 
     menu->setStyleSheet(QString(
         "QMenu { background-color: %1; color: %2; border: 1px solid %3; }"
@@ -386,13 +457,41 @@ void TEditor::updateLineNumberAreaWidth() {
 }
 
 void TEditor::updateLineNumberArea(const QRect &rect, int dy) {
-    if (dy)
+    if (dy) {
         lineNumberArea->scroll(0, dy);
-    else
-        lineNumberArea->update(0, rect.y(), lineNumberArea->width(), rect.height());
+        m_gutterRenderer.scroll(dy);
+    } else {
+        // Cursor blinks and edits within a line leave the gutter as it is.
+        updateGutterBand();
+    }
 
     if (rect.contains(viewport()->rect()))
         updateLineNumberAreaWidth();
+
+    updateVisibleBlocks();
+}
+
+std::pair<int, int> TEditor::visibleBlockRange() const {
+    QTextBlock block = firstVisibleBlock();
+    if (!block.isValid()) return {0, -1};
+
+    const int first = block.blockNumber();
+    int last = first;
+    qreal top = blockBoundingGeometry(block).translated(contentOffset()).top();
+    const int bottom = viewport()->height();
+    while (block.isValid() && top <= bottom) {
+        last = block.blockNumber();
+        top += blockBoundingRect(block).height();
+        block = block.next();
+    }
+    return {first, last};
+}
+
+void TEditor::updateVisibleBlocks() {
+    const auto [first, last] = visibleBlockRange();
+    if (last < first) return;
+    highlighter->setVisibleBlocks(first, last);
+    updateDiagnosticSelections(first, last);
 }
 
 void TEditor::resizeEvent(QResizeEvent* event) {
@@ -403,55 +502,49 @@ void TEditor::resizeEvent(QResizeEvent* event) {
 
 
     lineNumberArea->setGeometry(this->width() - numsWidth, cr.top(), numsWidth, cr.height());
+    updateVisibleBlocks();
 }
 
 void TEditor::lineNumberAreaPaintEvent(QPaintEvent* event) {
-
     QPainter painter(lineNumberArea);
-    painter.fillRect(event->rect(), Qt::transparent);
-
-        QTextBlock block = firstVisibleBlock();
-        int blockNumber = block.blockNumber();
-        int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
-        int bottom = top + qRound(blockBoundingRect(block).height());
-
-    while (block.isValid() && top <= event->rect().bottom()) {
-        if (block.isVisible() && bottom >= event->rect().top()) {
-            QString number = QString::number(blockNumber + 1);
-
-            painter.setPen(QColor(Constants::Colors::TextMuted));
-
-            painter.drawText(12, top, lineNumberArea->width(), fontMetrics().height(),
-                                     Qt::AlignRight | Qt::AlignVCenter, number);
-
-            for (const auto& region : foldRegions) {
-                if (region.startBlockNumber == blockNumber) {
-                    bool folded = region.folded;
-
-                    QPolygon arrow;
-                    int midY = top + fontMetrics().height() / 2;
-                    if (folded) {
-                        arrow << QPoint(lineNumberArea->width() - 10, midY - 4)
-                        << QPoint(lineNumberArea->width() - 2, midY)
-                        << QPoint(lineNumberArea->width() - 10, midY + 4);
-                    } else {
-                        arrow << QPoint(lineNumberArea->width() - 10, midY - 4)
-                        << QPoint(lineNumberArea->width() - 2, midY - 4)
-                        << QPoint(lineNumberArea->width() - 6, midY + 4);
-                    }
-
-                    painter.setBrush(QColor(Constants::Colors::Accent));
-                    painter.setPen(Qt::NoPen);
-                    painter.drawPolygon(arrow);
-                }
+    m_gutterRenderer.paint(painter, event->rect(), lineNumberArea->width(), fontMetrics().height(), gutterRows());
+}
+
+QVector<TGutterRenderer::Row> TEditor::gutterRows() const {
+    QVector<TGutterRenderer::Row> rows;
+    QTextBlock block = firstVisibleBlock();
+    if (!block.isValid()) return rows;
+
+    int blockNumber = block.blockNumber();
+    int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
+    const int bottom = lineNumberArea->height();
+
+    // Fold markers come from one walk over the regions headed in view.
+    const QVector<TFoldEngine::Region>& regions = m_foldEngine->regions();
+    auto region = std::lower_bound(regions.cbegin(), regions.cend(), blockNumber,
+                                   [](const TFoldEngine::Region& r, int number) { return r.start < number; });
+
+    while (block.isValid() && top <= bottom) {
+        const int height = qRound(blockBoundingRect(block).height());
+        if (block.isVisible()) {
+            while (region != regions.cend() && region->start < blockNumber) ++region;
+            TGutterRenderer::Marker marker = TGutterRenderer::Marker::None;
+            if (region != regions.cend() && region->start == blockNumber && region->end > region->start) {
+                marker = region->folded ? TGutterRenderer::Marker::Folded : TGutterRenderer::Marker::Expanded;
             }
+            rows.append({blockNumber, top, height, marker});
         }
 
         block = block.next();
-        top = bottom;
-        bottom = top + static_cast<int>(blockBoundingRect(block).height());
+        top += height;
         ++blockNumber;
     }
+    return rows;
+}
+
+void TEditor::updateGutterBand() {
+    const QRect band = m_gutterRenderer.dirtyBand(gutterRows(), lineNumberArea->rect());
+    if (!band.isEmpty()) lineNumberArea->update(band);
 }
 
 void TEditor::highlightCurrentLine() {
@@ -460,6 +553,7 @@ void TEditor::highlightCurrentLine() {
 
 void TEditor::applyEditorDecorations() {
     QList<QTextEdit::ExtraSelection> extraSelections;
+    extraSelections.reserve(m_diagnosticSelections.size() + m_multiCursor.extraCursors().size() + 1);
 
     if (!isReadOnly()) {
         QTextEdit::ExtraSelection selection;
@@ -471,12 +565,46 @@ void TEditor::applyEditorDecorations() {
         extraSelections.append(selection);
     }
 
-    for (const Diagnostic &diagnostic : m_diagnostics) {
-        const QTextBlock block = document()->findBlockByNumber(qMax(1, diagnostic.line) - 1);
-        if (!block.isValid()) continue;
+    for (const QTextCursor &cursor : m_multiCursor.extraCursors()) {
+        if (!cursor.hasSelection()) continue;
+        QTextEdit::ExtraSelection selection;
+        selection.format.setBackground(palette().color(QPalette::Highlight));
+        selection.format.setForeground(palette().color(QPalette::HighlightedText));
+        selection.cursor = cursor;
+        extraSelections.append(selection);
+    }
+
+    // Already materialized for the viewport; a cursor move only replaces
+    // the current-line highlight.
+    extraSelections += m_diagnosticSelections;
+    setExtraSelections(extraSelections);
+}
+
+void TEditor::updateDiagnosticSelections(int first, int last, bool force) {
+    if (!force && (m_diagnosticIndex.isEmpty() || (first >= m_decoratedFrom && last <= m_decoratedTo))) return;
+
+    m_diagnosticSelections.clear();
+    if (m_diagnosticIndex.isEmpty() || last < first) {
+        m_decoratedFrom = 0;
+        m_decoratedTo = -1;
+        applyEditorDecorations();
+        return;
+    }
+
+    const int page = last - first + 1;
+    m_decoratedFrom = qMax(0, first - page);
+    m_decoratedTo = last + page;
+
+    const auto [begin, end] = m_diagnosticIndex.onLines(m_decoratedFrom + 1, m_decoratedTo + 1);
+    QTextBlock block = document()->findBlockByNumber(m_decoratedFrom);
+    int blockNumber = m_decoratedFrom;
+    for (auto diagnostic = begin; diagnostic != end; ++diagnostic) {
+        // Diagnostics come in line order, so blocks are walked once.
+        for (; block.isValid() && blockNumber < diagnostic->line - 1; ++blockNumber) block = block.next();
+        if (!block.isValid()) break;
 
         QTextCursor cursor(block);
-        const int columnOffset = qMax(0, diagnostic.column - 1);
+        const int columnOffset = diagnostic->column - 1;
         cursor.setPosition(qMin(block.position() + columnOffset, block.position() + block.length() - 1));
 
         // Underline the closest token. If there is no token at that column,
@@ -495,31 +623,20 @@ void TEditor::applyEditorDecorations() {
         diagnosticSelection.cursor = wordCursor;
         diagnosticSelection.format.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
         diagnosticSelection.format.setUnderlineColor(
-            diagnostic.severity == "warning"
+            diagnostic->severity == "warning"
                 ? QColor(Constants::Colors::WarningForeground)
                 : QColor(Constants::Colors::ErrorForeground));
-        diagnosticSelection.format.setToolTip(diagnostic.message);
-        extraSelections.append(diagnosticSelection);
+        diagnosticSelection.format.setToolTip(diagnostic->message);
+        m_diagnosticSelections.append(diagnosticSelection);
     }
 
-    setExtraSelections(extraSelections);
+    applyEditorDecorations();
 }
 
 TEditor::Diagnostic TEditor::diagnosticAtPosition(const QPoint &position) const {
-    Diagnostic result;
     const QTextCursor cursor = cursorForPosition(position);
-    const int line = cursor.blockNumber() + 1;
-    const int column = cursor.positionInBlock() + 1;
-
-    for (const Diagnostic &diagnostic : m_diagnostics) {
-        if (diagnostic.line != line) continue;
-        // Hover anywhere on the diagnostic line, but prefer the right-side text
-        // range around the reported column.
-        if (column >= qMax(1, diagnostic.column - 2)) {
-            return diagnostic;
-        }
-    }
-    return result;
+    const Diagnostic *diagnostic = m_diagnosticIndex.at(cursor.blockNumber() + 1, cursor.positionInBlock() + 1);
+    return diagnostic ? *diagnostic : Diagnostic();
 }
 
 bool TEditor::hasDiagnosticAtPosition(const QPoint &position, Diagnostic *diagnostic) const {
@@ -529,123 +646,10 @@ bool TEditor::hasDiagnosticAtPosition(const QPoint &position, Diagnostic *diagno
     return true;
 }
 
-void TEditor::updateFoldRegions() {
-
-    QHash<int, bool> previousFoldStates;
-    for (const FoldRegion& region : foldRegions) {
-        previousFoldStates[region.startBlockNumber] = region.folded;
-    }
-
-    foldRegions.clear();
-
-    for (QTextBlock visibleBlock = document()->firstBlock(); visibleBlock.isValid(); visibleBlock = visibleBlock.next()) {
-        visibleBlock.setVisible(true);
-    }
-
-    QTextBlock block = document()->firstBlock();
-    while (block.isValid()) {
-        QString text = block.text();
-
-        QString trimmed = text.trimmed();
-        if (trimmed.startsWith("دالة ") || trimmed.startsWith("صنف ")) {
-            int start = block.blockNumber();
-
-            int startIndent = 0;
-            for (QChar c : text) {
-                if (c == '\t') startIndent += 4;
-                else if (c == ' ') startIndent += 1;
-                else break;
-            }
-
-            QTextBlock next = block.next();
-            int end = start;
-
-            while (next.isValid()) {
-                QString nextText = next.text();
-                QString nextTrim = nextText.trimmed();
-
-                if (nextTrim.isEmpty()) {
-                    next = next.next();
-                    continue;
-                }
-
-                int nextIndent = 0;
-                for (QChar c : nextText) {
-                    if (c == '\t') nextIndent += 4;
-                    else if (c == ' ') nextIndent += 1;
-                    else break;
-                }
-
-                if (nextTrim.startsWith("دالة ") || nextTrim.startsWith("صنف ")) {
-                    if (nextIndent <= startIndent)
-                        break;
-                }
-
-                if (nextIndent <= startIndent)
-                    break;
-
-                end = next.blockNumber();
-                next = next.next();
-            }
-
-            if (end > start) {
-                FoldRegion region{};
-                region.startBlockNumber = start;
-                region.endBlockNumber = end;
-                region.folded = false;
-                if (previousFoldStates.contains(region.startBlockNumber))
-                    region.folded = previousFoldStates[region.startBlockNumber];
-                foldRegions.append(region);
-            }
-        }
-        block = block.next();
-    }
-
-    if (lineNumberArea)
-        lineNumberArea->update();
-
-    for (const FoldRegion& region : foldRegions) {
-        QTextBlock block = document()->findBlockByNumber(region.startBlockNumber + 1);
-        while (block.isValid() && block.blockNumber() <= region.endBlockNumber) {
-            block.setVisible(!region.folded);
-            block = block.next();
-        }
-    }
-    viewport()->update();
-}
-
 void TEditor::toggleFold(int blockNumber) {
-    for (FoldRegion &region : foldRegions) {
-        if (region.startBlockNumber == blockNumber) {
-            region.folded = !region.folded;
-
-            QTextBlock block = document()->findBlockByNumber(region.startBlockNumber + 1);
-            while (block.isValid() && block.blockNumber() <= region.endBlockNumber) {
-                block.setVisible(!region.folded);
-                block = block.next();
-            }
-
-            if (!region.folded) {
-                for (FoldRegion &subRegion : foldRegions) {
-                    if (subRegion.startBlockNumber > region.startBlockNumber &&
-                        subRegion.endBlockNumber <= region.endBlockNumber) {
-                        QTextBlock subBlock = document()->findBlockByNumber(subRegion.startBlockNumber + 1);
-                        bool allVisible = true;
-                        while (subBlock.isValid() && subBlock.blockNumber() <= subRegion.endBlockNumber) {
-                            if (!subBlock.isVisible()) {
-                                allVisible = false;
-                                break;
-                            }
-                            subBlock = subBlock.next();
-                        }
-                        subRegion.folded = !allVisible;
-                    }
-                }
-            }
-
-            viewport()->update();
-            break;
-        }
+    if (m_foldEngine->toggle(blockNumber)) {
+        updateGutterBand();
+        viewport()->update();
     }
 }
 
@@ -731,7 +735,44 @@ void TEditor::dragLeaveEvent(QDragLeaveEvent* event) {
 }
 
 
+void TEditor::mousePressEvent(QMouseEvent *event) {
+    if (event->button() == Qt::LeftButton and (event->modifiers() & Qt::AltModifier)) {
+        const int position = cursorForPosition(event->position().toPoint()).position();
+        if (event->modifiers() & Qt::ShiftModifier) {
+            // Alt+Shift+drag draws a box selection.
+            m_columnAnchor = position;
+            m_multiCursor.selectColumn(position, position);
+        } else {
+            // Alt+click adds a caret.
+            QTextCursor cursor(document());
+            cursor.setPosition(position);
+            m_multiCursor.addCursor(cursor);
+        }
+        multiCursorChanged();
+        event->accept();
+        return;
+    }
+
+    if (m_multiCursor.isActive()) {
+        m_multiCursor.clear();
+        multiCursorChanged();
+    }
+    QPlainTextEdit::mousePressEvent(event);
+}
+
+void TEditor::mouseReleaseEvent(QMouseEvent *event) {
+    m_columnAnchor = -1;
+    QPlainTextEdit::mouseReleaseEvent(event);
+}
+
 void TEditor::mouseMoveEvent(QMouseEvent *event) {
+    if (m_columnAnchor >= 0 and (event->buttons() & Qt::LeftButton)) {
+        m_multiCursor.selectColumn(m_columnAnchor, cursorForPosition(event->position().toPoint()).position());
+        multiCursorChanged();
+        event->accept();
+        return;
+    }
+
     Diagnostic diagnostic;
     if (hasDiagnosticAtPosition(event->position().toPoint(), &diagnostic)) {
         const QString prefix = diagnostic.severity == "warning" ? "تحذير" : "خطأ";
@@ -739,23 +780,24 @@ void TEditor::mouseMoveEvent(QMouseEvent *event) {
                            QString("%1: %2").arg(prefix, diagnostic.message),
                            viewport());
     } else {
+        // The cursor sits between two characters; the word may be on either side.
         const QTextCursor cursor = cursorForPosition(event->position().toPoint());
-        const QString blockText = cursor.block().text();
-        int end = qBound(0, cursor.positionInBlock(), static_cast<int>(blockText.length()));
-        int start = end;
-        while (start > 0 and isCompletionCharacter(blockText.at(start - 1))) --start;
-        while (end < blockText.length() and isCompletionCharacter(blockText.at(end))) ++end;
-        const QString word = blockText.mid(start, end - start);
-        const auto &lang = LanguageDefinition::instance();
-        if (lang.keywordSet.contains(word)) {
+        const QTextBlock block = cursor.block();
+        TTokenSpan token = highlighter->tokenAt(block, cursor.positionInBlock());
+        if (token.type != TokenType::Keyword and token.type != TokenType::BooleanLiteral
+            and token.type != TokenType::BuiltinFunc and token.type != TokenType::Preprocessor) {
+            token = highlighter->tokenAt(block, cursor.positionInBlock() - 1);
+        }
+        const QString word = block.text().mid(token.start, token.length);
+        if (token.type == TokenType::Keyword or token.type == TokenType::BooleanLiteral) {
             QToolTip::showText(event->globalPosition().toPoint(),
                                QString("كلمة محجوزة في لغة باء: %1").arg(word),
                                viewport());
-        } else if (lang.builtinSet.contains(word)) {
+        } else if (token.type == TokenType::BuiltinFunc) {
             QToolTip::showText(event->globalPosition().toPoint(),
                                QString("دالة مدمجة في لغة باء: %1").arg(word),
                                viewport());
-        } else if (lang.preprocessorSet.contains(word)) {
+        } else if (token.type == TokenType::Preprocessor) {
             QToolTip::showText(event->globalPosition().toPoint(),
                                QString("تعليمة معالجة قبلية: %1").arg(word),
                                viewport());
@@ -766,6 +808,21 @@ void TEditor::mouseMoveEvent(QMouseEvent *event) {
     QPlainTextEdit::mouseMoveEvent(event);
 }
 
+void TEditor::paintEvent(QPaintEvent *event) {
+    QPlainTextEdit::paintEvent(event);
+    if (!m_multiCursor.isActive()) return;
+
+    // The extra carets; their selections are extra selections.
+    QPainter painter(viewport());
+    const QColor caretColor = palette().color(QPalette::Text);
+    for (const QTextCursor &cursor : m_multiCursor.extraCursors()) {
+        const QRect caret = cursorRect(cursor);
+        if (caret.intersects(event->rect())) {
+            painter.fillRect(QRect(caret.left(), caret.top(), cursorWidth(), caret.height()), caretColor);
+        }
+    }
+}
+
 void TEditor::leaveEvent(QEvent *event) {
     QToolTip::hideText();
     QPlainTextEdit::leaveEvent(event);
@@ -849,18 +906,26 @@ void TEditor::updateHighlighterTheme(std::shared_ptr<SyntaxTheme> theme) {
 // --- autocomplete system ---
 
 void TEditor::setupAutoComplete() {
-    // set autocomplete system
-    model = new CompletionModel(this);
-    strategies.push_back(std::make_unique<SnippetStrategy>());
-    strategies.push_back(std::make_unique<KeywordStrategy>());
-    strategies.push_back(std::make_unique<BuiltinStrategy>());
-    strategies.push_back(std::make_unique<PreprocessorStrategy>());
-    auto dynamic = std::make_unique<DynamicWordStrategy>();
-    dynamicStrategy = dynamic.get();
-    strategies.push_back(std::move(dynamic));
+    // The stateless strategies are shared by every editor; only the word
+    // index is per document. The completer is built on first use.
+    strategies = sharedCompletionStrategies();
+    dynamicStrategy = std::make_unique<DynamicWordStrategy>();
+    strategies.push_back(dynamicStrategy.get());
+    workspaceStrategy = std::make_unique<WorkspaceWordStrategy>(dynamicStrategy.get());
+    strategies.push_back(workspaceStrategy.get());
+
+    // Kept exact from the lines each edit replaced, deletions included, so
+    // the document is scanned once here and never again.
+    TDocumentMirror *mirror = TDocumentMirror::of(document());
+    dynamicStrategy->rebuildIndex(mirror->snapshot());
+    connect(mirror, &TDocumentMirror::linesReplaced, this,
+            [this, mirror](const TDocumentSnapshot &before, int first, int removed, int added) {
+        dynamicStrategy->replaceLines(before, mirror->snapshot(), first, removed, added);
+    });
+}
 
-    QCompleter *completer = new QCompleter(this);
-    setCompleter(completer);
+TDocumentSnapshot TEditor::snapshot() const {
+    return TDocumentMirror::of(document())->snapshot();
 }
 
 void TEditor::setCompleter(QCompleter *completer) {
@@ -897,6 +962,7 @@ void TEditor::setCompleter(QCompleter *completer) {
                         index.data(Qt::UserRole + 3).toInt());
                     // Get the full completion item
                     QString completionText = index.data(Qt::EditRole).toString();
+                    TCompletionHistory::shared().record(index.data(Qt::DisplayRole).toString());
                     insertCompletion(completionText, type, snippetId);
                 } else {
                     // Fallback to just the string without type
@@ -906,13 +972,26 @@ void TEditor::setCompleter(QCompleter *completer) {
 }
 
 void TEditor::focusOutEvent(QFocusEvent *e) {
-    if (c && c->popup()->isVisible()) {
-        c->popup()->hide();
-    }
+    cancelCompletion();
     QPlainTextEdit::focusOutEvent(e);
 }
 
 void TEditor::keyPressEvent(QKeyEvent *e) {
+    // A key that types or deletes makes the completion request in flight
+    // stale; stop it before the edit reaches the word index, so the index
+    // is less often still shared with that request's query.
+    if (m_completionCancelled && !e->text().isEmpty()) {
+        m_completionCancelled->store(true, std::memory_order_relaxed);
+    }
+
+    // With several cursors, typing and moving act at all of them
+    // (delegated to TMultiCursor).
+    if (m_multiCursor.handleKeyPress(e)) {
+        cancelCompletion();
+        multiCursorChanged();
+        e->accept();
+        return;
+    }
 
     // Bracket and quote auto-pairing (delegated to TBracketHandler)
     if (m_bracketHandler.handleAutoPairing(e)) {
@@ -991,30 +1070,70 @@ void TEditor::performCompletion() {
     if (textUnder.length() < 1) {
         // Optional: Trigger immediately on Ctrl+Space even if empty?
         // For now, keep logic to hide if empty, unless you want "all suggestion" behavior.
-        c->popup()->hide();
+        cancelCompletion();
         return;
     }
 
-    std::vector<CompletionItem> allSuggestions;
-
-    // Avoid O(n) toPlainText() copy on every keystroke.
-    // No strategy uses the fullText parameter (DynamicWordStrategy
-    // queries its pre-built wordIndex instead).
-    static const QString empty;
-
+    // Each keystroke supersedes the request before it: a query still
+    // walking words stops, and its result is dropped.
+    if (m_completionCancelled) m_completionCancelled->store(true, std::memory_order_relaxed);
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_completionCancelled = cancelled;
+
+    // The queries read snapshots of the word indexes and a copy of the
+    // history taken now, so they run off the GUI thread while typing goes
+    // on. Every strategy offers into one bounded, ranked collection; only
+    // the best Constants::Completion::MaxItems are built.
+    std::vector<TCompletionQuery> queries;
+    queries.reserve(strategies.size());
     for (const auto& strategy : strategies) {
-        auto res = strategy->getSuggestions(textUnder, empty);
-        allSuggestions.insert(allSuggestions.end(), res.begin(), res.end());
+        queries.push_back(strategy->prepare());
     }
+    const int position = textCursor().position();
+
+    TEditorScheduler::instance()->runInBackground(this, TEditorScheduler::Task::Completion,
+        [this, queries = std::move(queries), history = TCompletionHistory::shared(), textUnder, cancelled, position]() {
+        TCompletionCollector collector(textUnder, &history);
+        collector.setCancelFlag(cancelled);
+        for (const TCompletionQuery &query : queries) {
+            if (collector.isCancelled()) return std::function<void()>();
+            query(collector);
+        }
+        if (collector.isCancelled()) return std::function<void()>();
+
+        return std::function<void()>([this, suggestions = collector.take(), textUnder, cancelled, position]() {
+            // Only still current if nothing moved the cursor or changed the
+            // word since the request.
+            if (cancelled->load(std::memory_order_relaxed) || textCursor().position() != position
+                || textUnderCursor() != textUnder) return;
+            showCompletions(suggestions);
+        });
+    });
+}
 
-    model->updateData(allSuggestions);
+void TEditor::cancelCompletion() {
+    if (m_completionCancelled) {
+        m_completionCancelled->store(true, std::memory_order_relaxed);
+        m_completionCancelled.reset();
+    }
+    if (c && c->popup()->isVisible()) c->popup()->hide();
+}
 
-    if (allSuggestions.empty()) {
-        c->popup()->hide();
+void TEditor::showCompletions(const std::vector<CompletionItem> &suggestions) {
+    if (suggestions.empty()) {
+        if (c) c->popup()->hide();
         return;
     }
 
-    c->setCompletionPrefix(textUnder);
+    if (!c) {
+        model = new CompletionModel(this);
+        setCompleter(new QCompleter(this));
+    }
+    model->updateData(suggestions);
+
+    // The rows are already matched and ranked; an empty completion prefix
+    // keeps QCompleter from filtering them again by startsWith().
+    c->setCompletionPrefix(QString());
     QRect cr = cursorRect();
 
     QPoint widgetPos = this->viewport()->mapTo(this, cr.topRight());
@@ -1041,6 +1160,7 @@ void TEditor::performCompletion() {
     cr.setWidth(popupWidth);
 
     c->complete(cr);
+    c->popup()->setCurrentIndex(c->completionModel()->index(0, 0));
 }
 
 QString TEditor::textUnderCursor() const {
@@ -5,6 +5,7 @@
 #include <QPlainTextEdit>
 #include <QCompleter>
 #include <QVector>
+#include <atomic>
 #include <memory>
 
 #include "TSettings.h"
@@ -12,8 +13,13 @@
 #include "AutoComplete.h"
 #include "AutoCompleteUI.h"
 #include "TBracketHandler.h"
+#include "TFoldEngine.h"
+#include "TGutterRenderer.h"
+#include "TDiagnosticIndex.h"
 #include "TAutoSave.h"
+#include "TDocumentSnapshot.h"
 #include "TSnippetManager.h"
+#include "TMultiCursor.h"
 #include "Constants.h"
 
 
@@ -24,13 +30,7 @@ class TEditor : public QPlainTextEdit {
     Q_OBJECT
 
 public:
-    struct Diagnostic {
-        QString file;
-        int line = 1;
-        int column = 1;
-        QString severity;
-        QString message;
-    };
+    using Diagnostic = TEditorDiagnostic;
 
     TEditor(QWidget* parent = nullptr);
 
@@ -48,10 +48,22 @@ public:
 
     void setCompleter(QCompleter *completer);
 
+    // Immutable copy of the text, cheap to take and to pass to a worker.
+    TDocumentSnapshot snapshot() const;
+
     void startAutoSave();
     void stopAutoSave();
     void removeBackupFile();
 
+    // While loading, the editor is read-only and shows a placeholder until
+    // its file has been read off the GUI thread.
+    void setLoading(bool loading);
+    bool isLoading() const { return m_loading; }
+    // Fills the loading editor with its file's `text`, appended in slices
+    // bounded by Constants::Timing::LoadSliceBudget so a big file does not
+    // freeze the window, then leaves the loading state.
+    void setLoadedText(const QString &text);
+
 public slots:
     void updateFontSize(int);
     void updateFontType(QString font);
@@ -59,6 +71,11 @@ public slots:
     void duplicateLine();
     void moveLineUp();
     void moveLineDown();
+    // Multi-cursor commands (delegated to TMultiCursor).
+    void addNextOccurrence();
+    void selectAllOccurrences();
+    void addCursorAbove();
+    void addCursorBelow();
     void updateHighlighterTheme(std::shared_ptr<SyntaxTheme>);
 
 protected:
@@ -69,7 +86,10 @@ protected:
     void dragMoveEvent(QDragMoveEvent* event) override;
     void dragLeaveEvent(QDragLeaveEvent* event) override;
     void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
     void leaveEvent(QEvent *event) override;
     void contextMenuEvent(QContextMenuEvent *event) override;
 
@@ -82,16 +102,21 @@ private:
 
     LineNumberArea* lineNumberArea{};
 
-    struct FoldRegion {
-        int startBlockNumber;
-        int endBlockNumber;
-        bool folded = false;
-    };
-    QVector<FoldRegion> foldRegions;
+    std::unique_ptr<TFoldEngine> m_foldEngine;
+    TGutterRenderer m_gutterRenderer;
+
+    QVector<TGutterRenderer::Row> gutterRows() const;
+    // Repaints only the gutter rows that changed since the last paint.
+    void updateGutterBand();
 
-    void updateFoldRegions();
+    std::pair<int, int> visibleBlockRange() const;
+    // Tells the highlighter and diagnostic decorations what is in view.
+    void updateVisibleBlocks();
     void toggleFold(int blockNum);
     void applyEditorDecorations();
+    // Rebuilds diagnostic underlines when blocks [first, last] leave the
+    // materialized range, or when `force` is set.
+    void updateDiagnosticSelections(int first, int last, bool force = false);
     Diagnostic diagnosticAtPosition(const QPoint &position) const;
     bool hasDiagnosticAtPosition(const QPoint &position, Diagnostic *diagnostic) const;
 
@@ -99,18 +124,40 @@ private:
     TBracketHandler m_bracketHandler;
     TAutoSave *m_autoSave{};
     TSnippetManager m_snippetManager;
+    TMultiCursor m_multiCursor;
+    // Alt+Shift+drag: position the box selection is anchored at, or -1.
+    int m_columnAnchor{-1};
 
-    QTimer *m_indexRebuildTimer{};
+    // Lines touched by any cursor, each once, in document order.
+    QList<QTextBlock> cursorBlocks() const;
+    // Repaints extra carets and selections after TMultiCursor changed them.
+    void multiCursorChanged();
 
     friend class LineNumberArea;
 
     QCompleter* c{};
     CompletionModel *model{};
-    std::vector<std::unique_ptr<ICompletionStrategy>> strategies{};
-    DynamicWordStrategy* dynamicStrategy{};
-    QVector<Diagnostic> m_diagnostics;
+    // Shared strategies followed by this editor's word index and the
+    // words of the rest of the open folder.
+    std::vector<ICompletionStrategy*> strategies{};
+    std::unique_ptr<DynamicWordStrategy> dynamicStrategy{};
+    std::unique_ptr<WorkspaceWordStrategy> workspaceStrategy{};
+    // Set once the completion request in flight is superseded.
+    std::shared_ptr<std::atomic_bool> m_completionCancelled{};
+    TDiagnosticIndex m_diagnosticIndex;
+    // Underlines for diagnostics on blocks [m_decoratedFrom, m_decoratedTo]:
+    // the viewport plus one page either side.
+    QList<QTextEdit::ExtraSelection> m_diagnosticSelections;
+    int m_decoratedFrom{0};
+    int m_decoratedTo{-1};
+    bool m_loading{false};
     QString textUnderCursor() const;
     void performCompletion();
+    // One slice of setLoadedText(), from character `from` on.
+    void appendLoadedText(const QString &text, qsizetype from);
+    // Drops the request in flight, if any, and hides the popup.
+    void cancelCompletion();
+    void showCompletions(const std::vector<CompletionItem> &suggestions);
     void setupAutoComplete();
     void insertWord(const QString& completion, QTextCursor& tc);
     void insertBuiltinFunction(const QString& functionName, QTextCursor& tc);
@@ -122,6 +169,7 @@ private slots:
     void insertCompletion(const QString &completion, CompletionType type, SnippetId snippetId);
 signals:
     void openRequest(QString filePath);
+    void loadingFinished();
 };
 
 
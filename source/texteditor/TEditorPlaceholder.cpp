@@ -0,0 +1,14 @@
+#include "TEditorPlaceholder.h"
+#include "Constants.h"
+
+#include <QPalette>
+
+TEditorPlaceholder::TEditorPlaceholder(const QString &filePath, QWidget *parent)
+    : QWidget(parent)
+    , m_filePath(filePath) {
+    // Matches the editor background, so swapping in the editor doesn't flash.
+    QPalette background = palette();
+    background.setColor(QPalette::Window, QColor(Constants::Colors::EditorBackground));
+    setPalette(background);
+    setAutoFillBackground(true);
+}
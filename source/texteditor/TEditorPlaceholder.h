@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QString>
+#include <QWidget>
+
+// Stand-in tab for a file restored from the last session. It holds only the
+// path: FileManager swaps in the real editor, which reads the file and
+// builds its highlighter and indexes, the first time the tab is shown.
+class TEditorPlaceholder : public QWidget {
+    Q_OBJECT
+public:
+    explicit TEditorPlaceholder(const QString &filePath, QWidget *parent = nullptr);
+
+    QString currentFilePath() const { return m_filePath; }
+
+private:
+    QString m_filePath{};
+};
@@ -0,0 +1,125 @@
+#include "TEditorScheduler.h"
+
+#include <QCoreApplication>
+#include <algorithm>
+
+namespace {
+TEditorScheduler* scheduler = nullptr;
+
+void shutdownScheduler() {
+    delete scheduler;
+    scheduler = nullptr;
+}
+}
+
+TEditorScheduler* TEditorScheduler::instance() {
+    if (!scheduler) {
+        scheduler = new TEditorScheduler;
+        // Release the timer while QCoreApplication still exists.
+        qAddPostRoutine(shutdownScheduler);
+    }
+    return scheduler;
+}
+
+TEditorScheduler::TEditorScheduler() {
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &TEditorScheduler::runDueTasks);
+    m_clock.start();
+    m_background.setMaxThreadCount(1);
+    m_background.setObjectName("TEditorScheduler");
+    m_completions.setMaxThreadCount(1);
+    m_completions.setObjectName("TEditorScheduler.Completion");
+}
+
+TEditorScheduler::~TEditorScheduler() {
+    waitForBackground();
+}
+
+void TEditorScheduler::schedule(QObject *owner, Task task, int delay, std::function<void()> work) {
+    const qint64 deadline = m_clock.elapsed() + delay;
+    const int index = indexOf(owner, task);
+    if (index >= 0) {
+        m_entries[index].deadline = deadline;
+        m_entries[index].work = std::move(work);
+    } else {
+        m_entries.append({owner, task, deadline, std::move(work)});
+    }
+    arm();
+}
+
+void TEditorScheduler::cancel(const QObject *owner, Task task) {
+    const int index = indexOf(owner, task);
+    if (index < 0) return;
+    m_entries.remove(index);
+    arm();
+}
+
+bool TEditorScheduler::isPending(const QObject *owner, Task task) const {
+    return indexOf(owner, task) >= 0;
+}
+
+int TEditorScheduler::pendingCount() const {
+    return std::count_if(m_entries.cbegin(), m_entries.cend(),
+                         [](const Entry &entry) { return !entry.owner.isNull(); });
+}
+
+void TEditorScheduler::runInBackground(QObject *owner, Task task, std::function<std::function<void()>()> work) {
+    const std::pair<const QObject*, Task> key{owner, task};
+    const quint64 serial = ++m_nextSerial;
+    m_backgroundSerials.insert(key, serial);
+
+    QPointer<QObject> guard(owner);
+    QThreadPool &pool = task == Task::Completion ? m_completions : m_background;
+    pool.start([this, guard, key, serial, work = std::move(work)]() {
+        std::function<void()> done = work();
+        QMetaObject::invokeMethod(this, [this, guard, key, serial, done = std::move(done)]() {
+            if (m_backgroundSerials.value(key) != serial) return;
+            m_backgroundSerials.remove(key);
+            if (!guard.isNull() && done) done();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void TEditorScheduler::waitForBackground() {
+    m_completions.waitForDone();
+    m_background.waitForDone();
+}
+
+void TEditorScheduler::runDueTasks() {
+    const qint64 now = m_clock.elapsed();
+
+    // Take the due tasks out first: running one may schedule or cancel others.
+    QVector<Entry> due;
+    for (int i = 0; i < m_entries.size();) {
+        if (!m_entries[i].owner.isNull() && m_entries[i].deadline > now) {
+            ++i;
+            continue;
+        }
+        if (!m_entries[i].owner.isNull()) due.append(std::move(m_entries[i]));
+        m_entries.remove(i);
+    }
+
+    for (const Entry &entry : std::as_const(due)) {
+        if (!entry.owner.isNull()) entry.work();
+    }
+    arm();
+}
+
+int TEditorScheduler::indexOf(const QObject *owner, Task task) const {
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i].owner == owner && m_entries[i].task == task) return i;
+    }
+    return -1;
+}
+
+void TEditorScheduler::arm() {
+    m_entries.removeIf([](const Entry &entry) { return entry.owner.isNull(); });
+    if (m_entries.isEmpty()) {
+        m_timer.stop();
+        return;
+    }
+
+    qint64 earliest = m_entries.first().deadline;
+    for (const Entry &entry : std::as_const(m_entries)) earliest = std::min(earliest, entry.deadline);
+    m_timer.start(int(std::max<qint64>(0, earliest - m_clock.elapsed())));
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+
+// Runs the delayed per-editor work of every open tab (backup writes, index
+// rebuilds, slices of a file being loaded) from one timer, instead of one QTimer per editor and task.
+//
+// Each task is keyed by its owner and kind, so scheduling it again moves
+// its deadline rather than queueing a second run. The timer is armed for
+// the earliest deadline only, and a task whose owner was destroyed is
+// dropped without running.
+//
+// Work that only needs a TDocumentSnapshot can be moved off the GUI thread
+// with runInBackground(). Background work runs on one thread, in the order
+// it was submitted, so a backup write is never overtaken by the removal of
+// that backup. Completion queries get a thread of their own, so a keystroke
+// never waits behind a folder being indexed.
+class TEditorScheduler : public QObject {
+    Q_OBJECT
+public:
+    enum class Task : quint8 { AutoSave, IndexRebuild, IndexUpdate, Completion, Load };
+
+    static TEditorScheduler *instance();
+    ~TEditorScheduler() override;
+
+    // Runs `work` once, `delay` ms from now, replacing a pending `task` of
+    // `owner`.
+    void schedule(QObject *owner, Task task, int delay, std::function<void()> work);
+    void cancel(const QObject *owner, Task task);
+    bool isPending(const QObject *owner, Task task) const;
+    int pendingCount() const;
+
+    // Runs `work` on the background thread (Task::Completion on the
+    // completion thread). The function it returns, if
+    // any, is called back on this thread, unless `owner` was destroyed or
+    // the same task of `owner` was submitted again in the meantime.
+    void runInBackground(QObject *owner, Task task, std::function<std::function<void()>()> work);
+    // Blocks until all background work has finished.
+    void waitForBackground();
+
+private slots:
+    void runDueTasks();
+
+private:
+    struct Entry {
+        QPointer<QObject> owner{};
+        Task task{};
+        qint64 deadline{};
+        std::function<void()> work{};
+    };
+
+    TEditorScheduler();
+
+    int indexOf(const QObject *owner, Task task) const;
+    // Forgets dead owners and restarts the timer for the earliest deadline.
+    void arm();
+
+    QVector<Entry> m_entries{};
+    QTimer m_timer{};
+    QElapsedTimer m_clock{};
+    QThreadPool m_background{};
+    QThreadPool m_completions{};
+    // Serial of the latest background submission per owner and task.
+    QMap<std::pair<const QObject*, Task>, quint64> m_backgroundSerials{};
+    quint64 m_nextSerial{};
+};
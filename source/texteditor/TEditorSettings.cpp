@@ -0,0 +1,36 @@
+#include "TEditorSettings.h"
+
+#include <QSettings>
+#include <algorithm>
+#include "Constants.h"
+
+namespace {
+TEditorSettings &snapshot() {
+    static TEditorSettings settings = [] {
+        QSettings settingsVal(Constants::OrgName, Constants::AppName);
+        TEditorSettings loaded;
+        loaded.fontSize = settingsVal.value(Constants::SettingsKeyFontSize).toInt();
+        loaded.fontFamily = settingsVal.value(Constants::SettingsKeyFontType).toString();
+        loaded.themeIndex = std::max(0, settingsVal.value(Constants::SettingsKeyTheme).toInt());
+        return loaded;
+    }();
+    return settings;
+}
+}
+
+const TEditorSettings &TEditorSettings::current() {
+    return snapshot();
+}
+
+void TEditorSettings::save(int fontSize, const QString &fontFamily, int themeIndex) {
+    QSettings settings(Constants::OrgName, Constants::AppName);
+    settings.setValue(Constants::SettingsKeyFontSize, fontSize);
+    settings.setValue(Constants::SettingsKeyFontType, fontFamily);
+    settings.setValue(Constants::SettingsKeyTheme, themeIndex);
+    settings.sync();
+
+    TEditorSettings &cached = snapshot();
+    cached.fontSize = fontSize;
+    cached.fontFamily = fontFamily;
+    cached.themeIndex = std::max(0, themeIndex);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QString>
+
+// Font and theme every new editor starts with. Read from QSettings once per
+// process rather than in each editor's constructor; save() writes both the
+// settings and this copy, so later editors see the change.
+struct TEditorSettings {
+    int fontSize{};
+    QString fontFamily{};
+    int themeIndex{};
+
+    static const TEditorSettings &current();
+    static void save(int fontSize, const QString &fontFamily, int themeIndex);
+};
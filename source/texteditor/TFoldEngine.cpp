@@ -0,0 +1,415 @@
+#include "TFoldEngine.h"
+#include "TSyntaxHighlighter.h"
+
+#include <QElapsedTimer>
+#include <QTextBlock>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include "Constants.h"
+
+namespace {
+bool startsBefore(const TFoldEngine::Region &region, int blockNumber) {
+    return region.start < blockNumber;
+}
+}
+
+TFoldEngine::TFoldEngine(QTextDocument *document, TSyntaxHighlighter *highlighter, QObject *parent)
+    : QObject(parent), m_document(document), m_highlighter(highlighter) {
+    m_analysisTimer = new QTimer(this);
+    m_analysisTimer->setSingleShot(true);
+    connect(m_analysisTimer, &QTimer::timeout, this, &TFoldEngine::analyzePendingLines);
+    connect(m_document, &QTextDocument::contentsChange, this, &TFoldEngine::onContentsChange);
+    connect(m_highlighter, &TSyntaxHighlighter::tokensRelexed, this, &TFoldEngine::onTokensRelexed);
+    rebuild();
+}
+
+void TFoldEngine::rebuild() {
+    const int count = m_document->blockCount();
+    LineInfo stale;
+    stale.stale = true;
+    m_lines.fill(stale, count);
+
+    int line = 0;
+    for (QTextBlock block = m_document->firstBlock(); block.isValid() && line < SyncLineLimit;
+         block = block.next(), ++line) {
+        m_lines[line] = lineInfo(block);
+    }
+    m_staleFrom = line < count ? line : NoBlock;
+    if (hasPendingLines()) m_analysisTimer->start();
+
+    m_regions.clear();
+    m_unclosed.clear();
+    scan(0, count - 1, m_regions, m_unclosed);
+    buildIndex();
+    applyVisibility(0, count - 1);
+}
+
+void TFoldEngine::onContentsChange(int position, int charsRemoved, int charsAdded) {
+    Q_UNUSED(charsRemoved);
+
+    const int blockCount = m_document->blockCount();
+    const int delta = blockCount - static_cast<int>(m_lines.size());
+    QTextBlock block = m_document->findBlock(position);
+    QTextBlock last = m_document->findBlock(position + charsAdded);
+    if (!last.isValid()) last = m_document->lastBlock();
+    const int first = block.isValid() ? block.blockNumber() : -1;
+    const int lastNumber = last.blockNumber();
+    // Last edited block, numbered as before the edit.
+    const int oldLast = lastNumber - delta;
+    if (first < 0 || oldLast < first || oldLast >= m_lines.size()) {
+        m_relexedDuringEdit.clear();
+        rebuild();
+        emit regionsChanged();
+        return;
+    }
+
+    // Large edits are analyzed now up to SyncLineLimit, the rest later.
+    LineInfo stale;
+    stale.stale = true;
+    QVector<LineInfo> changed(lastNumber - first + 1, stale);
+    for (int i = 0; i < changed.size() && i < SyncLineLimit; ++i, block = block.next()) {
+        changed[i] = lineInfo(block);
+    }
+
+    // Typing inside a line rarely changes its braces.
+    const bool reshaped = delta != 0 || !std::equal(changed.cbegin(), changed.cend(), m_lines.cbegin() + first);
+    if (reshaped) {
+        // Found on the regions as they were before the edit.
+        const int from = enclosingStart(first);
+
+        // Move everything to the new block numbering.
+        if (delta > 0) m_lines.insert(first, delta, LineInfo());
+        else if (delta < 0) m_lines.remove(first, -delta);
+        std::copy(changed.cbegin(), changed.cend(), m_lines.begin() + first);
+
+        for (Region &region : m_regions) {
+            if (region.start > oldLast) {
+                region.start += delta;
+                region.end += delta;
+            } else if (region.start >= first) {
+                // Rescanned below; only the header number matters, to keep its folded flag.
+                region.start = qMin(region.start, lastNumber);
+            }
+        }
+        for (int &start : m_unclosed) {
+            if (start > oldLast) start += delta;
+            else if (start >= first) start = qMin(start, lastNumber);
+        }
+
+        if (m_staleFrom > first && m_staleFrom != NoBlock) m_staleFrom = first;
+        if (changed.size() > SyncLineLimit) {
+            m_staleFrom = qMin(m_staleFrom, first + SyncLineLimit);
+            m_analysisTimer->start();
+        }
+
+        relink(from, lastNumber, first, lastNumber);
+    }
+
+    for (int line : std::exchange(m_relexedDuringEdit, {})) markStale(line);
+    if (reshaped) emit regionsChanged();
+}
+
+void TFoldEngine::onTokensRelexed(int blockNumber) {
+    // The highlighter sees an edit before this engine does; until then its
+    // block numbers may not match m_lines.
+    if (m_lines.size() != m_document->blockCount()) m_relexedDuringEdit.append(blockNumber);
+    else markStale(blockNumber);
+}
+
+void TFoldEngine::markStale(int line) {
+    if (line < 0 || line >= m_lines.size()) return;
+    m_lines[line].stale = true;
+    m_staleFrom = qMin(m_staleFrom, line);
+    m_analysisTimer->start();
+}
+
+void TFoldEngine::analyzePendingLines() {
+    if (!hasPendingLines()) return;
+
+    QElapsedTimer slice;
+    slice.start();
+
+    const int count = static_cast<int>(m_lines.size());
+    int line = m_staleFrom;
+    // Lexing a block below may report more stale blocks.
+    m_staleFrom = NoBlock;
+    int changedFrom = NoBlock;
+    int changedTo = -1;
+    for (QTextBlock block = m_document->findBlockByNumber(line); block.isValid() && line < count;
+         block = block.next(), ++line) {
+        if (slice.hasExpired(Constants::Timing::FoldSliceBudget)) break;
+        if (!m_lines[line].stale) continue;
+
+        const LineInfo info = lineInfo(block);
+        LineInfo previous = m_lines[line];
+        previous.stale = false;
+        if (!(info == previous)) {
+            changedFrom = qMin(changedFrom, line);
+            changedTo = line;
+        }
+        m_lines[line] = info;
+    }
+    if (line < count) m_staleFrom = qMin(m_staleFrom, line);
+
+    if (changedFrom != NoBlock) {
+        relink(enclosingStart(changedFrom), changedTo);
+        emit regionsChanged();
+    }
+    if (hasPendingLines()) m_analysisTimer->start();
+}
+
+const TFoldEngine::Region *TFoldEngine::regionAt(int blockNumber) const {
+    auto it = std::lower_bound(m_regions.cbegin(), m_regions.cend(), blockNumber, startsBefore);
+    return it != m_regions.cend() && it->start == blockNumber && it->end > it->start ? &*it : nullptr;
+}
+
+bool TFoldEngine::toggle(int blockNumber) {
+    auto it = std::lower_bound(m_regions.begin(), m_regions.end(), blockNumber, startsBefore);
+    if (it == m_regions.end() || it->start != blockNumber || it->end <= it->start) return false;
+
+    it->folded = !it->folded;
+    applyVisibility(it->start + 1, it->end);
+    return true;
+}
+
+TFoldEngine::LineInfo TFoldEngine::lineInfo(const QTextBlock &block) const {
+    LineInfo info;
+    const QString text = block.text();
+    // Most blocks have nothing to match and need no tokens at all.
+    if (std::none_of(text.cbegin(), text.cend(), [](QChar c) { return c == u'{' || c == u'}' || c == u'#'; })) {
+        return info;
+    }
+
+    // Tokens tell braces apart from those inside strings and comments.
+    const QVector<TTokenSpan> &tokens = m_highlighter->tokensFor(block);
+    bool leading = true;
+    for (const TTokenSpan &token : tokens) {
+        if (token.type == TokenType::Whitespace) continue;
+        if (token.type == TokenType::Operator && token.length == 1) {
+            const QChar c = text[token.start];
+            if (c == u'{') {
+                ++info.opens;
+            } else if (c == u'}') {
+                if (info.opens > 0) --info.opens;
+                else ++info.closes;
+            }
+        } else if (leading && token.type == TokenType::Preprocessor) {
+            const QStringView directive = QStringView(text).mid(token.start, token.length);
+            if (directive == u"#إذا_عرف") {
+                info.directiveOpens = 1;
+            } else if (directive == u"#وإلا") {
+                info.directiveCloses = 1;
+                info.directiveOpens = 1;
+            } else if (directive == u"#نهاية") {
+                info.directiveCloses = 1;
+            }
+        }
+        leading = false;
+    }
+    return info;
+}
+
+int TFoldEngine::enclosingStart(int line) const {
+    // An opener never closed is on the stack everywhere after it.
+    int from = line;
+    if (!m_unclosed.isEmpty()) from = qMin(from, m_unclosed.first());
+
+    // Step out of every pair still open at `from`, then out of pairs open
+    // at that header ("} وإلا {" chains, directives around braces).
+    for (;;) {
+        int outer = from;
+        for (int index : overlapping(from - 1, from - 1)) outer = qMin(outer, m_regions[index].start);
+        if (outer == from) return from;
+        from = outer;
+    }
+}
+
+int TFoldEngine::scan(int from, int mustReach, QVector<Region> &out, QVector<int> &unclosed) const {
+    // Both stacks hold the blocks of openers not matched yet. Once they are
+    // empty past the edit, every later pair is the same as before it.
+    QVarLengthArray<int, 32> braces;
+    QVarLengthArray<int, 8> directives;
+    const qsizetype firstOut = out.size();
+    const int count = static_cast<int>(m_lines.size());
+    auto close = [&out](auto &stack, int closes, int line) {
+        for (; closes > 0 && !stack.isEmpty(); --closes) {
+            out.append({stack.last(), line - 1, false});
+            stack.removeLast();
+        }
+    };
+
+    int line = from;
+    for (; line < count; ++line) {
+        if (line > mustReach && braces.isEmpty() && directives.isEmpty()) break;
+
+        const LineInfo &info = m_lines[line];
+        close(braces, info.closes, line);
+        for (int opened = 0; opened < info.opens; ++opened) braces.append(line);
+        close(directives, info.directiveCloses, line);
+        if (info.directiveOpens) directives.append(line);
+    }
+
+    const qsizetype firstUnclosed = unclosed.size();
+    for (int start : braces) unclosed.append(start);
+    for (int start : directives) unclosed.append(start);
+    std::sort(unclosed.begin() + firstUnclosed, unclosed.end());
+
+    // Inner regions close first; among regions opened on one block the
+    // outermost comes first.
+    std::sort(out.begin() + firstOut, out.end(), [](const Region &a, const Region &b) {
+        return a.start < b.start || (a.start == b.start && a.end > b.end);
+    });
+    return line;
+}
+
+void TFoldEngine::relink(int from, int mustReach, int showFrom, int showTo) {
+    QVector<Region> fresh;
+    QVector<int> unclosed;
+    const int end = scan(from, mustReach, fresh, unclosed);
+    replaceRegions(from, end - 1, fresh, showFrom, showTo);
+
+    const qsizetype begin = std::lower_bound(m_unclosed.cbegin(), m_unclosed.cend(), from) - m_unclosed.cbegin();
+    const qsizetype stop = std::lower_bound(m_unclosed.cbegin(), m_unclosed.cend(), end) - m_unclosed.cbegin();
+    QVector<int> merged = m_unclosed.mid(0, begin);
+    merged += unclosed;
+    merged += m_unclosed.mid(stop);
+    m_unclosed = std::move(merged);
+
+    buildIndex();
+    applyVisibility(showFrom, qMin(showTo, static_cast<int>(m_lines.size()) - 1));
+}
+
+void TFoldEngine::replaceRegions(int first, int last, const QVector<Region> &fresh, int &showFrom, int &showTo) {
+    // Folded regions that appear, move or vanish change what is hidden.
+    auto widen = [&showFrom, &showTo](const Region &region) {
+        if (!region.folded || region.end <= region.start) return;
+        showFrom = qMin(showFrom, region.start + 1);
+        showTo = qMax(showTo, region.end);
+    };
+
+    auto begin = std::lower_bound(m_regions.cbegin(), m_regions.cend(), first, startsBefore);
+    auto end = std::lower_bound(begin, m_regions.cend(), last + 1, startsBefore);
+
+    QVector<Region> merged;
+    merged.reserve(m_regions.size() - (end - begin) + fresh.size());
+    std::copy(m_regions.cbegin(), begin, std::back_inserter(merged));
+    auto old = begin;
+    int previousStart = -1;
+    for (Region region : fresh) {
+        while (old != end && old->start < region.start) widen(*old++);
+        // Regions that survived the edit keep their folded state; only the
+        // outermost region of a block can be folded.
+        if (region.start != previousStart) {
+            for (; old != end && old->start == region.start; ++old) {
+                region.folded = region.folded || old->folded;
+                widen(*old);
+            }
+        }
+        previousStart = region.start;
+        widen(region);
+        merged.append(region);
+    }
+    while (old != end) widen(*old++);
+    std::copy(end, m_regions.cend(), std::back_inserter(merged));
+    m_regions = std::move(merged);
+}
+
+bool TFoldEngine::applyVisibility(int first, int last) {
+    if (first > last) return false;
+
+    // How many folded regions hide each block of [first, last].
+    QVector<int> depth(last - first + 2, 0);
+    for (int index : overlapping(first, last)) {
+        const Region &region = m_regions[index];
+        if (!region.folded) continue;
+        const int hideFrom = qMax(region.start + 1, first);
+        const int hideTo = qMin(region.end, last);
+        if (hideFrom > hideTo) continue;
+        ++depth[hideFrom - first];
+        --depth[hideTo - first + 1];
+    }
+
+    bool changed = false;
+    int hiddenBy = 0;
+    QTextBlock block = m_document->findBlockByNumber(first);
+    for (int number = first; block.isValid() && number <= last; ++number, block = block.next()) {
+        hiddenBy += depth[number - first];
+        const bool visible = hiddenBy == 0;
+        if (block.isVisible() != visible) {
+            block.setVisible(visible);
+            m_document->markContentsDirty(block.position(), block.length());
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// ==================== Interval Tree ====================
+//
+// Implicit augmented tree over the start-sorted region array: the node at
+// index i sits at the level given by its trailing one bits, and m_maxEnd[i]
+// is the largest end in its subtree (as in Heng Li's cgranges).
+
+void TFoldEngine::buildIndex() {
+    const qsizetype n = m_regions.size();
+    m_maxEnd.resize(n);
+    m_maxLevel = -1;
+    if (n == 0) return;
+
+    qsizetype lastIndex = 0;
+    int lastMax = 0;
+    for (qsizetype i = 0; i < n; i += 2) {
+        lastIndex = i;
+        lastMax = m_maxEnd[i] = m_regions[i].end;
+    }
+    int level = 1;
+    for (; (qsizetype(1) << level) <= n; ++level) {
+        const qsizetype half = qsizetype(1) << (level - 1);
+        const qsizetype step = half << 2;
+        for (qsizetype i = (half << 1) - 1; i < n; i += step) {
+            const int left = m_maxEnd[i - half];
+            const int right = i + half < n ? m_maxEnd[i + half] : lastMax;
+            m_maxEnd[i] = std::max({m_regions[i].end, left, right});
+        }
+        lastIndex = (lastIndex >> level) & 1 ? lastIndex - half : lastIndex + half;
+        if (lastIndex < n && m_maxEnd[lastIndex] > lastMax) lastMax = m_maxEnd[lastIndex];
+    }
+    m_maxLevel = level - 1;
+}
+
+QVector<int> TFoldEngine::overlapping(int first, int last) const {
+    QVector<int> found;
+    const qsizetype n = m_regions.size();
+    if (m_maxLevel < 0) return found;
+
+    struct Node {
+        qsizetype index;
+        int level;
+        bool leftDone;
+    };
+    QVarLengthArray<Node, 64> stack;
+    stack.append({(qsizetype(1) << m_maxLevel) - 1, m_maxLevel, false});
+    while (!stack.isEmpty()) {
+        const Node node = stack.last();
+        stack.removeLast();
+        if (node.level <= 3) {
+            // Small subtree: a linear scan is cheaper than descending.
+            const qsizetype begin = node.index >> node.level << node.level;
+            const qsizetype end = qMin(begin + (qsizetype(1) << (node.level + 1)) - 1, n);
+            for (qsizetype i = begin; i < end && m_regions[i].start <= last; ++i) {
+                if (m_regions[i].end >= first) found.append(static_cast<int>(i));
+            }
+        } else if (!node.leftDone) {
+            // The left child may lie past the array end; it is still visited.
+            const qsizetype left = node.index - (qsizetype(1) << (node.level - 1));
+            stack.append({node.index, node.level, true});
+            if (left >= n || m_maxEnd[left] >= first) stack.append({left, node.level - 1, false});
+        } else if (node.index < n && m_regions[node.index].start <= last) {
+            if (m_regions[node.index].end >= first) found.append(static_cast<int>(node.index));
+            stack.append({node.index + (qsizetype(1) << (node.level - 1)), node.level - 1, false});
+        }
+    }
+    return found;
+}
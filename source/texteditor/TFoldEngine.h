@@ -0,0 +1,125 @@
+#pragma once
+
+#include <QObject>
+#include <QTextDocument>
+#include <QTimer>
+#include <QVector>
+#include <limits>
+
+class TSyntaxHighlighter;
+
+// Fold regions of a document, kept up to date from QTextDocument::contentsChange.
+// Extracted from TEditor so an edit only recomputes the regions it touches.
+//
+// Regions come from the lexer's tokens, so braces inside strings and
+// comments are ignored: a '{' opens a region that its matching '}' closes,
+// which covers functions and every إذا / طالما / لكل / اختر block, and
+// #إذا_عرف opens a region that #وإلا or #نهاية closes. Regions nest freely;
+// the closing line stays visible so "} وإلا {" keeps its own region.
+//
+// Each block's unmatched braces and directives are cached, so a keystroke
+// that leaves them unchanged costs no region work at all. Other edits rescan
+// from the outermost region enclosing the edit until the brace stacks are
+// empty again past it. Regions are kept sorted by header block in an
+// implicit interval tree (each node also stores the largest end in its
+// subtree), which finds the regions enclosing an edit without walking the
+// document. Blocks beyond SyncLineLimit in one edit, and blocks re-lexed
+// by the highlighter, are analyzed in slices bounded by
+// Constants::Timing::FoldSliceBudget. Visibility is only toggled on blocks
+// whose folded state actually changed.
+class TFoldEngine : public QObject {
+    Q_OBJECT
+public:
+    struct Region {
+        int start{};   // Header block; stays visible when folded.
+        int end{};     // Last block hidden when folded.
+        bool folded{false};
+    };
+
+    TFoldEngine(QTextDocument *document, TSyntaxHighlighter *highlighter, QObject *parent = nullptr);
+
+    // Recomputes every region, e.g. when the engine attaches to a document.
+    void rebuild();
+
+    // Region headed at `blockNumber` with at least one block to hide, or
+    // nullptr. Where several regions open on one block, the outermost.
+    const Region *regionAt(int blockNumber) const;
+
+    // Folds or unfolds the region headed at `blockNumber`; nested folded
+    // regions stay folded. Returns false if no region starts there.
+    bool toggle(int blockNumber);
+
+    // Every brace and directive pair, sorted by start, including pairs with
+    // nothing to hide.
+    const QVector<Region> &regions() const { return m_regions; }
+
+    // True while blocks still wait to be analyzed in the background.
+    bool hasPendingLines() const { return m_staleFrom != NoBlock; }
+
+signals:
+    // Regions or block visibility changed.
+    void regionsChanged();
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void onTokensRelexed(int blockNumber);
+    void analyzePendingLines();
+
+private:
+    static constexpr int NoBlock = std::numeric_limits<int>::max();
+    // Edited blocks beyond this count (e.g. a paste or setPlainText) are
+    // analyzed in background slices.
+    static constexpr int SyncLineLimit = 256;
+
+    // What one block contributes to folding, after braces matched within
+    // the block cancel out: `closes` unmatched '}' followed by `opens`
+    // unmatched '{'.
+    struct LineInfo {
+        int closes{};
+        int opens{};
+        quint8 directiveCloses{};
+        quint8 directiveOpens{};
+        bool stale{false};
+        bool operator==(const LineInfo &other) const = default;
+    };
+
+    LineInfo lineInfo(const QTextBlock &block) const;
+
+    // Earliest block at or before `line` where both brace stacks are empty.
+    int enclosingStart(int line) const;
+
+    // Pairs from scanning m_lines at `from` (stacks empty there) until a
+    // block past `mustReach` is reached with both stacks empty. Openers
+    // never closed go to `unclosed`. Returns the first block not scanned.
+    int scan(int from, int mustReach, QVector<Region> &out, QVector<int> &unclosed) const;
+
+    // Rescans from `from` past `mustReach` and applies the result; blocks
+    // [showFrom, showTo] are re-checked for visibility, e.g. edited ones.
+    void relink(int from, int mustReach, int showFrom = NoBlock, int showTo = -1);
+
+    // Replaces the regions headed in [first, last] with `fresh` (sorted),
+    // widening [showFrom, showTo] over folded regions on either side.
+    void replaceRegions(int first, int last, const QVector<Region> &fresh, int &showFrom, int &showTo);
+
+    void markStale(int line);
+
+    // Shows or hides blocks in [first, last] according to the folded regions.
+    bool applyVisibility(int first, int last);
+
+    // Interval tree over m_regions.
+    void buildIndex();
+    QVector<int> overlapping(int first, int last) const;
+
+    QTextDocument *m_document{};
+    TSyntaxHighlighter *m_highlighter{};
+    QTimer *m_analysisTimer{};
+    QVector<LineInfo> m_lines{};
+    QVector<Region> m_regions{};
+    // Opening lines of braces and directives that are never closed.
+    QVector<int> m_unclosed{};
+    QVector<int> m_maxEnd{};
+    int m_maxLevel{-1};
+    int m_staleFrom{NoBlock};
+    // Blocks the highlighter re-lexed before this engine saw the edit.
+    QVector<int> m_relexedDuringEdit{};
+};
@@ -0,0 +1,129 @@
+#include "TGutterRenderer.h"
+
+#include <QByteArray>
+#include <QPolygon>
+#include "Constants.h"
+
+void TGutterRenderer::paint(QPainter &painter, const QRect &clip, int width, int lineHeight,
+                            const QVector<Row> &rows) {
+    if (!m_hasFont || painter.font() != m_font) setFont(painter.font());
+
+    painter.fillRect(clip, Qt::transparent);
+    const QColor numberColor(Constants::Colors::TextMuted);
+    const QColor markerColor(Constants::Colors::Accent);
+    const QRect numberArea(12, 0, width, lineHeight);
+
+    for (const Row &row : rows) {
+        if (row.top > clip.bottom() || row.top + row.height < clip.top()) continue;
+
+        painter.setPen(numberColor);
+        if (const NumberRun *number = numberRunFor(row.blockNumber + 1)) {
+            // Qt::AlignRight follows the layout direction, as drawText() does.
+            const qreal x = painter.layoutDirection() == Qt::RightToLeft
+                                ? numberArea.left()
+                                : numberArea.left() + numberArea.width() - number->advance;
+            const qreal glyphHeight = m_rawFont.ascent() + m_rawFont.descent();
+            const qreal baseline = row.top + (lineHeight - glyphHeight) / 2 + m_rawFont.ascent();
+            painter.drawGlyphRun(QPointF(x, baseline), number->run);
+        } else {
+            painter.drawText(numberArea.translated(0, row.top), Qt::AlignRight | Qt::AlignVCenter,
+                             QString::number(row.blockNumber + 1));
+        }
+
+        if (row.marker != Marker::None) {
+            QPolygon arrow;
+            const int midY = row.top + lineHeight / 2;
+            if (row.marker == Marker::Folded) {
+                arrow << QPoint(width - 10, midY - 4)
+                << QPoint(width - 2, midY)
+                << QPoint(width - 10, midY + 4);
+            } else {
+                arrow << QPoint(width - 10, midY - 4)
+                << QPoint(width - 2, midY - 4)
+                << QPoint(width - 6, midY + 4);
+            }
+
+            painter.setBrush(markerColor);
+            painter.setPen(Qt::NoPen);
+            painter.drawPolygon(arrow);
+        }
+    }
+
+    m_painted = rows;
+}
+
+QRect TGutterRenderer::dirtyBand(const QVector<Row> &rows, const QRect &area) const {
+    // Rows scrolled out of the gutter no longer matter.
+    QRect band;
+    auto add = [&band, &area](const Row &row) {
+        band |= QRect(area.left(), row.top, area.width(), row.height) & area;
+    };
+
+    // Both lists run top to bottom; a row that moved, changed or appeared
+    // on one side only is dirty.
+    qsizetype current = 0;
+    qsizetype painted = 0;
+    while (current < rows.size() || painted < m_painted.size()) {
+        if (painted == m_painted.size()
+            || (current < rows.size() && rows[current].top < m_painted[painted].top)) {
+            add(rows[current++]);
+        } else if (current == rows.size() || m_painted[painted].top < rows[current].top) {
+            add(m_painted[painted++]);
+        } else {
+            if (!(rows[current] == m_painted[painted])) {
+                add(rows[current]);
+                add(m_painted[painted]);
+            }
+            ++current;
+            ++painted;
+        }
+    }
+    return band;
+}
+
+void TGutterRenderer::scroll(int dy) {
+    for (Row &row : m_painted) row.top += dy;
+}
+
+void TGutterRenderer::setFont(const QFont &font) {
+    m_font = font;
+    m_hasFont = true;
+    m_numberRuns.clear();
+    m_hasDigitGlyphs = false;
+
+    m_rawFont = QRawFont::fromFont(font);
+    if (!m_rawFont.isValid()) return;
+    const QList<quint32> glyphs = m_rawFont.glyphIndexesForString(QStringLiteral("0123456789"));
+    if (glyphs.size() != 10 || glyphs.contains(0)) return;
+    const QList<QPointF> advances = m_rawFont.advancesForGlyphIndexes(glyphs);
+    for (int digit = 0; digit < 10; ++digit) {
+        m_digitGlyphs[digit] = glyphs[digit];
+        m_digitAdvances[digit] = advances[digit].x();
+    }
+    m_hasDigitGlyphs = true;
+}
+
+const TGutterRenderer::NumberRun *TGutterRenderer::numberRunFor(int lineNumber) {
+    if (!m_hasDigitGlyphs) return nullptr;
+
+    auto it = m_numberRuns.constFind(lineNumber);
+    if (it != m_numberRuns.constEnd()) return &*it;
+    if (m_numberRuns.size() >= NumberRunCacheLimit) m_numberRuns.clear();
+
+    const QByteArray digits = QByteArray::number(lineNumber);
+    QList<quint32> indexes;
+    QList<QPointF> positions;
+    indexes.reserve(digits.size());
+    positions.reserve(digits.size());
+    NumberRun number;
+    for (char c : digits) {
+        const int digit = c - '0';
+        indexes.append(m_digitGlyphs[digit]);
+        positions.append(QPointF(number.advance, 0));
+        number.advance += m_digitAdvances[digit];
+    }
+    number.run.setRawFont(m_rawFont);
+    number.run.setGlyphIndexes(indexes);
+    number.run.setPositions(positions);
+    return &*m_numberRuns.insert(lineNumber, number);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QFont>
+#include <QGlyphRun>
+#include <QHash>
+#include <QPainter>
+#include <QRawFont>
+#include <QVector>
+#include <array>
+
+// Paints TEditor's line-number gutter.
+// Extracted from TEditor so painting a line costs no text shaping.
+//
+// Digit glyphs and advances are looked up once per font, and each line
+// number's glyph run is built once and reused while scrolling. The rows
+// painted last are kept, so an update request only repaints the band of
+// rows whose block, position or fold marker actually changed.
+class TGutterRenderer {
+public:
+    enum class Marker : quint8 { None, Expanded, Folded };
+
+    // One visible block, in gutter coordinates.
+    struct Row {
+        int blockNumber{};
+        int top{};
+        int height{};
+        Marker marker{Marker::None};
+        bool operator==(const Row &other) const = default;
+    };
+
+    // Paints the rows intersecting `clip`. `lineHeight` is the height the
+    // number is centered in.
+    void paint(QPainter &painter, const QRect &clip, int width, int lineHeight, const QVector<Row> &rows);
+
+    // Part of `area` (the gutter's rect) whose rows differ from the last
+    // paint; empty if nothing changed.
+    QRect dirtyBand(const QVector<Row> &rows, const QRect &area) const;
+
+    // The gutter's pixels were scrolled by `dy`.
+    void scroll(int dy);
+
+private:
+    static constexpr int NumberRunCacheLimit = 1024;
+
+    struct NumberRun {
+        QGlyphRun run{};
+        qreal advance{};
+    };
+
+    void setFont(const QFont &font);
+    const NumberRun *numberRunFor(int lineNumber);
+
+    QFont m_font{};
+    bool m_hasFont{false};
+    QRawFont m_rawFont{};
+    // Glyph index and advance of '0'..'9'; unusable if the font lacks one.
+    std::array<quint32, 10> m_digitGlyphs{};
+    std::array<qreal, 10> m_digitAdvances{};
+    bool m_hasDigitGlyphs{false};
+    QHash<int, NumberRun> m_numberRuns{};
+    QVector<Row> m_painted{};
+};
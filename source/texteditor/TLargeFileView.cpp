@@ -0,0 +1,479 @@
+#include "TLargeFileView.h"
+#include "Constants.h"
+#include "TEditorSettings.h"
+
+#include <QClipboard>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextLayout>
+#include <QtMath>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+
+namespace {
+unsigned char foldAscii(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+struct FoldedHash {
+    std::size_t operator()(char c) const { return foldAscii(static_cast<unsigned char>(c)); }
+};
+
+struct FoldedEqual {
+    bool operator()(char a, char b) const {
+        return foldAscii(static_cast<unsigned char>(a)) == foldAscii(static_cast<unsigned char>(b));
+    }
+};
+
+// Bytes of UTF-8 sequences count as word characters, so Arabic letters do.
+bool isWordByte(unsigned char c) {
+    return c >= 0x80 || std::isalnum(c) || c == '_';
+}
+}
+
+TLargeFileView::TLargeFileView(QWidget *parent)
+    : QAbstractScrollArea(parent) {
+    setFrameShape(QFrame::NoFrame);
+    setFocusPolicy(Qt::StrongFocus);
+
+    const TEditorSettings &settings = TEditorSettings::current();
+    QFont viewFont = font();
+    viewFont.setPixelSize(settings.fontSize < 10 ? Constants::DefaultFontSize : settings.fontSize);
+    if (!settings.fontFamily.isEmpty()) viewFont.setFamily(settings.fontFamily);
+    setFont(viewFont);
+
+    m_indexTimer = new QTimer(this);
+    m_indexTimer->setSingleShot(true);
+    connect(m_indexTimer, &QTimer::timeout, this, &TLargeFileView::indexPendingBytes);
+}
+
+bool TLargeFileView::openFile(const QString &filePath) {
+    m_indexTimer->stop();
+    m_file.close();
+    m_buffer.clear();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    uchar *mapped = size > 0 ? m_file.map(0, size) : nullptr;
+    if (mapped) {
+        m_data = reinterpret_cast<const char *>(mapped);
+        m_size = size;
+    } else {
+        // Mapping can fail, e.g. in a small address space; read it instead.
+        m_buffer = m_file.readAll();
+        m_file.close();
+        if (m_buffer.size() != size) {
+            m_errorString = QStringLiteral("تعذرت قراءة الملف كاملاً");
+            m_buffer.clear();
+            m_data = nullptr;
+            m_size = 0;
+            return false;
+        }
+        m_data = m_buffer.constData();
+        m_size = m_buffer.size();
+    }
+
+    const qint64 bom = (m_size >= 3 && std::memcmp(m_data, "\xEF\xBB\xBF", 3) == 0) ? 3 : 0;
+    m_filePath = filePath;
+    m_errorString.clear();
+    m_checkpoints = {bom};
+    m_lineCount = 1;
+    m_indexedTo = bom;
+    m_cachedLine = -1;
+    m_decodedLines.clear();
+    m_widestLine = 0;
+    m_currentLine = 0;
+    m_matchStart = bom;
+    m_matchLength = 0;
+
+    indexPendingBytes();
+    verticalScrollBar()->setValue(0);
+    viewport()->update();
+    return true;
+}
+
+void TLargeFileView::indexPendingBytes() {
+    QElapsedTimer slice;
+    slice.start();
+    while (isIndexing() && !slice.hasExpired(Constants::Timing::LargeFileIndexSliceBudget)) {
+        indexTo(m_indexedTo + IndexChunkBytes);
+    }
+
+    updateScrollBars();
+    viewport()->update();
+    if (isIndexing()) m_indexTimer->start();
+}
+
+void TLargeFileView::finishIndexing() {
+    if (!isIndexing()) return;
+    m_indexTimer->stop();
+    indexTo(m_size);
+    updateScrollBars();
+    viewport()->update();
+}
+
+void TLargeFileView::indexTo(qint64 end) {
+    end = qMin(end, m_size);
+    const char *cursor = m_data + m_indexedTo;
+    const char *const stop = m_data + end;
+    while (cursor < stop) {
+        const auto *newline = static_cast<const char *>(std::memchr(cursor, '\n', stop - cursor));
+        if (!newline) break;
+        cursor = newline + 1;
+        if (m_lineCount % LinesPerCheckpoint == 0) m_checkpoints.append(cursor - m_data);
+        ++m_lineCount;
+    }
+    m_indexedTo = qMax(m_indexedTo, end);
+}
+
+void TLargeFileView::ensureLineIndexed(int line) {
+    while (line >= m_lineCount && isIndexing()) indexTo(m_indexedTo + IndexChunkBytes);
+}
+
+qint64 TLargeFileView::lineStart(int line) {
+    ensureLineIndexed(line);
+    line = qBound(0, line, m_lineCount - 1);
+
+    int from = line - line % LinesPerCheckpoint;
+    qint64 start = m_checkpoints[line / LinesPerCheckpoint];
+    if (m_cachedLine >= from && m_cachedLine <= line) {
+        from = m_cachedLine;
+        start = m_cachedStart;
+    }
+    for (; from < line; ++from) {
+        start = static_cast<const char *>(std::memchr(m_data + start, '\n', m_size - start)) - m_data + 1;
+    }
+
+    m_cachedLine = line;
+    m_cachedStart = start;
+    return start;
+}
+
+qint64 TLargeFileView::lineEnd(qint64 start) const {
+    const auto *newline = static_cast<const char *>(std::memchr(m_data + start, '\n', m_size - start));
+    return newline ? newline - m_data : m_size;
+}
+
+int TLargeFileView::lineAt(qint64 offset) {
+    if (offset >= m_indexedTo) indexTo(offset + 1);
+    if (offset <= m_checkpoints.first()) return 0;
+
+    const auto checkpoint = std::upper_bound(m_checkpoints.cbegin(), m_checkpoints.cend(), offset) - 1;
+    const int line = int(checkpoint - m_checkpoints.cbegin()) * LinesPerCheckpoint;
+    return line + int(std::count(m_data + *checkpoint, m_data + offset, '\n'));
+}
+
+QString TLargeFileView::lineText(int line) {
+    if (!m_data || line < 0) return {};
+    if (const auto cached = m_decodedLines.constFind(line); cached != m_decodedLines.cend()) return *cached;
+
+    ensureLineIndexed(line);
+    if (line >= m_lineCount) return {};
+
+    const qint64 start = lineStart(line);
+    if (m_decodedLines.size() >= DecodedLineCacheLimit) m_decodedLines.clear();
+    return *m_decodedLines.insert(line, QString::fromUtf8(m_data + start, decodedEnd(start) - start));
+}
+
+qint64 TLargeFileView::decodedEnd(qint64 start) const {
+    qint64 end = lineEnd(start);
+    if (end > start && m_data[end - 1] == '\r') --end;
+    if (end - start > MaxLineBytes) {
+        end = start + MaxLineBytes;
+        // Don't cut a UTF-8 sequence in half.
+        while (end > start && (static_cast<unsigned char>(m_data[end]) & 0xC0) == 0x80) --end;
+    }
+    return end;
+}
+
+void TLargeFileView::goToLine(int line) {
+    setCurrentLine(line);
+    verticalScrollBar()->setValue(m_currentLine - pageLines() / 2);
+}
+
+void TLargeFileView::setCurrentLine(int line) {
+    ensureLineIndexed(line);
+    m_currentLine = qBound(0, line, m_lineCount - 1);
+    m_matchStart = lineStart(m_currentLine);
+    m_matchLength = 0;
+    updateScrollBars();
+    viewport()->update();
+}
+
+void TLargeFileView::revealLine(int line, bool center) {
+    QScrollBar *bar = verticalScrollBar();
+    const int page = pageLines();
+    if (line >= bar->value() && line < bar->value() + page) return;
+
+    if (center) {
+        bar->setValue(line - page / 2);
+    } else {
+        bar->setValue(line < bar->value() ? line : line - page + 1);
+    }
+}
+
+void TLargeFileView::moveToStart() {
+    setCurrentLine(0);
+}
+
+void TLargeFileView::moveToEnd() {
+    finishIndexing();
+    setCurrentLine(m_lineCount - 1);
+    m_matchStart = m_size;
+}
+
+bool TLargeFileView::find(const QString &text, QTextDocument::FindFlags flags) {
+    if (!m_data || text.isEmpty()) return false;
+
+    const QByteArray needle = text.toUtf8();
+    const bool backward = flags & QTextDocument::FindBackward;
+    qint64 found = backward ? findBackward(needle, m_matchStart, flags)
+                            : findForward(needle, m_matchStart + m_matchLength, m_size, flags);
+    int line = 0;
+    qint64 start = 0;
+    for (; found >= 0; found = backward ? findBackward(needle, decodedEnd(start), flags)
+                                        : findForward(needle, lineEnd(start), m_size, flags)) {
+        line = lineAt(found);
+        start = lineStart(line);
+        if (found + needle.size() <= decodedEnd(start)) break;
+    }
+    if (found < 0) return false;
+
+    m_currentLine = line;
+    m_matchStart = found;
+    m_matchLength = needle.size();
+    // Within the decoded part of the line, so at most MaxLineBytes.
+    m_matchColumn = int(QString::fromUtf8(m_data + start, found - start).size());
+    m_matchColumns = int(text.size());
+    updateScrollBars();
+    revealLine(m_currentLine, true);
+    revealMatch();
+    viewport()->update();
+    return true;
+}
+
+void TLargeFileView::revealMatch() {
+    const int width = viewport()->width() - gutterWidth();
+    QTextLayout layout(lineText(m_currentLine), font());
+    layout.setTextOption(lineOption());
+    layout.beginLayout();
+    QTextLine textLine = layout.createLine();
+    if (textLine.isValid()) textLine.setLineWidth(width);
+    layout.endLayout();
+    if (!textLine.isValid()) return;
+
+    // The scroll range must cover this line before scrolling along it.
+    const int natural = qCeil(textLine.naturalTextWidth());
+    if (natural > m_widestLine) {
+        m_widestLine = natural;
+        updateScrollBars();
+    }
+
+    // paintEvent() draws the layout `shift` pixels right of the text area.
+    QScrollBar *hbar = horizontalScrollBar();
+    const int shift = isRightToLeft() ? hbar->value() : hbar->maximum() - hbar->value();
+    const qreal a = textLine.cursorToX(m_matchColumn);
+    const qreal b = textLine.cursorToX(m_matchColumn + m_matchColumns);
+    if (qMin(a, b) + shift >= 0 && qMax(a, b) + shift <= width) return;
+
+    const int centered = qRound(width / 2.0 - (a + b) / 2);
+    hbar->setValue(isRightToLeft() ? centered : hbar->maximum() - centered);
+}
+
+QTextOption TLargeFileView::lineOption() {
+    QTextOption option(Qt::AlignRight);
+    option.setTextDirection(Qt::RightToLeft);
+    option.setWrapMode(QTextOption::NoWrap);
+    option.setTabStopDistance(32);
+    return option;
+}
+
+qint64 TLargeFileView::findForward(const QByteArray &needle, qint64 from, qint64 to,
+                                   QTextDocument::FindFlags flags) const {
+    const char *const last = m_data + to;
+    auto search = [&](const auto &searcher) -> qint64 {
+        for (const char *at = m_data + from; at < last; ++at) {
+            at = std::search(at, last, searcher);
+            if (at == last) break;
+            if (!(flags & QTextDocument::FindWholeWords) || isWholeWordAt(at - m_data, needle.size())) {
+                return at - m_data;
+            }
+        }
+        return -1;
+    };
+
+    if (flags & QTextDocument::FindCaseSensitively) {
+        return search(std::boyer_moore_horspool_searcher(needle.cbegin(), needle.cend()));
+    }
+    return search(std::boyer_moore_horspool_searcher(needle.cbegin(), needle.cend(), FoldedHash{}, FoldedEqual{}));
+}
+
+qint64 TLargeFileView::findBackward(const QByteArray &needle, qint64 before,
+                                    QTextDocument::FindFlags flags) const {
+    // Search forward through windows that step back from `before`; adjacent
+    // windows overlap by one byte less than the needle.
+    const qint64 length = needle.size();
+    const qint64 window = qMax(IndexChunkBytes, 4 * length);
+    for (qint64 end = before; end >= length;) {
+        const qint64 begin = qMax<qint64>(0, end - window);
+        qint64 found = -1;
+        for (qint64 at = findForward(needle, begin, end, flags); at >= 0 && at + length <= end;
+             at = findForward(needle, at + 1, end, flags)) {
+            found = at;
+        }
+        if (found >= 0) return found;
+        if (begin == 0) break;
+        end = begin + length - 1;
+    }
+    return -1;
+}
+
+bool TLargeFileView::isWholeWordAt(qint64 offset, qint64 length) const {
+    const bool startsWord = offset == 0 || !isWordByte(static_cast<unsigned char>(m_data[offset - 1]));
+    const bool endsWord = offset + length >= m_size
+                          || !isWordByte(static_cast<unsigned char>(m_data[offset + length]));
+    return startsWord && endsWord;
+}
+
+int TLargeFileView::gutterWidth() const {
+    int digits = 1;
+    for (int max = qMax(1, m_lineCount); max >= 10; max /= 10) ++digits;
+    return 30 + fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits;
+}
+
+int TLargeFileView::pageLines() const {
+    return qMax(1, viewport()->height() / fontMetrics().height());
+}
+
+void TLargeFileView::updateScrollBars() {
+    const int page = pageLines();
+    verticalScrollBar()->setSingleStep(1);
+    verticalScrollBar()->setPageStep(page);
+    verticalScrollBar()->setRange(0, qMax(0, m_lineCount - page));
+
+    const int textWidth = viewport()->width() - gutterWidth();
+    horizontalScrollBar()->setSingleStep(fontMetrics().averageCharWidth() * 4);
+    horizontalScrollBar()->setPageStep(textWidth);
+    horizontalScrollBar()->setRange(0, qMax(0, m_widestLine - textWidth));
+}
+
+void TLargeFileView::paintEvent(QPaintEvent *event) {
+    QPainter painter(viewport());
+    const QRect area = viewport()->rect();
+    painter.fillRect(event->rect(), QColor(Constants::Colors::EditorBackground));
+
+    const int lineHeight = fontMetrics().height();
+    const int gutter = gutterWidth();
+    const QRect textArea(area.left(), area.top(), area.width() - gutter, area.height());
+    // Lines are right-aligned, so their overflow is on the left.
+    const QScrollBar *hbar = horizontalScrollBar();
+    const int shift = isRightToLeft() ? hbar->value() : hbar->maximum() - hbar->value();
+
+    const QTextOption option = lineOption();
+
+    QTextCharFormat matchFormat;
+    matchFormat.setBackground(QColor(Constants::Colors::Selection));
+    matchFormat.setForeground(QColor(Constants::Colors::TextPrimary));
+
+    QVector<TGutterRenderer::Row> rows;
+    int widest = m_widestLine;
+    painter.setPen(QColor(Constants::Colors::TextSecondary));
+    for (int line = verticalScrollBar()->value(), y = 0; line < m_lineCount && y < area.height();
+         ++line, y += lineHeight) {
+        rows.append({line, y, lineHeight, TGutterRenderer::Marker::None});
+        if (y + lineHeight <= event->rect().top() || y > event->rect().bottom()) continue;
+
+        if (line == m_currentLine) {
+            painter.fillRect(QRect(textArea.left(), y, textArea.width(), lineHeight),
+                             QColor(Constants::Colors::CurrentLineHighlight));
+        }
+
+        QTextLayout layout(lineText(line), font());
+        layout.setTextOption(option);
+        layout.beginLayout();
+        QTextLine textLine = layout.createLine();
+        if (textLine.isValid()) {
+            textLine.setLineWidth(textArea.width());
+            textLine.setPosition(QPointF(0, (lineHeight - textLine.height()) / 2));
+        }
+        layout.endLayout();
+        if (textLine.isValid()) widest = qMax(widest, qCeil(textLine.naturalTextWidth()));
+
+        QList<QTextLayout::FormatRange> selections;
+        if (line == m_currentLine && m_matchLength > 0) {
+            QTextLayout::FormatRange match;
+            match.start = m_matchColumn;
+            match.length = m_matchColumns;
+            match.format = matchFormat;
+            selections.append(match);
+        }
+
+        painter.save();
+        painter.setClipRect(textArea);
+        layout.draw(&painter, QPointF(textArea.left() + shift, y), selections);
+        painter.restore();
+    }
+
+    painter.translate(textArea.right() + 1, 0);
+    painter.setFont(font());
+    m_gutterRenderer.paint(painter, QRect(0, 0, gutter, area.height()), gutter, lineHeight, rows);
+
+    if (widest != m_widestLine) {
+        m_widestLine = widest;
+        updateScrollBars();
+    }
+}
+
+void TLargeFileView::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void TLargeFileView::scrollContentsBy(int, int) {
+    viewport()->update();
+}
+
+void TLargeFileView::keyPressEvent(QKeyEvent *event) {
+    if (event == QKeySequence::Copy) {
+        QGuiApplication::clipboard()->setText(lineText(m_currentLine));
+        return;
+    }
+
+    int line = m_currentLine;
+    if (event == QKeySequence::MoveToPreviousLine) {
+        line -= 1;
+    } else if (event == QKeySequence::MoveToNextLine) {
+        line += 1;
+    } else if (event == QKeySequence::MoveToPreviousPage) {
+        line -= pageLines();
+    } else if (event == QKeySequence::MoveToNextPage) {
+        line += pageLines();
+    } else if (event == QKeySequence::MoveToStartOfDocument) {
+        line = 0;
+    } else if (event == QKeySequence::MoveToEndOfDocument) {
+        finishIndexing();
+        line = m_lineCount - 1;
+    } else {
+        QAbstractScrollArea::keyPressEvent(event);
+        return;
+    }
+
+    setCurrentLine(line);
+    revealLine(m_currentLine, false);
+}
+
+void TLargeFileView::mousePressEvent(QMouseEvent *event) {
+    const int line = verticalScrollBar()->value() + event->position().toPoint().y() / fontMetrics().height();
+    if (line < m_lineCount) setCurrentLine(line);
+    QAbstractScrollArea::mousePressEvent(event);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "TGutterRenderer.h"
+
+#include <QAbstractScrollArea>
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QTextDocument>
+#include <QTimer>
+#include <QVector>
+
+// Read-only tab for files above the large-file threshold, which are too big
+// to load into a TEditor.
+//
+// The file is memory-mapped (or read into one buffer if mapping fails) and
+// never converted to a QString as a whole. A sparse line index, one offset
+// every LinesPerCheckpoint lines, is built with memchr in slices bounded by
+// Constants::Timing::LargeFileIndexSliceBudget, so the tab is usable at
+// once and the scroll range grows as indexing proceeds. Only the lines on
+// screen are decoded from UTF-8. No highlighter, fold engine or completion
+// index is attached.
+class TLargeFileView : public QAbstractScrollArea {
+    Q_OBJECT
+public:
+    explicit TLargeFileView(QWidget *parent = nullptr);
+
+    // Maps `filePath`; on failure returns false and sets errorString().
+    bool openFile(const QString &filePath);
+    QString errorString() const { return m_errorString; }
+    QString currentFilePath() const { return m_filePath; }
+
+    // Lines found so far; final once isIndexing() is false.
+    int lineCount() const { return m_lineCount; }
+    bool isIndexing() const { return m_indexedTo < m_size; }
+    // Indexes the rest of the file now, e.g. before asking for a line number.
+    void finishIndexing();
+
+    // Text of the 0-based `line`, without its line break. Very long lines
+    // are cut at MaxLineBytes.
+    QString lineText(int line);
+
+    // 0-based line the view is positioned on, moved by goToLine(), find()
+    // and clicks.
+    int currentLine() const { return m_currentLine; }
+    void goToLine(int line);
+
+    // Searches from the current match, or the current line, like
+    // QPlainTextEdit::find(). Case folding only applies to ASCII, since
+    // Arabic has no case. Matches past the MaxLineBytes cut of a long line
+    // cannot be shown and are skipped. Returns false if there is no match.
+    bool find(const QString &text, QTextDocument::FindFlags flags = {});
+    // Restarts searching at the start or the end of the file.
+    void moveToStart();
+    void moveToEnd();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private slots:
+    void indexPendingBytes();
+
+private:
+    static constexpr int LinesPerCheckpoint = 1024;
+    static constexpr qint64 IndexChunkBytes = 1 << 20;
+    static constexpr qint64 MaxLineBytes = 1 << 16;
+    static constexpr int DecodedLineCacheLimit = 2048;
+
+    // Scans for line breaks up to byte `end`.
+    void indexTo(qint64 end);
+    void ensureLineIndexed(int line);
+
+    qint64 lineStart(int line);
+    qint64 lineEnd(qint64 start) const;
+    // End of the part of the line at `start` that lineText() decodes.
+    qint64 decodedEnd(qint64 start) const;
+    // Line holding byte `offset`.
+    int lineAt(qint64 offset);
+
+    // First match in [from, to), or -1.
+    qint64 findForward(const QByteArray &needle, qint64 from, qint64 to, QTextDocument::FindFlags flags) const;
+    // Last match ending at or before `before`, or -1.
+    qint64 findBackward(const QByteArray &needle, qint64 before, QTextDocument::FindFlags flags) const;
+    bool isWholeWordAt(qint64 offset, qint64 length) const;
+
+    int gutterWidth() const;
+    int pageLines() const;
+    void updateScrollBars();
+    // Moves the current line there, dropping the match.
+    void setCurrentLine(int line);
+    // Scrolls `line` into view, centered if `center` is set.
+    void revealLine(int line, bool center);
+    // Scrolls horizontally until the match on the current line is in view.
+    void revealMatch();
+    static QTextOption lineOption();
+
+    QFile m_file{};
+    QByteArray m_buffer{};
+    const char *m_data{};
+    qint64 m_size{};
+    QString m_filePath{};
+    QString m_errorString{};
+
+    // m_checkpoints[k] is the byte offset of line k * LinesPerCheckpoint.
+    QVector<qint64> m_checkpoints{};
+    int m_lineCount{1};
+    qint64 m_indexedTo{};
+    QTimer *m_indexTimer{};
+
+    // Last line start looked up, so consecutive lines cost one memchr each.
+    int m_cachedLine{-1};
+    qint64 m_cachedStart{};
+    QHash<int, QString> m_decodedLines{};
+    TGutterRenderer m_gutterRenderer{};
+    int m_widestLine{};
+
+    int m_currentLine{};
+    // Last match; a zero length marks where the next search starts.
+    qint64 m_matchStart{};
+    qint64 m_matchLength{};
+    // The match in lineText(m_currentLine), decoded once by find().
+    int m_matchColumn{};
+    int m_matchColumns{};
+};
@@ -0,0 +1,260 @@
+#include "TMultiCursor.h"
+
+#include <QClipboard>
+#include <QGuiApplication>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <algorithm>
+
+namespace {
+bool overlaps(const QTextCursor &a, const QTextCursor &b) {
+    return a.selectionStart() == b.selectionStart()
+        or (a.selectionStart() < b.selectionEnd() and b.selectionStart() < a.selectionEnd());
+}
+
+bool precedes(const QTextCursor &a, const QTextCursor &b) {
+    return a.selectionStart() < b.selectionStart()
+        or (a.selectionStart() == b.selectionStart() and a.selectionEnd() < b.selectionEnd());
+}
+
+QString plainSelection(const QTextCursor &cursor) {
+    return cursor.selectedText().replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+}
+}
+
+TMultiCursor::TMultiCursor(QPlainTextEdit *editor) : m_editor(editor) {}
+
+QList<QTextCursor> TMultiCursor::cursors() const {
+    QList<QTextCursor> all = m_cursors;
+    const QTextCursor primary = m_editor->textCursor();
+    all.insert(std::lower_bound(all.begin(), all.end(), primary, precedes), primary);
+    return all;
+}
+
+void TMultiCursor::clear() {
+    m_cursors.clear();
+    m_wholeWords = false;
+}
+
+QString TMultiCursor::occurrenceText() {
+    QTextCursor primary = m_editor->textCursor();
+    if (!primary.hasSelection()) {
+        primary.select(QTextCursor::WordUnderCursor);
+        if (!primary.hasSelection()) return {};
+        m_editor->setTextCursor(primary);
+        m_wholeWords = true;
+    }
+
+    // QTextDocument::find() does not match across lines.
+    const QString text = primary.selectedText();
+    return text.contains(QChar::ParagraphSeparator) ? QString() : text;
+}
+
+void TMultiCursor::addNextOccurrence() {
+    if (!m_editor->textCursor().hasSelection() and !isActive()) {
+        occurrenceText();
+        return;
+    }
+    const QString text = occurrenceText();
+    if (text.isEmpty()) return;
+
+    // The newest occurrence becomes the editor's cursor, so it scrolls
+    // into view and the next search starts after it.
+    QTextDocument::FindFlags flags = QTextDocument::FindCaseSensitively;
+    if (m_wholeWords) flags |= QTextDocument::FindWholeWords;
+    const QTextCursor primary = m_editor->textCursor();
+    QTextCursor found = m_editor->document()->find(text, primary.selectionEnd(), flags);
+    if (found.isNull()) found = m_editor->document()->find(text, 0, flags);
+    if (found.isNull() or isOccupied(found)) return;
+
+    m_cursors.append(primary);
+    m_editor->setTextCursor(found);
+    normalize();
+}
+
+void TMultiCursor::selectAllOccurrences() {
+    const QString text = occurrenceText();
+    if (text.isEmpty()) return;
+
+    QTextDocument::FindFlags flags = QTextDocument::FindCaseSensitively;
+    if (m_wholeWords) flags |= QTextDocument::FindWholeWords;
+    const QTextCursor primary = m_editor->textCursor();
+    m_cursors.clear();
+    for (QTextCursor found = m_editor->document()->find(text, 0, flags); !found.isNull();
+         found = m_editor->document()->find(text, found.selectionEnd(), flags)) {
+        if (!overlaps(found, primary)) m_cursors.append(found);
+    }
+    normalize();
+}
+
+void TMultiCursor::addCursorVertically(int direction) {
+    const QList<QTextCursor> all = cursors();
+    const QTextCursor &edge = direction < 0 ? all.first() : all.last();
+    const int column = edge.positionInBlock();
+
+    // Folded lines are skipped, as the caret itself would skip them.
+    QTextBlock block = direction < 0 ? edge.block().previous() : edge.block().next();
+    while (block.isValid() and !block.isVisible()) block = direction < 0 ? block.previous() : block.next();
+    if (!block.isValid()) return;
+
+    QTextCursor cursor(block);
+    cursor.setPosition(block.position() + std::min(column, block.length() - 1));
+    addCursor(cursor);
+}
+
+void TMultiCursor::addCursor(const QTextCursor &cursor) {
+    if (isOccupied(cursor)) return;
+    m_cursors.append(cursor);
+    normalize();
+}
+
+void TMultiCursor::selectColumn(int anchorPosition, int position) {
+    QTextDocument *document = m_editor->document();
+    const QTextBlock anchorBlock = document->findBlock(anchorPosition);
+    const QTextBlock headBlock = document->findBlock(position);
+    if (!anchorBlock.isValid() or !headBlock.isValid()) return;
+
+    const int anchorColumn = anchorPosition - anchorBlock.position();
+    const int headColumn = position - headBlock.position();
+    const int first = std::min(anchorBlock.blockNumber(), headBlock.blockNumber());
+    const int last = std::max(anchorBlock.blockNumber(), headBlock.blockNumber());
+
+    m_cursors.clear();
+    m_wholeWords = false;
+    QTextCursor head;
+    for (QTextBlock block = document->findBlockByNumber(first);
+         block.isValid() and block.blockNumber() <= last; block = block.next()) {
+        if (!block.isVisible()) continue;
+        const int length = block.length() - 1;
+        QTextCursor cursor(block);
+        cursor.setPosition(block.position() + std::min(anchorColumn, length));
+        cursor.setPosition(block.position() + std::min(headColumn, length), QTextCursor::KeepAnchor);
+        if (block == headBlock) head = cursor;
+        else m_cursors.append(cursor);
+    }
+    if (!head.isNull()) m_editor->setTextCursor(head);
+    normalize();
+}
+
+bool TMultiCursor::handleKeyPress(QKeyEvent *e) {
+    if (!isActive()) return false;
+
+    if (e->key() == Qt::Key_Escape) {
+        clear();
+        return true;
+    }
+
+    if (e->matches(QKeySequence::Copy) or e->matches(QKeySequence::Cut)) {
+        QStringList selections;
+        for (const QTextCursor &cursor : cursors()) {
+            if (cursor.hasSelection()) selections << plainSelection(cursor);
+        }
+        if (selections.isEmpty()) return true;
+        QGuiApplication::clipboard()->setText(selections.join(QLatin1Char('\n')));
+        if (e->matches(QKeySequence::Cut)) edit([](QTextCursor &cursor) { cursor.removeSelectedText(); });
+        return true;
+    }
+
+    if (e->matches(QKeySequence::Paste)) {
+        const QString text = QGuiApplication::clipboard()->text();
+        // One line per cursor when the counts match, as after a copy from
+        // the same cursors; otherwise the whole text at each.
+        const QStringList lines = text.split(QLatin1Char('\n'));
+        const bool spread = lines.size() == m_cursors.size() + 1;
+        int index = 0;
+        edit([&](QTextCursor &cursor) { cursor.insertText(spread ? lines[index++] : text); });
+        return true;
+    }
+
+    const Qt::KeyboardModifiers modifiers = e->modifiers() & ~Qt::KeypadModifier;
+    const bool control = modifiers & Qt::ControlModifier;
+    const auto mode = (modifiers & Qt::ShiftModifier) ? QTextCursor::KeepAnchor : QTextCursor::MoveAnchor;
+
+    QTextCursor::MoveOperation move = QTextCursor::NoMove;
+    switch (e->key()) {
+    case Qt::Key_Backspace:
+        edit([](QTextCursor &cursor) {
+            if (cursor.hasSelection()) cursor.removeSelectedText();
+            else cursor.deletePreviousChar();
+        });
+        return true;
+    case Qt::Key_Delete:
+        edit([](QTextCursor &cursor) {
+            if (cursor.hasSelection()) cursor.removeSelectedText();
+            else cursor.deleteChar();
+        });
+        return true;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        edit([](QTextCursor &cursor) { cursor.insertBlock(); });
+        return true;
+    case Qt::Key_Tab:
+        edit([](QTextCursor &cursor) { cursor.insertText(QStringLiteral("\t")); });
+        return true;
+    case Qt::Key_Left: move = control ? QTextCursor::WordLeft : QTextCursor::Left; break;
+    case Qt::Key_Right: move = control ? QTextCursor::WordRight : QTextCursor::Right; break;
+    case Qt::Key_Up: move = QTextCursor::Up; break;
+    case Qt::Key_Down: move = QTextCursor::Down; break;
+    case Qt::Key_Home: move = QTextCursor::StartOfLine; break;
+    case Qt::Key_End: move = QTextCursor::EndOfLine; break;
+    default: break;
+    }
+
+    if (move != QTextCursor::NoMove) {
+        if (modifiers & (Qt::AltModifier | Qt::MetaModifier)) return false;
+        QTextCursor primary = m_editor->textCursor();
+        primary.movePosition(move, mode);
+        for (QTextCursor &cursor : m_cursors) cursor.movePosition(move, mode);
+        m_editor->setTextCursor(primary);
+        normalize();
+        return true;
+    }
+
+    // AltGr arrives as Ctrl+Alt on some platforms and still types text.
+    const QString text = e->text();
+    const bool shortcut = (modifiers & (Qt::ControlModifier | Qt::MetaModifier)) and !(modifiers & Qt::AltModifier);
+    if (!shortcut and !text.isEmpty() and text.at(0).isPrint()) {
+        edit([&text](QTextCursor &cursor) { cursor.insertText(text); });
+        return true;
+    }
+    return false;
+}
+
+void TMultiCursor::edit(const std::function<void(QTextCursor &)> &apply) {
+    QTextCursor primary = m_editor->textCursor();
+    primary.beginEditBlock();
+    // In document order, so `apply` can count its way through the cursors.
+    // Each cursor is live: the document shifts it past earlier edits.
+    bool primaryDone = false;
+    for (QTextCursor &cursor : m_cursors) {
+        if (!primaryDone and !precedes(cursor, primary)) {
+            apply(primary);
+            primaryDone = true;
+        }
+        apply(cursor);
+    }
+    if (!primaryDone) apply(primary);
+    primary.endEditBlock();
+
+    m_editor->setTextCursor(primary);
+    normalize();
+}
+
+bool TMultiCursor::isOccupied(const QTextCursor &cursor) const {
+    const QList<QTextCursor> all = cursors();
+    return std::any_of(all.cbegin(), all.cend(), [&cursor](const QTextCursor &other) { return overlaps(cursor, other); });
+}
+
+void TMultiCursor::normalize() {
+    std::sort(m_cursors.begin(), m_cursors.end(), precedes);
+    const QTextCursor primary = m_editor->textCursor();
+    QList<QTextCursor> kept;
+    kept.reserve(m_cursors.size());
+    for (const QTextCursor &cursor : std::as_const(m_cursors)) {
+        if (overlaps(cursor, primary)) continue;
+        if (!kept.isEmpty() and overlaps(kept.last(), cursor)) continue;
+        kept.append(cursor);
+    }
+    m_cursors = std::move(kept);
+    if (m_cursors.isEmpty()) m_wholeWords = false;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QKeyEvent>
+#include <QList>
+#include <QPlainTextEdit>
+#include <QTextCursor>
+#include <functional>
+
+// Extra carets and selections for TEditor, on top of QPlainTextEdit's own
+// cursor. Extracted from TEditor like TBracketHandler.
+//
+// An edit made at several cursors runs inside one QTextDocument edit block.
+// The document then emits a single contentsChange for the whole batch, so
+// layout, highlighting and the word index each run once, and the edit
+// undoes in one step. The extra cursors are plain QTextCursors, which the
+// document keeps in place as text changes around them.
+class TMultiCursor {
+public:
+    explicit TMultiCursor(QPlainTextEdit *editor);
+
+    bool isActive() const { return !m_cursors.isEmpty(); }
+    // The editor's cursor followed by the extra ones, in document order.
+    QList<QTextCursor> cursors() const;
+    const QList<QTextCursor> &extraCursors() const { return m_cursors; }
+    void clear();
+
+    // Selects the word under the cursor if nothing is selected; otherwise
+    // adds a selection at the next occurrence of the selected text,
+    // wrapping at the end of the document.
+    void addNextOccurrence();
+    // Adds a selection at every occurrence of the selected text (or word).
+    void selectAllOccurrences();
+    // Adds a caret on the line above (-1) or below (1) the outermost
+    // cursor, in the same column.
+    void addCursorVertically(int direction);
+    void addCursor(const QTextCursor &cursor);
+    // Box selection: one selection per line between the two positions,
+    // spanning the same columns on each line.
+    void selectColumn(int anchorPosition, int position);
+
+    // Types, deletes, pastes or moves at every cursor. Returns true if the
+    // key was consumed; keys it leaves alone act on the editor's cursor.
+    bool handleKeyPress(QKeyEvent *e);
+
+    // Applies `apply` at every cursor inside one edit block.
+    void edit(const std::function<void(QTextCursor &)> &apply);
+
+private:
+    // Text the occurrence commands look for; selects the word under the
+    // cursor first if nothing is selected.
+    QString occurrenceText();
+    bool isOccupied(const QTextCursor &cursor) const;
+    // Drops cursors that coincide or overlap, keeping document order.
+    void normalize();
+
+    QPlainTextEdit *m_editor{};
+    QList<QTextCursor> m_cursors{};
+    // Occurrences started from a bare caret match whole words only.
+    bool m_wholeWords{false};
+};
@@ -1,226 +1,307 @@
 #include "AutoComplete.h"
 #include "../highlighter/TSyntaxDefinition.h"
-#include <QRegularExpression>
+#include "../TDocumentSnapshot.h"
+#include "WorkspaceWordIndex.h"
 #include <QSet>
 
-// --- Keyword Strategy ---
-// Reads from the single source of truth: LanguageDefinition::instance()
+// --- Completion History ---
+
+TCompletionHistory &TCompletionHistory::shared() {
+    static TCompletionHistory history;
+    return history;
+}
 
-QVector<CompletionItem> KeywordStrategy::getSuggestions(const QString &prefix, const QString &) {
-    QVector<CompletionItem> items;
-    if (prefix.isEmpty()) return items;
+void TCompletionHistory::record(const QString &label) {
+    Use &use = m_uses[label];
+    ++use.count;
+    use.last = ++m_clock;
 
-    const auto &keywords = LanguageDefinition::instance().keywordList;
-    for (const auto &k : keywords) {
-        if (k.startsWith(prefix, Qt::CaseInsensitive)) {
-            items.push_back(CompletionItem(k, k, "كلمة محجوزة", CompletionType::Keyword));
+    // Forget the least recently chosen label beyond the cap.
+    if (m_uses.size() > Constants::Completion::HistorySize) {
+        auto oldest = m_uses.begin();
+        for (auto it = m_uses.begin(); it != m_uses.end(); ++it) {
+            if (it->last < oldest->last) oldest = it;
         }
+        m_uses.erase(oldest);
     }
-    return items;
 }
 
-// --- Built-ins Strategy ---
-// Reads from the single source of truth: LanguageDefinition::instance()
+int TCompletionHistory::boost(const QString &label) const {
+    if (m_uses.isEmpty()) return 0;
+    const auto it = m_uses.constFind(label);
+    if (it == m_uses.cend()) return 0;
+
+    // Frequency and recency each weigh about as much as a prefix match.
+    constexpr int PerUse = 3;
+    constexpr int MaxUses = 8;
+    constexpr int RecentWindow = 16;
+    const quint64 age = m_clock - it->last;
+    const int recency = age < RecentWindow ? int(RecentWindow - age) : 0;
+    return std::min(it->count, MaxUses) * PerUse + recency;
+}
 
-QVector<CompletionItem> BuiltinStrategy::getSuggestions(const QString &prefix, const QString &) {
-    QVector<CompletionItem> items{};
-    if (prefix.isEmpty()) return items;
+void TCompletionHistory::clear() {
+    m_uses.clear();
+    m_clock = 0;
+}
 
-    const auto &builtins = LanguageDefinition::instance().builtinList;
-    for (const auto &b : builtins) {
-        if (b.startsWith(prefix, Qt::CaseInsensitive)) {
-            items.push_back(CompletionItem(b, b, "دالة ضمن لغة باء", CompletionType::Builtin));
-        }
-    }
-    return items;
+// --- Completion Collector ---
+
+TCompletionCollector::TCompletionCollector(const QString &prefix, const TCompletionHistory *history, int limit)
+    : m_prefix(prefix), m_matcher(prefix), m_history(history), m_limit(std::max(limit, 1)) {}
+
+bool TCompletionCollector::keeps(int score) const {
+    // A newcomer loses ties to what was offered before it.
+    return qsizetype(m_ranked.size()) < m_limit || score > m_ranked.front().score;
 }
 
-// --- Snippet Strategy ---
-// Code templates for common Baa constructs
-QVector<CompletionItem> SnippetStrategy::getSuggestions(const QString &prefix, const QString &) {
-    QVector<CompletionItem> items;
-    QString p = prefix.toLower();
-
-    // Main function template (§5.4)
-    if (QString("الرئيسية").startsWith(p) || QString("main").startsWith(p)) {
-        items.push_back(CompletionItem("الرئيسية (دالة)",
-                         "صحيح الرئيسية() {\n\t\n\tإرجع ٠.\n}",
-                         "الدالة الرئيسية - نقطة بداية البرنامج",
-                         CompletionType::Snippet, SnippetId::Main));
-    }
+bool TCompletionCollector::holds(const QString &label) const {
+    return std::any_of(m_ranked.cbegin(), m_ranked.cend(),
+                       [&label](const Ranked &ranked) { return ranked.item.label == label; });
+}
 
-    // Function template (§5.1)
-    if (QString("دالة").startsWith(p) || QString("function").startsWith(p)) {
-        items.push_back(CompletionItem("دالة جديدة",
-                         "صحيح اسم_الدالة(صحيح معامل) {\n\t\n\tإرجع ٠.\n}",
-                         "قالب دالة جديدة",
-                         CompletionType::Snippet, SnippetId::Function));
-    }
+std::vector<CompletionItem> TCompletionCollector::take() {
+    std::sort_heap(m_ranked.begin(), m_ranked.end(), ranksAbove);
+    std::vector<CompletionItem> items;
+    items.reserve(m_ranked.size());
+    for (Ranked &ranked : m_ranked) items.push_back(std::move(ranked.item));
+    m_ranked.clear();
+    return items;
+}
 
-    // If statement (§7.1)
-    if (QString("إذا").startsWith(p)) {
-        items.push_back(CompletionItem("إذا (شرط)",
-                         "إذا (الشرط) {\n\t\n}",
-                         "جملة شرطية - تنفذ إذا تحقق الشرط",
-                         CompletionType::Snippet, SnippetId::If));
-    }
+// --- Keyword Strategy ---
+// Reads from the single source of truth: LanguageDefinition::instance()
 
-    // If-else statement (§7.1)
-    if (QString("إذا_وإلا").contains(p) || QString("ifelse").startsWith(p)) {
-        items.push_back(CompletionItem("إذا-وإلا",
-                         "إذا (الشرط) {\n\t\n} وإلا {\n\t\n}",
-                         "جملة شرطية مع بديل",
-                         CompletionType::Snippet, SnippetId::IfElse));
-    }
+void KeywordStrategy::query(TCompletionCollector &collector) {
+    if (collector.prefix().isEmpty()) return;
 
-    // Else clause (§7.1)
-    if (QString("وإلا").startsWith(p)) {
-        items.push_back(CompletionItem("وإلا",
-                         "وإلا {\n\t\n}",
-                         "تتمة الجملة الشرطية - تنفذ إذا لم يتحقق الشرط",
-                         CompletionType::Snippet, SnippetId::Else));
+    for (const auto &k : LanguageDefinition::instance().keywordList) {
+        collector.offer(k, [&k] { return CompletionItem(k, k, "كلمة محجوزة", CompletionType::Keyword); });
     }
+}
 
-    // Else-if clause (§7.1)
-    if (QString("وإلا_إذا").contains(p)) {
-        items.push_back(CompletionItem("وإلا إذا",
-                         "وإلا إذا (الشرط) {\n\t\n}",
-                         "شرط إضافي في الجملة الشرطية",
-                         CompletionType::Snippet, SnippetId::ElseIf));
-    }
+// --- Built-ins Strategy ---
+// Reads from the single source of truth: LanguageDefinition::instance()
 
-    // For loop (§7.3) - note: uses Arabic semicolon ؛
-    if (QString("لكل").startsWith(p) || QString("for").startsWith(p)) {
-        items.push_back(CompletionItem("لكل (حلقة)",
-                         "لكل (صحيح س = ٠؛ س < ١٠؛ س++) {\n\t\n}",
-                         "حلقة تكرارية محددة العدد (For)",
-                         CompletionType::Snippet, SnippetId::ForLoop));
-    }
+void BuiltinStrategy::query(TCompletionCollector &collector) {
+    if (collector.prefix().isEmpty()) return;
 
-    // While loop (§7.2)
-    if (QString("طالما").startsWith(p) || QString("while").startsWith(p)) {
-        items.push_back(CompletionItem("طالما (حلقة)",
-                         "طالما (الشرط) {\n\t\n}",
-                         "حلقة تكرارية شرطية (While)",
-                         CompletionType::Snippet, SnippetId::WhileLoop));
+    for (const auto &b : LanguageDefinition::instance().builtinList) {
+        collector.offer(b, [&b] { return CompletionItem(b, b, "دالة ضمن لغة باء", CompletionType::Builtin); });
     }
+}
 
-    // Switch statement (§7.5)
-    if (QString("اختر").startsWith(p) || QString("switch").startsWith(p)) {
-        items.push_back(CompletionItem("اختر (تحويل)",
-                         "اختر (المتغير) {\n\tحالة ١:\n\t\t\n\t\tتوقف.\n\tحالة ٢:\n\t\t\n\t\tتوقف.\n\tافتراضي:\n\t\t\n\t\tتوقف.\n}",
-                         "جملة الاختيار المتعدد (Switch)",
-                         CompletionType::Snippet, SnippetId::Switch));
-    }
+// --- Snippet Strategy ---
+// Code templates for common Baa constructs
 
-    // Array declaration (§3.3)
-    if (QString("مصفوفة").startsWith(p) || QString("array").startsWith(p)) {
-        items.push_back(CompletionItem("مصفوفة",
-                         "صحيح المصفوفة[١٠].",
-                         "تعريف مصفوفة ثابتة الحجم",
-                         CompletionType::Snippet, SnippetId::Array));
-    }
+namespace {
+struct SnippetTemplate {
+    CompletionItem item;
+    // Names the template is found by; it ranks by the best matching one.
+    QStringList names;
+};
+
+const std::vector<SnippetTemplate> &snippetTemplates() {
+    static const std::vector<SnippetTemplate> templates{
+        // Main function template (§5.4)
+        {CompletionItem("الرئيسية (دالة)", "صحيح الرئيسية() {\n\t\n\tإرجع ٠.\n}",
+                        "الدالة الرئيسية - نقطة بداية البرنامج", CompletionType::Snippet, SnippetId::Main),
+         {"الرئيسية", "main"}},
+        // Function template (§5.1)
+        {CompletionItem("دالة جديدة", "صحيح اسم_الدالة(صحيح معامل) {\n\t\n\tإرجع ٠.\n}",
+                        "قالب دالة جديدة", CompletionType::Snippet, SnippetId::Function),
+         {"دالة", "function"}},
+        // If statement (§7.1)
+        {CompletionItem("إذا (شرط)", "إذا (الشرط) {\n\t\n}",
+                        "جملة شرطية - تنفذ إذا تحقق الشرط", CompletionType::Snippet, SnippetId::If),
+         {"إذا"}},
+        // If-else statement (§7.1)
+        {CompletionItem("إذا-وإلا", "إذا (الشرط) {\n\t\n} وإلا {\n\t\n}",
+                        "جملة شرطية مع بديل", CompletionType::Snippet, SnippetId::IfElse),
+         {"إذا_وإلا", "ifelse"}},
+        // Else clause (§7.1)
+        {CompletionItem("وإلا", "وإلا {\n\t\n}",
+                        "تتمة الجملة الشرطية - تنفذ إذا لم يتحقق الشرط", CompletionType::Snippet, SnippetId::Else),
+         {"وإلا"}},
+        // Else-if clause (§7.1)
+        {CompletionItem("وإلا إذا", "وإلا إذا (الشرط) {\n\t\n}",
+                        "شرط إضافي في الجملة الشرطية", CompletionType::Snippet, SnippetId::ElseIf),
+         {"وإلا_إذا"}},
+        // For loop (§7.3) - note: uses Arabic semicolon ؛
+        {CompletionItem("لكل (حلقة)", "لكل (صحيح س = ٠؛ س < ١٠؛ س++) {\n\t\n}",
+                        "حلقة تكرارية محددة العدد (For)", CompletionType::Snippet, SnippetId::ForLoop),
+         {"لكل", "for"}},
+        // While loop (§7.2)
+        {CompletionItem("طالما (حلقة)", "طالما (الشرط) {\n\t\n}",
+                        "حلقة تكرارية شرطية (While)", CompletionType::Snippet, SnippetId::WhileLoop),
+         {"طالما", "while"}},
+        // Switch statement (§7.5)
+        {CompletionItem("اختر (تحويل)",
+                        "اختر (المتغير) {\n\tحالة ١:\n\t\t\n\t\tتوقف.\n\tحالة ٢:\n\t\t\n\t\tتوقف.\n\tافتراضي:\n\t\t\n\t\tتوقف.\n}",
+                        "جملة الاختيار المتعدد (Switch)", CompletionType::Snippet, SnippetId::Switch),
+         {"اختر", "switch"}},
+        // Array declaration (§3.3)
+        {CompletionItem("مصفوفة", "صحيح المصفوفة[١٠].",
+                        "تعريف مصفوفة ثابتة الحجم", CompletionType::Snippet, SnippetId::Array),
+         {"مصفوفة", "array"}},
+        // Constant declaration (§4)
+        {CompletionItem("ثابت (متغير)", "ثابت صحيح الاسم = القيمة.",
+                        "تعريف ثابت لا يمكن تغيير قيمته", CompletionType::Snippet, SnippetId::Constant),
+         {"ثابت", "const"}},
+    };
+    return templates;
+}
+}
 
-    // Constant declaration (§4)
-    if (QString("ثابت").startsWith(p) || QString("const").startsWith(p)) {
-        items.push_back(CompletionItem("ثابت (متغير)",
-                         "ثابت صحيح الاسم = القيمة.",
-                         "تعريف ثابت لا يمكن تغيير قيمته",
-                         CompletionType::Snippet, SnippetId::Constant));
+void SnippetStrategy::query(TCompletionCollector &collector) {
+    for (const SnippetTemplate &snippet : snippetTemplates()) {
+        int best = TFuzzyMatcher::NoMatch;
+        for (const QString &name : snippet.names) best = std::max(best, collector.matcher().score(name));
+        collector.offer(best, snippet.item.label, [&snippet] { return snippet.item; });
     }
-
-    return items;
 }
 
 // --- Preprocessor Strategy ---
 // Reads from the single source of truth: LanguageDefinition::instance()
 
-QVector<CompletionItem> PreprocessorStrategy::getSuggestions(const QString &prefix, const QString &) {
-    QVector<CompletionItem> items;
-    if (prefix.isEmpty()) return items;
-
-    // Check if prefix starts with # or matches directive name without #
-    bool startsWithHash = prefix.startsWith('#') || prefix.startsWith(QString("#"));
+namespace {
+// Description and inserted text of directive `d`.
+CompletionItem directiveItem(const QString &d) {
+    QString desc;
+    QString completion = d;
+
+    if (d == "#تضمين") {
+        desc = "تضمين ملف خارجي (Include)";
+        completion = "#تضمين \"ملف.baahd\"";
+    } else if (d == "#تعريف") {
+        desc = "تعريف ماكرو ثابت (Define)";
+        completion = "#تعريف الاسم القيمة";
+    } else if (d == "#إذا_عرف") {
+        desc = "شرط المعالجة القبلية (Ifdef)";
+        completion = "#إذا_عرف الاسم\n\t\n#نهاية";
+    } else if (d == "#وإلا") {
+        desc = "فرع بديل في شرط المعالجة (Else)";
+    } else if (d == "#نهاية") {
+        desc = "إنهاء شرط المعالجة القبلية (Endif)";
+    } else if (d == "#الغاء_تعريف") {
+        desc = "إلغاء تعريف ماكرو (Undef)";
+        completion = "#الغاء_تعريف الاسم";
+    }
 
-    const auto &directives = LanguageDefinition::instance().preprocessorList;
-    for (const auto &d : directives) {
-        bool matches = false;
+    return CompletionItem(d, completion, desc, CompletionType::Preprocessor);
+}
+}
 
-        if (startsWithHash) {
-            // Match with the # prefix
-            matches = d.startsWith(prefix, Qt::CaseInsensitive);
-        } else {
-            // Match without # (user typing just the Arabic part)
-            QString withoutHash = d.mid(1); // Remove the #
-            matches = withoutHash.startsWith(prefix, Qt::CaseInsensitive);
-        }
+void PreprocessorStrategy::query(TCompletionCollector &collector) {
+    const QString &prefix = collector.prefix();
+    if (prefix.isEmpty()) return;
 
-        if (matches) {
-            QString desc;
-            QString completion = d;
-
-            if (d == "#تضمين") {
-                desc = "تضمين ملف خارجي (Include)";
-                completion = "#تضمين \"ملف.baahd\"";
-            } else if (d == "#تعريف") {
-                desc = "تعريف ماكرو ثابت (Define)";
-                completion = "#تعريف الاسم القيمة";
-            } else if (d == "#إذا_عرف") {
-                desc = "شرط المعالجة القبلية (Ifdef)";
-                completion = "#إذا_عرف الاسم\n\t\n#نهاية";
-            } else if (d == "#وإلا") {
-                desc = "فرع بديل في شرط المعالجة (Else)";
-            } else if (d == "#نهاية") {
-                desc = "إنهاء شرط المعالجة القبلية (Endif)";
-            } else if (d == "#الغاء_تعريف") {
-                desc = "إلغاء تعريف ماكرو (Undef)";
-                completion = "#الغاء_تعريف الاسم";
-            }
+    // With # typed, match the whole directive; otherwise just the Arabic
+    // part after the #.
+    const bool startsWithHash = prefix.startsWith('#');
 
-            items.push_back(CompletionItem(d, completion, desc, CompletionType::Preprocessor));
-        }
+    for (const auto &d : LanguageDefinition::instance().preprocessorList) {
+        const QStringView name = startsWithHash ? QStringView(d) : QStringView(d).sliced(1);
+        collector.offer(collector.matcher().score(name), d, [&d] { return directiveItem(d); });
     }
+}
 
-    return items;
+const std::vector<ICompletionStrategy*> &sharedCompletionStrategies() {
+    static SnippetStrategy snippets;
+    static KeywordStrategy keywords;
+    static BuiltinStrategy builtins;
+    static PreprocessorStrategy preprocessor;
+    static const std::vector<ICompletionStrategy*> strategies{&snippets, &keywords, &builtins, &preprocessor};
+    return strategies;
 }
 
 // --- Dynamic Word Strategy ---
-QVector<CompletionItem> DynamicWordStrategy::getSuggestions(const QString &prefix, const QString &) {
-    QVector<CompletionItem> items;
-    if (prefix.length() < 2) return items;
-
-    // Query the pre-built index instead of regex scanning everything
-    for (const auto &word : wordIndex) {
-        if (word != prefix && word.startsWith(prefix, Qt::CaseInsensitive)) {
-            items.push_back(CompletionItem(word, word, "نص ضمن الملف الحالي", CompletionType::DynamicWord));
-        }
-    }
-
-    return items;
+TCompletionQuery DynamicWordStrategy::prepare() const {
+    return [words = wordIndex.snapshot()](TCompletionCollector &collector) {
+        const QString &prefix = collector.prefix();
+        if (prefix.length() < 2) return;
+
+        words->forEachCandidate(collector.matcher(), [&](const QString &word, int) {
+            if (word != prefix) {
+                collector.offer(word, [&word] {
+                    return CompletionItem(word, word, "نص ضمن الملف الحالي", CompletionType::DynamicWord);
+                });
+            }
+            return !collector.isCancelled();
+        });
+    };
 }
 
-void DynamicWordStrategy::rebuildIndex(const QString &fullText) {
-    wordIndex.clear();
-    static QRegularExpression re("[a-zA-Z0-9_\u0600-\u06FF_0-9]+");
-    QRegularExpressionMatchIterator i = re.globalMatch(fullText);
+namespace {
+// The characters of "[a-zA-Z0-9_\u0600-\u06FF]+", tested without a regex
+// since every edit runs this over the lines it touched.
+bool isWordChar(QChar ch) {
+    const char16_t u = ch.unicode();
+    return (u >= u'a' && u <= u'z') || (u >= u'A' && u <= u'Z') || (u >= u'0' && u <= u'9')
+        || u == u'_' || (u >= 0x0600 && u <= 0x06FF);
+}
 
-    while (i.hasNext()) {
-        QString word = i.next().captured(0);
-        if (word.length() >= 2) {
-            wordIndex.insert(word);
+// Calls function(word) for each word of at least two characters in `line`.
+template <typename Function>
+void forEachWord(QStringView line, Function &&function) {
+    const qsizetype size = line.size();
+    for (qsizetype i = 0; i < size;) {
+        if (!isWordChar(line[i])) {
+            ++i;
+            continue;
         }
+        const qsizetype start = i;
+        while (i < size && isWordChar(line[i])) ++i;
+        if (i - start >= 2) function(line.sliced(start, i - start));
     }
 }
+}
 
-void DynamicWordStrategy::updateIndex(const QString &text) {
-    // Basic implementation: just add new words from the changed text
-    static QRegularExpression re("[a-zA-Z0-9_\u0600-\u06FF_0-9]+");
-    QRegularExpressionMatchIterator i = re.globalMatch(text);
+TWordIndex DynamicWordStrategy::collectWords(const TDocumentSnapshot &snapshot) {
+    TWordIndex words;
+    snapshot.forEachLine([&words](const QString &line) {
+        forEachWord(line, [&words](QStringView word) { words.add(word.toString()); });
+    });
+    return words;
+}
 
-    while (i.hasNext()) {
-        QString word = i.next().captured(0);
-        if (word.length() >= 2) {
-            wordIndex.insert(word);
-        }
+TWordIndex DynamicWordStrategy::collectWords(QStringView text) {
+    // Line breaks are not word characters, so the text is one long line.
+    TWordIndex words;
+    forEachWord(text, [&words](QStringView word) { words.add(word.toString()); });
+    return words;
+}
+
+void DynamicWordStrategy::replaceLines(const TDocumentSnapshot &before, const TDocumentSnapshot &after,
+                                       int first, int removed, int added) {
+    // Copies the index if a completion query still reads it.
+    TWordIndex &words = wordIndex.edit();
+    // New words first: a word that only moved within an edited line keeps
+    // its entry instead of leaving the index and coming back.
+    for (int i = first; i < first + added; ++i) {
+        forEachWord(after.line(i), [&words](QStringView word) { words.add(word.toString()); });
+    }
+    for (int i = first; i < first + removed; ++i) {
+        forEachWord(before.line(i), [&words](QStringView word) { words.remove(word.toString()); });
     }
 }
+
+// --- Workspace Word Strategy ---
+TCompletionQuery WorkspaceWordStrategy::prepare() const {
+    return [words = WorkspaceWordIndex::instance()->snapshot(),
+            localWords = local->snapshot()](TCompletionCollector &collector) {
+        const QString &prefix = collector.prefix();
+        if (prefix.length() < 2) return;
+
+        words->forEachCandidate(collector.matcher(), [&](const QString &word, int) {
+            if (word == prefix) return true;
+            const int score = collector.matcher().score(word);
+            if (score != TFuzzyMatcher::NoMatch && localWords->occurrences(word) == 0) {
+                collector.offer(score, word, [&word] {
+                    return CompletionItem(word, word, "من ملفات المشروع", CompletionType::DynamicWord);
+                });
+            }
+            return !collector.isCancelled();
+        });
+    };
+}
@@ -1,9 +1,21 @@
 #pragma once
 
+#include <QHash>
 #include <QString>
 #include <QVector>
 #include <QStringList>
 #include <QSet>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Constants.h"
+#include "TFuzzyMatcher.h"
+#include "TWordIndex.h"
+
+class TDocumentSnapshot;
 
 enum CompletionType {
     Keyword,
@@ -44,40 +56,162 @@ struct CompletionItem {
         : label(l), completion(c), description(d), type(t), snippetId(sid) {}
 };
 
+// Completions the user accepted, by label, shared by every editor. A
+// label chosen often or lately ranks higher next time.
+class TCompletionHistory {
+public:
+    static TCompletionHistory &shared();
+
+    void record(const QString &label);
+    // Score added to `label`'s match score; zero if never chosen.
+    int boost(const QString &label) const;
+    void clear();
+
+private:
+    struct Use {
+        int count{};
+        quint64 last{};
+    };
+    QHash<QString, Use> m_uses{};
+    quint64 m_clock{};
+};
+
+// Keeps the best `limit` items the strategies offer for one prefix, ranked
+// by fuzzy score plus the history boost, in a bounded heap. An item is only
+// built once it is known to make the cut, so a prefix matching thousands
+// of words builds at most a few dozen CompletionItems.
+class TCompletionCollector {
+public:
+    explicit TCompletionCollector(const QString &prefix, const TCompletionHistory *history = nullptr,
+                                  int limit = Constants::Completion::MaxItems);
+
+    const QString &prefix() const { return m_prefix; }
+    const TFuzzyMatcher &matcher() const { return m_matcher; }
+
+    // Set by whoever asked for the items once they are no longer wanted;
+    // strategies walking many words stop when it is.
+    void setCancelFlag(std::shared_ptr<const std::atomic_bool> flag) { m_cancelled = std::move(flag); }
+    bool isCancelled() const { return m_cancelled && m_cancelled->load(std::memory_order_relaxed); }
+
+    // Offers the item make() builds, matched and remembered as `label`.
+    template <typename Make>
+    void offer(const QString &label, Make &&make) {
+        offer(m_matcher.score(label), label, std::forward<Make>(make));
+    }
+    // The same with a match score already known, e.g. the best of several
+    // names the item goes by.
+    template <typename Make>
+    void offer(int score, const QString &label, Make &&make) {
+        if (score == TFuzzyMatcher::NoMatch) return;
+        if (m_history) score += m_history->boost(label);
+        if (!keeps(score) || holds(label)) return;
+        m_ranked.push_back({score, m_offered++, make()});
+        std::push_heap(m_ranked.begin(), m_ranked.end(), ranksAbove);
+        if (qsizetype(m_ranked.size()) > m_limit) {
+            std::pop_heap(m_ranked.begin(), m_ranked.end(), ranksAbove);
+            m_ranked.pop_back();
+        }
+    }
+
+    // The kept items, best first; empties the collector.
+    std::vector<CompletionItem> take();
+
+private:
+    struct Ranked {
+        int score;
+        // Order of offering: on equal scores the earlier strategy wins.
+        quint64 serial;
+        CompletionItem item;
+    };
+    // Heap order: the front is the weakest kept item.
+    static bool ranksAbove(const Ranked &a, const Ranked &b) {
+        return a.score > b.score || (a.score == b.score && a.serial < b.serial);
+    }
+    bool keeps(int score) const;
+    bool holds(const QString &label) const;
+
+    QString m_prefix;
+    TFuzzyMatcher m_matcher;
+    const TCompletionHistory *m_history{};
+    qsizetype m_limit{};
+    quint64 m_offered{};
+    std::vector<Ranked> m_ranked{};
+    std::shared_ptr<const std::atomic_bool> m_cancelled{};
+};
+
+// Offers a strategy's items to a collector. It only reads what it captured
+// when it was prepared, so it may run on any thread.
+using TCompletionQuery = std::function<void(TCompletionCollector &)>;
+
 // Abstract Strategy Interface
 class ICompletionStrategy {
 public:
     virtual ~ICompletionStrategy() = default;
-    virtual QVector<CompletionItem> getSuggestions(const QString &prefix, const QString &fullText) = 0;
+    // Called on the GUI thread: captures the strategy's current words in a
+    // query that keeps working while the editor goes on changing.
+    virtual TCompletionQuery prepare() const = 0;
+    // Offers every item matching collector.prefix() to `collector`, now.
+    void suggest(TCompletionCollector &collector) const { prepare()(collector); }
 };
 
 // --- Concrete Strategies ---
+// These read the language tables and fixed templates only, so their
+// queries capture nothing.
 
 class KeywordStrategy : public ICompletionStrategy {
 public:
-    QVector<CompletionItem> getSuggestions(const QString &prefix, const QString &text) override;
+    TCompletionQuery prepare() const override { return &query; }
+    static void query(TCompletionCollector &collector);
 };
 
 class BuiltinStrategy : public ICompletionStrategy {
 public:
-    QVector<CompletionItem> getSuggestions(const QString &prefix, const QString &text) override;
+    TCompletionQuery prepare() const override { return &query; }
+    static void query(TCompletionCollector &collector);
 };
 
 class SnippetStrategy : public ICompletionStrategy {
 public:
-    QVector<CompletionItem> getSuggestions(const QString &prefix, const QString &text) override;
+    TCompletionQuery prepare() const override { return &query; }
+    static void query(TCompletionCollector &collector);
 };
 
 class PreprocessorStrategy : public ICompletionStrategy {
 public:
-    QVector<CompletionItem> getSuggestions(const QString &prefix, const QString &text) override;
+    TCompletionQuery prepare() const override { return &query; }
+    static void query(TCompletionCollector &collector);
 };
 
+// The snippet, keyword, builtin and preprocessor strategies hold no state,
+// so one instance of each, in that suggestion order, serves every editor.
+const std::vector<ICompletionStrategy*> &sharedCompletionStrategies();
+
 class DynamicWordStrategy : public ICompletionStrategy {
-    QSet<QString> wordIndex;
+    TSharedWordIndex wordIndex;
+public:
+    TCompletionQuery prepare() const override;
+    void rebuildIndex(const TDocumentSnapshot &snapshot) { wordIndex.reset(collectWords(snapshot)); }
+    // Words rebuildIndex() would find, with their counts; safe to call
+    // from any thread.
+    static TWordIndex collectWords(const TDocumentSnapshot &snapshot);
+    // The same for text not open in an editor, such as a file on disk.
+    static TWordIndex collectWords(QStringView text);
+    const TWordIndex &words() const { return *wordIndex; }
+    std::shared_ptr<const TWordIndex> snapshot() const { return wordIndex.snapshot(); }
+    // Follows TDocumentMirror::linesReplaced: the words of the replaced
+    // lines of `before` leave the index and those of the new lines of
+    // `after` enter it, so it stays equal to collectWords(after).
+    void replaceLines(const TDocumentSnapshot &before, const TDocumentSnapshot &after,
+                      int first, int removed, int added);
+};
+
+// Words of the other Baa files in the open folder, from
+// WorkspaceWordIndex. Words the editor's own index already offers are
+// left to it.
+class WorkspaceWordStrategy : public ICompletionStrategy {
+    const DynamicWordStrategy *local;
 public:
-    QVector<CompletionItem> getSuggestions(const QString &prefix, const QString &fullText) override;
-    void rebuildIndex(const QString &fullText);
-    void updateIndex(const QString &text); // Incremental update (optional for now)
+    explicit WorkspaceWordStrategy(const DynamicWordStrategy *local) : local(local) {}
+    TCompletionQuery prepare() const override;
 };
 
@@ -0,0 +1,104 @@
+#include "TFuzzyMatcher.h"
+
+#include <algorithm>
+
+namespace {
+constexpr int MatchBonus = 10;
+constexpr int StartBonus = 12;
+constexpr int BoundaryBonus = 12;
+constexpr int ConsecutiveBonus = 8;
+// All typed characters matched at the very start, as a plain prefix would.
+constexpr int PrefixBonus = 30;
+constexpr int GapPenalty = 2;
+constexpr int MaxGapPenalty = 20;
+constexpr int MaxTrailingPenalty = 10;
+
+bool isBoundary(QChar previous, QChar ch) {
+    return previous == QLatin1Char('_') || previous.isDigit() != ch.isDigit();
+}
+}
+
+TFuzzyMatcher::TFuzzyMatcher(QStringView pattern)
+    : m_pattern(fold(pattern.toString())), m_mask(maskOf(m_pattern)) {}
+
+QChar TFuzzyMatcher::foldChar(QChar ch) {
+    const char16_t u = ch.unicode();
+    if (u < 0x80) return (u >= u'A' && u <= u'Z') ? QChar(char16_t(u + (u'a' - u'A'))) : ch;
+    switch (u) {
+    case 0x0622: case 0x0623: case 0x0625: case 0x0671: return QChar(0x0627); // آ أ إ ٱ → ا
+    case 0x0624: return QChar(0x0648);                                         // ؤ → و
+    case 0x0626: case 0x0649: return QChar(0x064A);                            // ئ ى → ي
+    case 0x0629: return QChar(0x0647);                                         // ة → ه
+    case 0x0640: return QChar();                                               // tatweel
+    default: break;
+    }
+    if ((u >= 0x064B && u <= 0x065F) || u == 0x0670) return QChar();          // harakat
+    return ch.toCaseFolded();
+}
+
+QString TFuzzyMatcher::fold(const QString &text) {
+    const auto changes = [](QChar ch) { return foldChar(ch) != ch; };
+    const auto first = std::find_if(text.cbegin(), text.cend(), changes);
+    if (first == text.cend()) return text;
+
+    QString folded;
+    folded.reserve(text.size());
+    folded.append(QStringView(text.cbegin(), first));
+    for (auto it = first; it != text.cend(); ++it) {
+        const QChar ch = foldChar(*it);
+        if (!ch.isNull()) folded.append(ch);
+    }
+    return folded;
+}
+
+quint64 TFuzzyMatcher::maskOf(QStringView folded) {
+    quint64 mask = 0;
+    for (QChar ch : folded) mask |= quint64(1) << (ch.unicode() % 64);
+    return mask;
+}
+
+int TFuzzyMatcher::score(QStringView candidate) const {
+    const qsizetype length = m_pattern.size();
+    if (length == 0) return 0;
+
+    int score = 0;
+    int gaps = 0;
+    int trailing = 0;
+    qsizetype matched = 0;
+    qsizetype position = 0;
+    bool prefix = true;
+    bool previousMatched = false;
+    QChar previous;
+    // Greedy: each typed character takes its first occurrence after the
+    // previous one.
+    for (QChar raw : candidate) {
+        const QChar ch = foldChar(raw);
+        if (ch.isNull()) continue;
+        if (matched < length && ch == m_pattern[matched]) {
+            score += MatchBonus;
+            if (position == 0) score += StartBonus;
+            else if (previousMatched) score += ConsecutiveBonus;
+            else if (isBoundary(previous, ch)) score += BoundaryBonus;
+            ++matched;
+            previousMatched = true;
+        } else {
+            if (matched < length) {
+                ++gaps;
+                prefix = false;
+            } else {
+                ++trailing;
+            }
+            previousMatched = false;
+        }
+        previous = ch;
+        ++position;
+    }
+    if (matched < length) return NoMatch;
+    // One letter scattered somewhere inside says too little.
+    if (length == 1 && !prefix) return NoMatch;
+
+    if (prefix) score += PrefixBonus;
+    score -= std::min(gaps * GapPenalty, MaxGapPenalty);
+    score -= std::min(trailing, MaxTrailingPenalty);
+    return std::max(score, 0);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+// Scores completion candidates against what the user typed.
+//
+// A candidate matches when the typed characters appear in it in order,
+// not necessarily next to each other; a single character only matches at
+// the start. Both sides are folded first: case is ignored, the hamza
+// forms أ إ آ ٱ count as ا, ؤ as و, ئ and ى as ي and ة as ه, and tatweel
+// and harakat are skipped, so "اكبر" finds "أكبر".
+//
+// The score rewards a match at the start of the candidate, runs of
+// consecutive characters and matches right after '_' or a digit, and
+// penalizes the characters skipped in between.
+class TFuzzyMatcher {
+public:
+    static constexpr int NoMatch = -1;
+
+    explicit TFuzzyMatcher(QStringView pattern);
+
+    // Folded pattern.
+    const QString &pattern() const { return m_pattern; }
+    // maskOf(pattern()): a candidate whose mask lacks one of these bits
+    // cannot match.
+    quint64 mask() const { return m_mask; }
+
+    // Zero or more for a match, higher is better; NoMatch otherwise.
+    int score(QStringView candidate) const;
+
+    // Folded form of `ch`, or a null QChar for characters matching skips.
+    static QChar foldChar(QChar ch);
+    // `text` folded; shares its data when folding changes nothing.
+    static QString fold(const QString &text);
+    // One bit per folded character of `folded`, hashed into 64 bits.
+    static quint64 maskOf(QStringView folded);
+
+private:
+    QString m_pattern{};
+    quint64 m_mask{};
+};
@@ -0,0 +1,64 @@
+#include "TWordIndex.h"
+
+void TWordIndex::add(const QString &word, int occurrences) {
+    if (occurrences <= 0) return;
+    Key key{TFuzzyMatcher::fold(word), word};
+    if (m_chunks.empty()) m_chunks.emplace(Key{}, std::make_shared<Chunk>());
+
+    const auto it = chunkFor(m_chunks, key);
+    const auto at = find(*it->second, key) - it->second->cbegin();
+    Chunk &chunk = writable(it);
+    if (at < qsizetype(chunk.size()) && chunk[at].key == key) {
+        chunk[at].entry.occurrences += occurrences;
+        return;
+    }
+
+    const quint64 mask = TFuzzyMatcher::maskOf(key.folded);
+    chunk.insert(chunk.begin() + at, Slot{std::move(key), Entry{occurrences, mask}});
+    ++m_size;
+
+    // Split in halves; the upper one is fenced by its first key.
+    if (qsizetype(chunk.size()) > MaxChunkSize) {
+        const auto middle = chunk.begin() + chunk.size() / 2;
+        auto upper = std::make_shared<Chunk>(std::make_move_iterator(middle), std::make_move_iterator(chunk.end()));
+        chunk.erase(middle, chunk.end());
+        Key fence = upper->front().key;
+        m_chunks.emplace_hint(std::next(it), std::move(fence), std::move(upper));
+    }
+}
+
+void TWordIndex::remove(const QString &word, int occurrences) {
+    const Key key{TFuzzyMatcher::fold(word), word};
+    const auto it = chunkFor(m_chunks, key);
+    if (it == m_chunks.end()) return;
+    const auto found = find(*it->second, key);
+    if (found == it->second->cend() || !(found->key == key)) return;
+
+    const auto at = found - it->second->cbegin();
+    Chunk &chunk = writable(it);
+    chunk[at].entry.occurrences -= occurrences;
+    if (chunk[at].entry.occurrences > 0) return;
+
+    chunk.erase(chunk.begin() + at);
+    --m_size;
+    // Its keys now fall to the chunk before it.
+    if (chunk.empty() && it != m_chunks.begin()) m_chunks.erase(it);
+}
+
+int TWordIndex::occurrences(const QString &word) const {
+    const Key key{TFuzzyMatcher::fold(word), word};
+    const auto it = chunkFor(m_chunks, key);
+    if (it == m_chunks.cend()) return 0;
+    const auto found = find(*it->second, key);
+    return found != it->second->cend() && found->key == key ? found->entry.occurrences : 0;
+}
+
+TWordIndex::Chunk &TWordIndex::writable(Chunks::iterator it) {
+    if (it->second.use_count() > 1) {
+        it->second = std::make_shared<Chunk>(*it->second);
+    } else {
+        // Pairs with the release of the last other index's reference.
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *it->second;
+}
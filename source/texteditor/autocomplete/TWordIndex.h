@@ -0,0 +1,158 @@
+#pragma once
+
+#include "TFuzzyMatcher.h"
+
+#include <QString>
+#include <QStringView>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Words of a document for DynamicWordStrategy, sorted by folded spelling
+// (TFuzzyMatcher::fold) so the words starting with a prefix are one
+// contiguous range: a lookup costs O(log n + k) for k matches instead of a
+// startsWith() on every word.
+//
+// Each word carries its number of occurrences. remove() takes occurrences
+// away and the word leaves the index when none are left, so a caller that
+// knows what an edit removed never needs to rescan the document.
+//
+// The sorted words are held in chunks of at most MaxChunkSize, shared
+// between copies: copying an index copies one pointer per chunk, and an
+// edit copies only the chunk it changes, if another index still shares it.
+class TWordIndex {
+public:
+    void add(const QString &word, int occurrences = 1);
+    void remove(const QString &word, int occurrences = 1);
+    void clear() {
+        m_chunks.clear();
+        m_size = 0;
+    }
+
+    // Distinct words.
+    qsizetype size() const { return m_size; }
+    int occurrences(const QString &word) const;
+
+    // Calls function(word, occurrences) for every word, in folded order.
+    template <typename Function>
+    void forEach(Function &&function) const {
+        for (const auto &[fence, chunk] : m_chunks) {
+            for (const Slot &slot : *chunk) function(slot.key.word, slot.entry.occurrences);
+        }
+    }
+
+    // Calls function(word, occurrences) for each word starting with
+    // `prefix`, ignoring case and hamza forms, in folded order.
+    template <typename Function>
+    void forEachWithPrefix(QStringView prefix, Function &&function) const {
+        const QString folded = TFuzzyMatcher::fold(prefix.toString());
+        walkFrom(Key{folded, QString()}, [&](const Slot &slot) {
+            if (!slot.key.folded.startsWith(folded)) return false;
+            function(slot.key.word, slot.entry.occurrences);
+            return true;
+        });
+    }
+
+    // Calls function(word, occurrences) for each word starting with the
+    // first character of `matcher`'s pattern and holding all the others,
+    // until it returns false. Only that one-character range is walked, and
+    // words in it lacking a character are skipped after one mask test
+    // without being scored: O(log n + r) for r words sharing the first
+    // character, rather than every word on every keystroke.
+    template <typename Function>
+    void forEachCandidate(const TFuzzyMatcher &matcher, Function &&function) const {
+        const QString first = matcher.pattern().left(1);
+        const quint64 mask = matcher.mask();
+        walkFrom(Key{first, QString()}, [&](const Slot &slot) {
+            if (!slot.key.folded.startsWith(first)) return false;
+            return (slot.entry.mask & mask) != mask || function(slot.key.word, slot.entry.occurrences);
+        });
+    }
+
+private:
+    struct Key {
+        // Shares the word's data when folding changes nothing.
+        QString folded;
+        QString word;
+        bool operator<(const Key &other) const {
+            return folded < other.folded || (folded == other.folded && word < other.word);
+        }
+        bool operator==(const Key &other) const { return folded == other.folded && word == other.word; }
+    };
+    struct Entry {
+        int occurrences{};
+        // TFuzzyMatcher::maskOf(folded)
+        quint64 mask{};
+    };
+    struct Slot {
+        Key key;
+        Entry entry;
+    };
+    // Sorted by key.
+    using Chunk = std::vector<Slot>;
+    // Each chunk under its fence, the least key it may hold: it holds the
+    // keys from its fence up to the next chunk's. The first fence is the
+    // empty Key, and that chunk stays even when emptied.
+    using Chunks = std::map<Key, std::shared_ptr<Chunk>>;
+
+    static constexpr qsizetype MaxChunkSize = 256;
+
+    // The chunk `key` belongs in; end() if there are none.
+    template <typename Map>
+    static auto chunkFor(Map &chunks, const Key &key) {
+        const auto it = chunks.upper_bound(key);
+        return it == chunks.begin() ? it : std::prev(it);
+    }
+    static Chunk::const_iterator find(const Chunk &chunk, const Key &key) {
+        return std::lower_bound(chunk.cbegin(), chunk.cend(), key,
+                                [](const Slot &slot, const Key &k) { return slot.key < k; });
+    }
+    // Calls visit(slot) from the first slot not below `from` on, in order,
+    // until it returns false.
+    template <typename Visit>
+    void walkFrom(const Key &from, Visit &&visit) const {
+        for (auto it = chunkFor(m_chunks, from); it != m_chunks.cend(); ++it) {
+            const Chunk &chunk = *it->second;
+            for (auto slot = find(chunk, from); slot != chunk.cend(); ++slot) {
+                if (!visit(*slot)) return;
+            }
+        }
+    }
+    // The chunk at `it`, copied first if another index shares it.
+    static Chunk &writable(Chunks::iterator it);
+
+    Chunks m_chunks{};
+    qsizetype m_size{};
+};
+
+// A TWordIndex edited on the GUI thread and read by completion queries on
+// another. snapshot() hands out the current index; edit() changes it in
+// place while no snapshot is held and copies it first otherwise. That copy
+// shares every chunk, and the edit then copies the one chunk it changes,
+// so a snapshot never changes under its reader and a keystroke never
+// copies the whole index.
+class TSharedWordIndex {
+public:
+    TSharedWordIndex() : m_index(std::make_shared<TWordIndex>()) {}
+
+    const TWordIndex &operator*() const { return *m_index; }
+    const TWordIndex *operator->() const { return m_index.get(); }
+    std::shared_ptr<const TWordIndex> snapshot() const { return m_index; }
+
+    TWordIndex &edit() {
+        if (m_index.use_count() > 1) {
+            m_index = std::make_shared<TWordIndex>(*m_index);
+        } else {
+            // Pairs with the release of the last reader's reference.
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *m_index;
+    }
+    void reset(TWordIndex index) { m_index = std::make_shared<TWordIndex>(std::move(index)); }
+
+private:
+    std::shared_ptr<TWordIndex> m_index;
+};
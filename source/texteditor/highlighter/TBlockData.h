@@ -0,0 +1,41 @@
+#pragma once
+
+#include "TToken.h"
+
+#include <QTextBlock>
+#include <QTextObject>
+#include <QVector>
+#include <algorithm>
+
+// Per-block data attached by TSyntaxHighlighter as QTextBlockUserData.
+//
+// The token cache is shared by every consumer of the block's tokens
+// (highlighting, folding, hover, bracket handling, completion): it is valid
+// while the block's text is still at `tokenRevision` and the block is still
+// entered in `tokenStartState`.
+//
+// Separately, the highlight is up to date when formats were applied from the
+// state its predecessor currently ends in, at the current text revision and
+// theme generation.
+class TBlockData : public QTextBlockUserData {
+public:
+    QVector<TTokenSpan> tokens{};
+    int tokenRevision{-1};
+    int tokenStartState{-1};
+    int tokenEndState{-1};
+
+    int startState{-1};
+    int revision{-1};
+    int generation{-1};
+
+    // Returns the block's data, or nullptr if it was never lexed.
+    static TBlockData* of(const QTextBlock& block) {
+        return static_cast<TBlockData*>(block.userData());
+    }
+
+    // Copies into the existing storage so a re-lexed block reuses it.
+    void setTokens(const QVector<TTokenSpan>& source) {
+        tokens.resize(source.size());
+        std::copy(source.cbegin(), source.cend(), tokens.begin());
+    }
+};
@@ -0,0 +1,81 @@
+#include "THighlightWorker.h"
+
+#include <QCoreApplication>
+#include <QThread>
+
+namespace {
+QThread* workerThread = nullptr;
+THighlightWorker* worker = nullptr;
+
+void shutdownWorker() {
+    if (!workerThread) return;
+    workerThread->quit();
+    workerThread->wait();
+    delete worker;
+    delete workerThread;
+    worker = nullptr;
+    workerThread = nullptr;
+}
+}
+
+THighlightWorker* THighlightWorker::instance() {
+    if (!worker) {
+        qRegisterMetaType<THighlightResult>();
+
+        workerThread = new QThread;
+        workerThread->setObjectName("THighlightWorker");
+        worker = new THighlightWorker;
+        worker->moveToThread(workerThread);
+        workerThread->start(QThread::LowPriority);
+
+        // Stop the thread before QCoreApplication goes away.
+        qAddPostRoutine(shutdownWorker);
+    }
+    return worker;
+}
+
+void THighlightWorker::submit(THighlightJob job) {
+    QMetaObject::invokeMethod(this, [this, job = std::move(job)]() { run(job); }, Qt::QueuedConnection);
+}
+
+void THighlightWorker::appendFormatRanges(const QVector<TTokenSpan>& tokens,
+                                          const TTokenFormats& formats,
+                                          QList<QTextLayout::FormatRange>& out) {
+    int lastSlot = -1;
+    for (const TTokenSpan& token : tokens) {
+        const int slot = formats.slotOf(token.type);
+        if (slot < 0) {
+            lastSlot = -1;
+            continue;
+        }
+        if (slot == lastSlot && out.last().start + out.last().length == token.start) {
+            out.last().length += token.length;
+            continue;
+        }
+        out.append(QTextLayout::FormatRange{token.start, token.length, formats.format(slot)});
+        lastSlot = slot;
+    }
+}
+
+void THighlightWorker::run(const THighlightJob& job) {
+    THighlightResult result;
+    result.owner = job.owner;
+    result.serial = job.serial;
+    result.firstBlock = job.firstBlock;
+    result.blocks.reserve(job.texts.size());
+
+    int state = job.startState;
+    for (qsizetype i = 0; i < job.texts.size(); ++i) {
+        if (i > 0 && i < job.settledStates.size() && job.settledStates[i] == state) break;
+        THighlightedBlock block;
+        block.revision = job.revisions[i];
+        block.startState = state;
+        state = lexer.tokenize(job.texts[i], state, tokens);
+        block.endState = state;
+        block.tokens = tokens;
+        appendFormatRanges(tokens, job.formats, block.formats);
+        result.blocks.append(std::move(block));
+    }
+
+    emit jobFinished(result);
+}
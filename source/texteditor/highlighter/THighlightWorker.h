@@ -0,0 +1,67 @@
+#pragma once
+
+#include "TLexer.h"
+#include "TSyntaxThemes.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QTextCharFormat>
+#include <QTextLayout>
+#include <QVector>
+
+// A snapshot of consecutive blocks, copied on the GUI thread because
+// QTextDocument must not be touched from the worker.
+struct THighlightJob {
+    quint64 owner{};
+    quint64 serial{};
+    int firstBlock{};
+    int startState{};
+    QStringList texts{};
+    QVector<int> revisions{};
+    // State each block is already highlighted from, or -1. Lexing stops at
+    // the first block whose incoming state matches: the rest is unchanged.
+    QVector<int> settledStates{};
+    TTokenFormats formats{};
+};
+
+struct THighlightedBlock {
+    int revision{};
+    int startState{};
+    int endState{};
+    QVector<TTokenSpan> tokens{};
+    QList<QTextLayout::FormatRange> formats{};
+};
+
+struct THighlightResult {
+    quint64 owner{};
+    quint64 serial{};
+    int firstBlock{};
+    QVector<THighlightedBlock> blocks{};
+};
+
+// Lexes block snapshots off the GUI thread. A single worker on its own
+// thread serves every TSyntaxHighlighter; results are broadcast and each
+// highlighter keeps only its own, still-current ones.
+class THighlightWorker : public QObject {
+    Q_OBJECT
+public:
+    static THighlightWorker* instance();
+
+    // Thread-safe: queues the job on the worker thread.
+    void submit(THighlightJob job);
+
+    // Adjacent tokens sharing a format are merged into a single range.
+    static void appendFormatRanges(const QVector<TTokenSpan>& tokens,
+                                   const TTokenFormats& formats,
+                                   QList<QTextLayout::FormatRange>& out);
+
+signals:
+    void jobFinished(const THighlightResult& result);
+
+private:
+    THighlightWorker() = default;
+    void run(const THighlightJob& job);
+
+    TLexer lexer{};
+    QVector<TTokenSpan> tokens{};
+};
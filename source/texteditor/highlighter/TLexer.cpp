@@ -1,18 +1,8 @@
 #include "TLexer.h"
-
-
+#include "TScanKernels.h"
 
 // ==================== Helpers ====================
 
-static QPair<int, QString> checkStringStart(QStringView text, int pos) {
-    if (pos >= text.length()) return {-1, ""};
-    QChar ch = text[pos];
-    if (ch == '"' || ch == '\'') {
-        return {0, QString(ch)};
-    }
-    return {-1, ""};
-}
-
 static QRegularExpressionMatch matchAt(
     const QRegularExpression &pattern,
     QStringView text,
@@ -33,25 +23,62 @@ static QRegularExpressionMatch matchAt(
 #endif
 }
 
+// ASCII 0-9 without a table lookup; any other decimal digit (Arabic-Indic
+// ٠-٩, Extended Arabic-Indic ۰-۹, ...) by its Unicode category.
+static inline bool isDecimalDigit(QChar ch) {
+    const char16_t c = ch.unicode();
+    return (c >= u'0' && c <= u'9') || (c >= 0x80 && ch.isDigit());
+}
+
+static inline bool isHexDigit(QChar ch) {
+    const char16_t c = ch.unicode();
+    return (c >= u'0' && c <= u'9') || (c >= u'a' && c <= u'f') || (c >= u'A' && c <= u'F');
+}
+
+// The legacy TToken carries a copy of the text for named tokens
+// (identifiers, keywords, operators...). Bulk tokens carry none.
+static QString tokenValue(const TTokenSpan& span, QStringView text) {
+    switch (span.type) {
+    case TokenType::Whitespace:
+    case TokenType::Comment:
+    case TokenType::String:
+    case TokenType::Number:
+        return QString();
+    default:
+        return text.mid(span.start, span.length).toString();
+    }
+}
+
+static QString delimiterFor(int delimId) {
+    return delimId == StateMasks::Single ? QStringLiteral("'") : QStringLiteral("\"");
+}
+
 // ==================== Normal State ====================
 
-TToken NormalState::readToken(QStringView text, int& pos, const LanguageDefinition& langDef) {
-    if (pos >= text.length()) return TToken(TokenType::None, pos, 0);
+TTokenSpan NormalState::scan(QStringView text, int& pos, const LanguageDefinition& langDef, int& state) {
+    const int length = static_cast<int>(text.length());
+    state = StateMasks::Normal;
+    if (pos >= length) return {TokenType::None, pos, 0};
 
     QChar ch = text[pos];
 
     // 1. Whitespace
     if (ch.isSpace()) {
         int start = pos;
-        while (pos < text.length() && text[pos].isSpace()) pos++;
-        return TToken(TokenType::Whitespace, start, pos - start);
+        // Vectorized over ASCII runs; other Unicode spaces are stepped one by one.
+        for (;;) {
+            pos = static_cast<int>(TScanKernels::skipAsciiSpaces(text.utf16(), pos, length));
+            if (pos < length && text[pos].isSpace()) pos++;
+            else break;
+        }
+        return {TokenType::Whitespace, start, pos - start};
     }
 
     // 2. Comments (Baa uses // for single-line comments)
-    if (pos + 1 < text.length() && ch == '/' && text[pos + 1] == '/') {
+    if (pos + 1 < length && ch == '/' && text[pos + 1] == '/') {
         int start = pos;
-        pos = text.length();
-        return TToken(TokenType::Comment, start, pos - start);
+        pos = length;
+        return {TokenType::Comment, start, pos - start};
     }
 
     // 3. Preprocessor directives (start with #)
@@ -60,74 +87,77 @@ TToken NormalState::readToken(QStringView text, int& pos, const LanguageDefiniti
         pos++; // Skip the #
 
         // Read the directive name (Arabic letters and underscores after #)
-        while (pos < text.length() && (text[pos].isLetter() || text[pos] == '_')) {
+        while (pos < length && (text[pos].isLetter() || text[pos] == '_')) {
             pos++;
         }
 
-        QString directive = text.mid(start, pos - start).toString();
-
-        if (langDef.preprocessorSet.contains(directive)) {
-            return TToken(TokenType::Preprocessor, start, pos - start, directive);
+        if (langDef.classify(text.mid(start, pos - start)) == TokenType::Preprocessor) {
+            return {TokenType::Preprocessor, start, pos - start};
         }
 
-        return TToken(TokenType::Operator, start, pos - start, directive);
+        return {TokenType::Operator, start, pos - start};
     }
 
     // 4. Strings
-    auto strCheck = checkStringStart(text, pos);
-    if (strCheck.first != -1) {
+    if (ch == '"' || ch == '\'') {
         int start = pos;
-        QString quote = strCheck.second;
-        
-        pos += quote.length(); 
-
-        int delimId = (quote == "\"") ? StateMasks::Double : StateMasks::Single;
-        pendingState = std::make_unique<StringState>(quote, delimId);
-        return TToken(TokenType::String, start, pos - start);
+        pos++;
+        state = StateMasks::String | (ch == '"' ? StateMasks::Double : StateMasks::Single);
+        return {TokenType::String, start, pos - start};
     }
 
     // 5. Identifiers & Keywords
     if (ch.isLetter() || ch == '_') {
         int start = pos;
-        while (pos < text.length() && (text[pos].isLetterOrNumber() || text[pos] == '_')) pos++;
-        QStringView wordView = text.mid(start, pos - start);
-        QString word = wordView.toString();
+        while (pos < length && (text[pos].isLetterOrNumber() || text[pos] == '_')) pos++;
 
-        if (word == "صواب" || word == "خطأ") return TToken(TokenType::BooleanLiteral, start, pos - start, word);
-        if (langDef.keywordSet.contains(word)) return TToken(TokenType::Keyword, start, pos - start, word);
-        if (langDef.builtinSet.contains(word)) return TToken(TokenType::BuiltinFunc, start, pos - start, word);
-        if (langDef.preprocessorSet.contains(word)) return TToken(TokenType::Preprocessor, start, pos - start, word);
+        // Boolean literals, keywords, builtins and directives in one probe.
+        const TokenType reserved = langDef.classify(text.mid(start, pos - start));
+        if (reserved != TokenType::None) return {reserved, start, pos - start};
 
         // Check for function pattern 'func('
         int next = pos;
-        while(next < text.length() && text[next].isSpace()) next++;
-        if (next < text.length() && text[next] == '(') {
-            return TToken(TokenType::Function, start, pos - start, word);
+        while(next < length && text[next].isSpace()) next++;
+        if (next < length && text[next] == '(') {
+            return {TokenType::Function, start, pos - start};
         }
 
-        return TToken(TokenType::Identifier, start, pos - start, word);
+        return {TokenType::Identifier, start, pos - start};
     }
 
     // 6. Numbers (Integers Only (§3.1))
-    if (ch.isDigit() || ch == u'٠' || ch == u'١' || ch == u'٢' || ch == u'٣' || ch == u'٤' || ch == u'٥' || ch == u'٦' || ch == u'٧' || ch == u'٨' || ch == u'٩') {
+    // The built-in literal forms are scanned by hand; a regex only runs
+    // when baa-language.json supplies its own pattern.
+    if (isDecimalDigit(ch)) {
         int start = pos;
-        if (ch == '0' && pos + 1 < text.length() && text.mid(pos, 2).compare(u"0x", Qt::CaseInsensitive) == 0) {
-            auto m = matchAt(langDef.hexPattern, text, start);
-            if (m.hasMatch()) { pos += m.capturedLength(); return TToken(TokenType::Number, start, m.capturedLength()); }
+        if (ch == '0' && pos + 1 < length && (text[pos + 1] == 'x' || text[pos + 1] == 'X')) {
+            if (langDef.customHexPattern) {
+                auto m = matchAt(langDef.hexPattern, text, start);
+                if (m.hasMatch()) { pos += m.capturedLength(); return {TokenType::Number, start, static_cast<int>(m.capturedLength())}; }
+            } else {
+                int end = pos + 2;
+                while (end < length && isHexDigit(text[end])) end++;
+                if (end > pos + 2) { pos = end; return {TokenType::Number, start, pos - start}; }
+            }
+        }
+        if (langDef.customNumberPattern) {
+            auto m = matchAt(langDef.numberPattern, text, start);
+            if (m.hasMatch()) { pos += m.capturedLength(); return {TokenType::Number, start, static_cast<int>(m.capturedLength())}; }
+        } else {
+            while (pos < length && isDecimalDigit(text[pos])) pos++;
+            if (pos > start) return {TokenType::Number, start, pos - start};
         }
-        auto m = matchAt(langDef.numberPattern, text, start);
-        if (m.hasMatch()) { pos += m.capturedLength(); return TToken(TokenType::Number, start, m.capturedLength()); }
-        pos++; return TToken(TokenType::Number, start, 1);
+        pos++; return {TokenType::Number, start, 1};
     }
 
     // 7. Separators
     if (ch == '.' || ch == u'؛') {
         pos++;
-        return TToken(TokenType::Separator, pos - 1, 1, QString(ch));
+        return {TokenType::Separator, pos - 1, 1};
     }
 
     // 8. Multi-character operators (look-ahead for second character)
-    if (pos + 1 < text.length()) {
+    if (pos + 1 < length) {
         QChar next = text[pos + 1];
         // Two-character operators: ==, !=, <=, >=, &&, ||, ++, --, +=, -=, *=, /=, %=, <<, >>
         if ((ch == '=' and next == '=') or
@@ -147,13 +177,24 @@ TToken NormalState::readToken(QStringView text, int& pos, const LanguageDefiniti
             (ch == '>' and next == '>')) {
             int start = pos;
             pos += 2;
-            return TToken(TokenType::Operator, start, 2, text.mid(start, 2).toString());
+            return {TokenType::Operator, start, 2};
         }
     }
 
     // 9. Single-character operators (fallback)
     pos++;
-    return TToken(TokenType::Operator, pos - 1, 1, QString(ch));
+    return {TokenType::Operator, pos - 1, 1};
+}
+
+TToken NormalState::readToken(QStringView text, int& pos, const LanguageDefinition& langDef) {
+    int state = StateMasks::Normal;
+    const TTokenSpan span = scan(text, pos, langDef, state);
+
+    if ((state & StateMasks::TypeMask) == StateMasks::String) {
+        const int delimId = state & StateMasks::DelimMask;
+        pendingState = std::make_unique<StringState>(delimiterFor(delimId), delimId);
+    }
+    return TToken(span.type, span.start, span.length, tokenValue(span, text));
 }
 
 std::unique_ptr<LexerState> NormalState::nextState() const {
@@ -171,19 +212,27 @@ std::unique_ptr<LexerState> NormalState::clone() const {
 
 StringState::StringState(const QString& delim, int id) : delimiter(delim), delimId(id) {}
 
-TToken StringState::readToken(QStringView text, int& pos, const LanguageDefinition&) {
+TTokenSpan StringState::scan(QStringView text, int& pos, int delimId, int& state) {
+    const int length = static_cast<int>(text.length());
+    const char16_t delimiter = delimId == StateMasks::Single ? u'\'' : u'"';
     int start = pos;
-    while (pos < text.length()) {
-        if (text[pos] == '\\') { pos = qMin(pos + 2, static_cast<int>(text.length())); continue; }
-        if (text.mid(pos).startsWith(delimiter)) {
-            pos += delimiter.length();
-            m_terminated = true;
-            return TToken(TokenType::String, start, pos - start);
-        }
+    while (pos < length) {
+        pos = static_cast<int>(TScanKernels::findQuoteOrBackslash(text.utf16(), pos, length, delimiter));
+        if (pos == length) break;
+        if (text[pos] == u'\\') { pos = qMin(pos + 2, length); continue; }
         pos++;
+        state = StateMasks::Normal;
+        return {TokenType::String, start, pos - start};
     }
-    m_terminated = false;
-    return TToken(TokenType::String, start, pos - start);
+    state = StateMasks::String | delimId;
+    return {TokenType::String, start, pos - start};
+}
+
+TToken StringState::readToken(QStringView text, int& pos, const LanguageDefinition&) {
+    int state = StateMasks::Normal;
+    const TTokenSpan span = scan(text, pos, delimId, state);
+    m_terminated = (state == StateMasks::Normal);
+    return TToken(span.type, span.start, span.length);
 }
 
 std::unique_ptr<LexerState> StringState::nextState() const {
@@ -231,3 +280,30 @@ QVector<TToken> TLexer::tokenize(QStringView text, int initialState) {
     finalState = currentState->getStateId();
     return tokens;
 }
+
+int TLexer::tokenize(QStringView text, int initialState, QVector<TTokenSpan>& out) {
+    out.clear();
+    const int length = static_cast<int>(text.length());
+    int pos = 0;
+
+    int state = initialState;
+    if ((state & StateMasks::TypeMask) != StateMasks::String) state = StateMasks::Normal;
+
+    while (pos < length) {
+        TTokenSpan token;
+        switch (state & StateMasks::TypeMask) {
+        case StateMasks::String:
+            token = StringState::scan(text, pos, state & StateMasks::DelimMask, state);
+            break;
+        default:
+            token = NormalState::scan(text, pos, langDef, state);
+            break;
+        }
+
+        if (token.length > 0) out.append(token);
+        else if (pos < length) pos++;
+    }
+
+    finalState = state;
+    return finalState;
+}
@@ -28,6 +28,10 @@ public:
     std::unique_ptr<LexerState> nextState() const override;
     std::unique_ptr<LexerState> clone() const override;
 
+    // Allocation-free scanner shared by both tokenization paths.
+    // Writes the state id the following token starts in to `state`.
+    static TTokenSpan scan(QStringView text, int& pos, const LanguageDefinition& langDef, int& state);
+
     mutable std::unique_ptr<LexerState> pendingState;
     int getStateId() const override { return StateMasks::Normal; }
 };
@@ -43,6 +47,9 @@ public:
     std::unique_ptr<LexerState> nextState() const override;
     std::unique_ptr<LexerState> clone() const override;
     int getStateId() const override { return StateMasks::String | delimId; }
+
+    // Allocation-free scanner for the body of a string delimited by `delimId`.
+    static TTokenSpan scan(QStringView text, int& pos, int delimId, int& state);
 };
 
 // ==================== Lexer ====================
@@ -51,6 +58,13 @@ class TLexer {
 public:
     TLexer();
     QVector<TToken> tokenize(QStringView text, int initialState);
+
+    // Allocation-free path: clears `out` and fills it with spans into `text`,
+    // driving the state machine by state id instead of heap state objects.
+    // `out` keeps its capacity, so a buffer reused across blocks stops
+    // allocating once it has grown to the busiest block. Returns the end state.
+    int tokenize(QStringView text, int initialState, QVector<TTokenSpan>& out);
+
     int getFinalState() const { return finalState; }
 
 private:
@@ -0,0 +1,156 @@
+#include "TScanKernels.h"
+
+#include <QtCore/qalgorithms.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define QALAM_SCAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled per function and only called after a CPU check, so the
+// binary still runs on machines without it.
+#if defined(QALAM_SCAN_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define QALAM_SCAN_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace TScanKernels {
+
+// ==================== Scalar ====================
+
+namespace Scalar {
+
+static inline bool isAsciiSpace(char16_t c) {
+    return c == u' ' || (c >= u'\t' && c <= u'\r');
+}
+
+qsizetype skipAsciiSpaces(const char16_t* data, qsizetype from, qsizetype to) {
+    while (from < to && isAsciiSpace(data[from])) ++from;
+    return from;
+}
+
+qsizetype findQuoteOrBackslash(const char16_t* data, qsizetype from, qsizetype to, char16_t quote) {
+    while (from < to && data[from] != quote && data[from] != u'\\') ++from;
+    return from;
+}
+
+}
+
+// ==================== SSE2 ====================
+
+#ifdef QALAM_SCAN_SSE2
+
+static qsizetype skipAsciiSpacesSse2(const char16_t* data, qsizetype from, qsizetype to) {
+    const __m128i space = _mm_set1_epi16(u' ');
+    const __m128i tab = _mm_set1_epi16(u'\t');
+    const __m128i controlSpan = _mm_set1_epi16(u'\r' - u'\t');
+    const __m128i zero = _mm_setzero_si128();
+
+    qsizetype i = from;
+    for (; i + 8 <= to; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // \t..\r: (c - '\t') <= ('\r' - '\t') unsigned, via saturating subtraction.
+        const __m128i control = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(chunk, tab), controlSpan), zero);
+        const __m128i spaces = _mm_or_si128(control, _mm_cmpeq_epi16(chunk, space));
+        // Two mask bits per UTF-16 unit.
+        const unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(spaces)) & 0xFFFFu;
+        if (stop) return i + qCountTrailingZeroBits(stop) / 2;
+    }
+    return Scalar::skipAsciiSpaces(data, i, to);
+}
+
+static qsizetype findQuoteOrBackslashSse2(const char16_t* data, qsizetype from, qsizetype to, char16_t quote) {
+    const __m128i quotes = _mm_set1_epi16(static_cast<short>(quote));
+    const __m128i backslashes = _mm_set1_epi16(u'\\');
+
+    qsizetype i = from;
+    for (; i + 8 <= to; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i hits = _mm_or_si128(_mm_cmpeq_epi16(chunk, quotes), _mm_cmpeq_epi16(chunk, backslashes));
+        const unsigned found = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (found) return i + qCountTrailingZeroBits(found) / 2;
+    }
+    return Scalar::findQuoteOrBackslash(data, i, to, quote);
+}
+
+#endif
+
+// ==================== AVX2 ====================
+
+#ifdef QALAM_SCAN_AVX2
+
+__attribute__((target("avx2")))
+static qsizetype skipAsciiSpacesAvx2(const char16_t* data, qsizetype from, qsizetype to) {
+    const __m256i space = _mm256_set1_epi16(u' ');
+    const __m256i tab = _mm256_set1_epi16(u'\t');
+    const __m256i controlSpan = _mm256_set1_epi16(u'\r' - u'\t');
+    const __m256i zero = _mm256_setzero_si256();
+
+    qsizetype i = from;
+    for (; i + 16 <= to; i += 16) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const __m256i control = _mm256_cmpeq_epi16(_mm256_subs_epu16(_mm256_sub_epi16(chunk, tab), controlSpan), zero);
+        const __m256i spaces = _mm256_or_si256(control, _mm256_cmpeq_epi16(chunk, space));
+        const quint32 stop = ~static_cast<quint32>(_mm256_movemask_epi8(spaces));
+        if (stop) return i + qCountTrailingZeroBits(stop) / 2;
+    }
+    return skipAsciiSpacesSse2(data, i, to);
+}
+
+__attribute__((target("avx2")))
+static qsizetype findQuoteOrBackslashAvx2(const char16_t* data, qsizetype from, qsizetype to, char16_t quote) {
+    const __m256i quotes = _mm256_set1_epi16(static_cast<short>(quote));
+    const __m256i backslashes = _mm256_set1_epi16(u'\\');
+
+    qsizetype i = from;
+    for (; i + 16 <= to; i += 16) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi16(chunk, quotes), _mm256_cmpeq_epi16(chunk, backslashes));
+        const quint32 found = static_cast<quint32>(_mm256_movemask_epi8(hits));
+        if (found) return i + qCountTrailingZeroBits(found) / 2;
+    }
+    return findQuoteOrBackslashSse2(data, i, to, quote);
+}
+
+#endif
+
+// ==================== Dispatch ====================
+
+namespace {
+struct Variant {
+    const char* name;
+    qsizetype (*skipAsciiSpaces)(const char16_t*, qsizetype, qsizetype);
+    qsizetype (*findQuoteOrBackslash)(const char16_t*, qsizetype, qsizetype, char16_t);
+};
+
+const Variant& variant() {
+    // Thread-safe one-time selection; the lexer runs on the GUI and worker threads.
+    static const Variant selected = [] {
+#ifdef QALAM_SCAN_AVX2
+        if (__builtin_cpu_supports("avx2")) {
+            return Variant{"avx2", skipAsciiSpacesAvx2, findQuoteOrBackslashAvx2};
+        }
+#endif
+#ifdef QALAM_SCAN_SSE2
+        return Variant{"sse2", skipAsciiSpacesSse2, findQuoteOrBackslashSse2};
+#else
+        return Variant{"scalar", Scalar::skipAsciiSpaces, Scalar::findQuoteOrBackslash};
+#endif
+    }();
+    return selected;
+}
+}
+
+qsizetype skipAsciiSpaces(const char16_t* data, qsizetype from, qsizetype to) {
+    return variant().skipAsciiSpaces(data, from, to);
+}
+
+qsizetype findQuoteOrBackslash(const char16_t* data, qsizetype from, qsizetype to, char16_t quote) {
+    return variant().findQuoteOrBackslash(data, from, to, quote);
+}
+
+const char* activeVariant() {
+    return variant().name;
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QtGlobal>
+
+// Vectorized inner loops of the lexer over UTF-16 text.
+//
+// Each function scans data[from, to) and returns the index of the first
+// character that stops the scan, or `to`. On x86 the SSE2 or AVX2 variant is
+// chosen once at runtime; other targets use the scalar loop.
+namespace TScanKernels {
+
+// Skips ASCII whitespace (space, \t, \n, \v, \f, \r). Callers handle the
+// rarer Unicode spaces themselves.
+qsizetype skipAsciiSpaces(const char16_t* data, qsizetype from, qsizetype to);
+
+// Finds the next `quote` or backslash inside a string literal.
+qsizetype findQuoteOrBackslash(const char16_t* data, qsizetype from, qsizetype to, char16_t quote);
+
+// Scalar reference versions, also used for the tails of vector loops.
+namespace Scalar {
+qsizetype skipAsciiSpaces(const char16_t* data, qsizetype from, qsizetype to);
+qsizetype findQuoteOrBackslash(const char16_t* data, qsizetype from, qsizetype to, char16_t quote);
+}
+
+// Name of the variant picked for this CPU ("avx2", "sse2" or "scalar").
+const char* activeVariant();
+
+}
@@ -3,6 +3,23 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QHash>
+
+namespace {
+const QString DefaultHexPattern = QStringLiteral(R"(\b0[xX][0-9a-fA-F]+\b)");
+const QString DefaultNumberPattern = QStringLiteral(R"(\b[\d٠-٩]+\b)");
+
+// FNV-1a over UTF-16 code units, perturbed by a seed so buildClassifier()
+// can search for one that maps every reserved word to its own slot.
+inline quint32 classifierHash(QStringView word, quint32 seed) {
+    quint32 h = (2166136261u ^ seed) + static_cast<quint32>(word.size());
+    for (QChar ch : word) {
+        h ^= ch.unicode();
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+}
 
 // ==================== Language Definition ====================
 
@@ -11,6 +28,7 @@ LanguageDefinition::LanguageDefinition() {
         loadDefaults();
     }
     buildSets();
+    buildClassifier();
 }
 
 bool LanguageDefinition::loadFromJson(const QString &resourcePath) {
@@ -44,8 +62,12 @@ bool LanguageDefinition::loadFromJson(const QString &resourcePath) {
 
     // Regex patterns
     QJsonObject patterns = root["patterns"].toObject();
-    hexPattern = QRegularExpression(patterns["hex"].toString(R"(\b0[xX][0-9a-fA-F]+\b)"));
-    numberPattern = QRegularExpression(patterns["number"].toString(R"(\b[\d٠-٩]+\b)"));
+    const QString hex = patterns["hex"].toString(DefaultHexPattern);
+    const QString number = patterns["number"].toString(DefaultNumberPattern);
+    hexPattern = QRegularExpression(hex);
+    numberPattern = QRegularExpression(number);
+    customHexPattern = hex != DefaultHexPattern;
+    customNumberPattern = number != DefaultNumberPattern;
 
     return !keywordList.isEmpty(); // sanity check
 }
@@ -56,6 +78,53 @@ void LanguageDefinition::buildSets() {
     preprocessorSet = QSet<QString>(preprocessorList.begin(), preprocessorList.end());
 }
 
+void LanguageDefinition::buildClassifier() {
+    // Later insertions win, matching the lexer's lookup order:
+    // boolean literal, keyword, builtin, preprocessor.
+    QHash<QString, TokenType> words;
+    for (const QString &w : preprocessorList) words.insert(w, TokenType::Preprocessor);
+    for (const QString &w : builtinList) words.insert(w, TokenType::BuiltinFunc);
+    for (const QString &w : keywordList) words.insert(w, TokenType::Keyword);
+    words.insert(QStringLiteral("صواب"), TokenType::BooleanLiteral);
+    words.insert(QStringLiteral("خطأ"), TokenType::BooleanLiteral);
+    words.remove(QString());
+
+    for (auto it = words.cbegin(); it != words.cend(); ++it)
+        classifierMaxLength = qMax(classifierMaxLength, it.key().size());
+
+    quint32 size = 8;
+    while (size < static_cast<quint32>(words.size()) * 2) size <<= 1;
+
+    // The word lists are small, so a seed search converges quickly;
+    // grow the table if a size turns out to be too tight.
+    QVector<ClassifierSlot> table;
+    for (;;) {
+        for (quint32 seed = 1; seed <= 4096; ++seed) {
+            table.fill(ClassifierSlot{}, size);
+            bool collided = false;
+            for (auto it = words.cbegin(); it != words.cend() and !collided; ++it) {
+                ClassifierSlot &slot = table[classifierHash(it.key(), seed) & (size - 1)];
+                if (slot.type != TokenType::None) collided = true;
+                else slot = ClassifierSlot{it.key(), it.value()};
+            }
+            if (!collided) {
+                classifierTable = std::move(table);
+                classifierSeed = seed;
+                classifierMask = size - 1;
+                return;
+            }
+        }
+        size <<= 1;
+    }
+}
+
+TokenType LanguageDefinition::classify(QStringView word) const {
+    if (word.isEmpty() or word.size() > classifierMaxLength) return TokenType::None;
+
+    const ClassifierSlot &slot = classifierTable[classifierHash(word, classifierSeed) & classifierMask];
+    return QStringView(slot.word) == word ? slot.type : TokenType::None;
+}
+
 void LanguageDefinition::loadDefaults() {
     keywordList = {
         // Types (§3.1)
@@ -92,8 +161,10 @@ void LanguageDefinition::loadDefaults() {
         "#نهاية"       // Endif (§2.3)
     };
 
-    hexPattern = QRegularExpression(R"(\b0[xX][0-9a-fA-F]+\b)");
-    numberPattern = QRegularExpression(R"(\b[\d٠-٩]+\b)");
+    hexPattern = QRegularExpression(DefaultHexPattern);
+    numberPattern = QRegularExpression(DefaultNumberPattern);
+    customHexPattern = false;
+    customNumberPattern = false;
 }
 
 const LanguageDefinition& LanguageDefinition::instance() {
@@ -3,6 +3,9 @@
 #include <QString>
 #include <QStringList>
 #include <QRegularExpression>
+#include <QVector>
+
+#include "TToken.h"
 
 class LanguageDefinition {
 public:
@@ -12,6 +15,10 @@ public:
     QSet<QString> preprocessorSet{};
     QRegularExpression numberPattern{};
     QRegularExpression hexPattern{};
+    // True when baa-language.json overrides a built-in pattern. The lexer
+    // scans the built-in forms by hand and only runs these regexes if set.
+    bool customNumberPattern{false};
+    bool customHexPattern{false};
 
     // Lists for iteration (autocomplete, etc.)
     QStringList keywordList{};
@@ -23,6 +30,10 @@ public:
     // Singleton accessor -- single source of truth for all language data
     static const LanguageDefinition& instance();
 
+    // Classifies an identifier or directive in a single probe of a perfect
+    // hash built at load time. Returns TokenType::None for ordinary words.
+    TokenType classify(QStringView word) const;
+
 private:
     // Try to load definitions from a JSON resource file.
     // Returns true on success, false if the file is missing or malformed.
@@ -31,6 +42,18 @@ private:
     // Populate sets from the already-filled lists.
     void buildSets();
 
+    // Build the collision-free table behind classify() from the lists.
+    void buildClassifier();
+
+    struct ClassifierSlot {
+        QString word{};
+        TokenType type{TokenType::None};
+    };
+    QVector<ClassifierSlot> classifierTable{};
+    quint32 classifierSeed{};
+    quint32 classifierMask{};
+    qsizetype classifierMaxLength{};
+
     // Hardcoded fallback if JSON is unavailable.
     void loadDefaults();
 };
@@ -1,31 +1,383 @@
 #include "TSyntaxHighlighter.h"
+#include "TBlockData.h"
+
+#include <QElapsedTimer>
+#include <QTextBlock>
+#include <algorithm>
+#include <atomic>
+#include "Constants.h"
+
+namespace {
+std::atomic<quint64> nextOwnerId{1};
+}
 
 // ==================== Syntax Highlighter ====================
 
-TSyntaxHighlighter::TSyntaxHighlighter(QTextDocument* parent) : QSyntaxHighlighter(parent) {
+TSyntaxHighlighter::TSyntaxHighlighter(QTextDocument* parent)
+    : QObject(parent), document(parent), ownerId(nextOwnerId++) {
     lexer = std::make_unique<TLexer>();
+
+    idleTimer = new QTimer(this);
+    idleTimer->setSingleShot(true);
+    connect(idleTimer, &QTimer::timeout, this, &TSyntaxHighlighter::processPendingBlocks);
+    connect(THighlightWorker::instance(), &THighlightWorker::jobFinished,
+            this, &TSyntaxHighlighter::onJobFinished, Qt::QueuedConnection);
+
+    if (document) {
+        blockCount = document->blockCount();
+        connect(document, &QTextDocument::contentsChange, this, &TSyntaxHighlighter::onContentsChange);
+        rehighlight();
+    }
 }
 
 void TSyntaxHighlighter::setTheme(const std::shared_ptr<SyntaxTheme>& theme) {
-    currentThemeFormats.clear();
+    currentThemeFormats = TTokenFormats();
     if (theme) {
         theme->apply(currentThemeFormats);
     }
     rehighlight();
 }
 
-void TSyntaxHighlighter::highlightBlock(const QString& text) {
-    int startState = previousBlockState();
-    if (startState == -1) startState = StateMasks::Normal;
+void TSyntaxHighlighter::setVisibleBlocks(int first, int last) {
+    firstVisible = first;
+    lastVisible = last;
+    highlightVisibleBlocks();
+}
+
+void TSyntaxHighlighter::rehighlight() {
+    if (!document) return;
+
+    // Results computed with the old formats are useless now.
+    cancelBackgroundWork();
+    ++generation;
+    cascades.clear();
+    backlogFrom = 0;
+    highlightVisibleBlocks();
+    idleTimer->start(0);
+}
+
+void TSyntaxHighlighter::onContentsChange(int position, int charsRemoved, int charsAdded) {
+    Q_UNUSED(charsRemoved);
+
+    const int blockDelta = document->blockCount() - blockCount;
+    blockCount = document->blockCount();
+
+    QTextBlock block = document->findBlock(position);
+    if (!block.isValid()) return;
+    QTextBlock last = document->findBlock(position + charsAdded);
+    if (!last.isValid()) last = document->lastBlock();
+    const int first = block.blockNumber();
+    const int lastNumber = last.blockNumber();
+
+    // A snapshot taken at or after the edit no longer lines up with the
+    // document's block numbers.
+    if (first <= jobLastBlock) cancelBackgroundWork();
+
+    shiftPendingBlocks(first, lastNumber - blockDelta, blockDelta);
+
+    // Highlight the edited blocks right away so typing never shows stale
+    // colors, then follow the state change until a block's incoming state
+    // is the one it was highlighted from. A keystroke that leaves the end
+    // state alone therefore costs a single block.
+    int budget = SyncBlockLimit;
+    for (; block.isValid(); block = block.next()) {
+        if (block.blockNumber() > lastNumber
+            && (block.blockNumber() >= backlogFrom || isUpToDate(block))) {
+            break;
+        }
+        if (budget-- == 0) break;
+        highlightBlock(block);
+    }
+    markVerified(first, block.isValid() ? block.blockNumber() : blockCount);
+
+    if (hasPendingBlocks()) {
+        highlightVisibleBlocks();
+        // Restarting (not extending) the timer cancels the background pass
+        // while the user keeps typing.
+        idleTimer->start(Constants::Timing::HighlightIdleDelay);
+    }
+}
+
+void TSyntaxHighlighter::processPendingBlocks() {
+    if (!hasPendingBlocks()) return;
+
+    highlightVisibleBlocks();
+    applyReadyResult();
+
+    if (!hasPendingBlocks()) return;
+    if (readyIndex < readyResult.blocks.size()) {
+        idleTimer->start(0);
+    } else if (!jobInFlight) {
+        if (applyCachedTokens()) idleTimer->start(0);
+        else if (hasPendingBlocks()) submitPendingChunk();
+    }
+}
+
+bool TSyntaxHighlighter::applyCachedTokens() {
+    // Blocks whose cached tokens still hold (e.g. after a theme switch) only
+    // need their formats rebuilt; the worker is left the ones that need lexing.
+    QElapsedTimer slice;
+    slice.start();
+
+    const int from = pendingFrom();
+    QTextBlock block = document->findBlockByNumber(from);
+    bool outOfTime = false;
+    while (block.isValid()) {
+        if (slice.hasExpired(Constants::Timing::HighlightSliceBudget)) {
+            outOfTime = true;
+            break;
+        }
+        if (isUpToDate(block)) {
+            if (hasConverged(block)) break;
+        } else {
+            const TBlockData* data = TBlockData::of(block);
+            if (!data || data->tokenRevision != block.revision()
+                || data->tokenStartState != startStateOf(block)) {
+                break;
+            }
+            highlightBlock(block);
+        }
+        block = block.next();
+    }
+
+    markVerified(from, block.isValid() ? block.blockNumber() : blockCount);
+    return outOfTime;
+}
+
+void TSyntaxHighlighter::submitPendingChunk() {
+    // Drop cascades that already converged and skip backlog blocks that are
+    // already correct, e.g. after a visible pass.
+    QTextBlock block;
+    while (hasPendingBlocks()) {
+        const int from = pendingFrom();
+        block = document->findBlockByNumber(from);
+        if (!block.isValid()) {
+            markVerified(from, blockCount);
+            continue;
+        }
+        if (!isUpToDate(block)) break;
+        if (!hasConverged(block)) {
+            while (block.isValid() && isUpToDate(block)) block = block.next();
+        }
+        markVerified(from, block.isValid() ? block.blockNumber() : blockCount);
+    }
+    if (!hasPendingBlocks()) return;
+
+    THighlightJob job;
+    job.owner = ownerId;
+    job.serial = ++jobSerial;
+    job.firstBlock = block.blockNumber();
+    job.startState = startStateOf(block);
+    job.formats = currentThemeFormats;
+
+    int chars = 0;
+    while (block.isValid() && job.texts.size() < ChunkBlockLimit && chars < ChunkCharLimit) {
+        job.texts.append(block.text());
+        job.revisions.append(block.revision());
+        const TBlockData* data = TBlockData::of(block);
+        const bool settled = data && data->generation == generation && data->revision == block.revision();
+        job.settledStates.append(settled ? data->startState : -1);
+        chars += block.length();
+        block = block.next();
+    }
+
+    jobLastBlock = job.firstBlock + static_cast<int>(job.texts.size()) - 1;
+    jobInFlight = true;
+    THighlightWorker::instance()->submit(std::move(job));
+}
+
+void TSyntaxHighlighter::onJobFinished(const THighlightResult& result) {
+    if (result.owner != ownerId || result.serial != jobSerial) return;
+
+    jobInFlight = false;
+    readyResult = result;
+    readyIndex = 0;
+    processPendingBlocks();
+}
+
+void TSyntaxHighlighter::applyReadyResult() {
+    if (readyIndex >= readyResult.blocks.size()) return;
+
+    QElapsedTimer slice;
+    slice.start();
 
-    QVector<TToken> tokens = lexer->tokenize(text, startState);
+    const int from = pendingFrom();
+    QTextBlock block = document->findBlockByNumber(from);
+    while (readyIndex < readyResult.blocks.size() && block.isValid()
+           && !slice.hasExpired(Constants::Timing::HighlightSliceBudget)) {
+        const THighlightedBlock& lexed = readyResult.blocks[readyIndex];
 
-    for (const TToken& token : tokens) {
-        auto it = currentThemeFormats.find(token.type);
-        if (it != currentThemeFormats.end()) {
-            setFormat(token.start, token.length, *it);
+        // Stop at the first block the snapshot no longer describes: its text
+        // changed, or the state flowing into it did.
+        if (readyResult.firstBlock + readyIndex != block.blockNumber()
+            || lexed.revision != block.revision()
+            || lexed.startState != startStateOf(block)) {
+            cancelBackgroundWork();
+            break;
         }
+
+        if (isUpToDate(block)) {
+            // The rest of the snapshot is not needed.
+            if (hasConverged(block)) {
+                cancelBackgroundWork();
+                break;
+            }
+        } else {
+            TBlockData* data = dataOf(block);
+            const bool relexed = data->tokenRevision == lexed.revision && data->tokenStartState != -1
+                                 && data->tokenStartState != lexed.startState;
+            data->tokens = lexed.tokens;
+            data->tokenRevision = lexed.revision;
+            data->tokenStartState = lexed.startState;
+            data->tokenEndState = lexed.endState;
+            applyFormats(block, lexed.startState, lexed.endState, lexed.formats);
+            if (relexed) emit tokensRelexed(block.blockNumber());
+        }
+        ++readyIndex;
+        block = block.next();
+    }
+
+    markVerified(from, block.isValid() ? block.blockNumber() : blockCount);
+    if (readyIndex >= readyResult.blocks.size()) cancelBackgroundWork();
+}
+
+void TSyntaxHighlighter::cancelBackgroundWork() {
+    // Any result still on its way now carries a stale serial.
+    ++jobSerial;
+    jobInFlight = false;
+    jobLastBlock = -1;
+    readyResult = THighlightResult();
+    readyIndex = 0;
+}
+
+void TSyntaxHighlighter::highlightVisibleBlocks() {
+    // Blocks before the watermark are already correct. Visible blocks past it
+    // are lexed from their predecessor's cached state; the background pass
+    // corrects them if that state turns out to be stale.
+    if (!hasPendingBlocks() || lastVisible < pendingFrom()) return;
+
+    QTextBlock block = document->findBlockByNumber(qMax(firstVisible, pendingFrom()));
+    while (block.isValid() && block.blockNumber() <= lastVisible) {
+        if (!isUpToDate(block)) highlightBlock(block);
+        block = block.next();
+    }
+    // The block below the viewport may now see a different incoming state.
+    if (block.isValid()) markStale(block);
+}
+
+const QVector<TTokenSpan>& TSyntaxHighlighter::tokensFor(const QTextBlock& block) {
+    return lexBlock(block, startStateOf(block))->tokens;
+}
+
+TTokenSpan TSyntaxHighlighter::tokenAt(const QTextBlock& block, int positionInBlock) {
+    const QVector<TTokenSpan>& spans = tokensFor(block);
+    auto it = std::upper_bound(spans.cbegin(), spans.cend(), positionInBlock,
+                               [](int position, const TTokenSpan& token) { return position < token.start; });
+    if (it == spans.cbegin()) return {};
+    --it;
+    return positionInBlock < it->start + it->length ? *it : TTokenSpan{};
+}
+
+void TSyntaxHighlighter::highlightBlock(QTextBlock block) {
+    ++highlightCount;
+    const int startState = startStateOf(block);
+    const TBlockData* data = lexBlock(block, startState);
+
+    ranges.clear();
+    THighlightWorker::appendFormatRanges(data->tokens, currentThemeFormats, ranges);
+    applyFormats(block, startState, data->tokenEndState, ranges);
+}
+
+TBlockData* TSyntaxHighlighter::lexBlock(QTextBlock block, int startState) {
+    TBlockData* data = dataOf(block);
+    if (data->tokenRevision == block.revision() && data->tokenStartState == startState) {
+        return data;
     }
 
-    setCurrentBlockState(lexer->getFinalState());
+    const bool relexed = data->tokenRevision == block.revision() && data->tokenStartState != -1;
+    data->tokenEndState = lexer->tokenize(block.text(), startState, tokens);
+    data->setTokens(tokens);
+    data->tokenRevision = block.revision();
+    data->tokenStartState = startState;
+    if (relexed) emit tokensRelexed(block.blockNumber());
+    return data;
+}
+
+void TSyntaxHighlighter::applyFormats(QTextBlock block, int startState, int endState,
+                                      const QList<QTextLayout::FormatRange>& formats) {
+    // Only relayout blocks whose colors actually changed.
+    QTextLayout* layout = block.layout();
+    if (layout->formats() != formats) {
+        layout->setFormats(formats);
+        document->markContentsDirty(block.position(), block.length());
+    }
+
+    block.setUserState(endState);
+    TBlockData* data = dataOf(block);
+    data->startState = startState;
+    data->revision = block.revision();
+    data->generation = generation;
+}
+
+TBlockData* TSyntaxHighlighter::dataOf(QTextBlock block) {
+    TBlockData* data = TBlockData::of(block);
+    if (!data) {
+        data = new TBlockData;
+        block.setUserData(data);
+    }
+    return data;
+}
+
+bool TSyntaxHighlighter::isUpToDate(const QTextBlock& block) const {
+    const TBlockData* data = TBlockData::of(block);
+    return data
+        && data->generation == generation
+        && data->revision == block.revision()
+        && data->startState == startStateOf(block);
+}
+
+int TSyntaxHighlighter::startStateOf(const QTextBlock& block) const {
+    const QTextBlock previous = block.previous();
+    const int state = previous.isValid() ? previous.userState() : -1;
+    return state == -1 ? StateMasks::Normal : state;
+}
+
+int TSyntaxHighlighter::pendingFrom() const {
+    return cascades.isEmpty() ? backlogFrom : qMin(cascades.first(), backlogFrom);
+}
+
+bool TSyntaxHighlighter::hasConverged(const QTextBlock& block) const {
+    // Blocks before the backlog were correct before the cascade reached
+    // them; once one is up to date again, so is everything up to the next
+    // cascade or the backlog.
+    return block.blockNumber() < backlogFrom && isUpToDate(block);
+}
+
+void TSyntaxHighlighter::markVerified(int from, int to) {
+    cascades.removeIf([from, to](int origin) { return origin >= from && origin <= to; });
+    if (backlogFrom >= from && backlogFrom <= to) {
+        backlogFrom = to < blockCount ? to : NoPendingBlock;
+    }
+    if (to < blockCount) markStale(document->findBlockByNumber(to));
+}
+
+void TSyntaxHighlighter::markStale(const QTextBlock& block) {
+    const int number = block.blockNumber();
+    if (number >= backlogFrom || isUpToDate(block)) return;
+    auto it = std::lower_bound(cascades.begin(), cascades.end(), number);
+    if (it == cascades.end() || *it != number) cascades.insert(it, number);
+}
+
+void TSyntaxHighlighter::shiftPendingBlocks(int first, int oldLast, int delta) {
+    // Keep markers on the same text: shift them with the blocks behind the
+    // edit, or pull them back to the edit if they fell inside the range.
+    const auto shift = [first, oldLast, delta](int number) {
+        if (number == NoPendingBlock) return number;
+        if (number > oldLast) return number + delta;
+        return qMin(number, first);
+    };
+    for (int& origin : cascades) origin = shift(origin);
+    cascades.erase(std::unique(cascades.begin(), cascades.end()), cascades.end());
+    backlogFrom = shift(backlogFrom);
+    cascades.removeIf([this](int origin) { return origin >= backlogFrom; });
 }
@@ -2,21 +2,121 @@
 
 #include "TLexer.h"
 #include "TSyntaxThemes.h"
+#include "THighlightWorker.h"
 
-#include <QSyntaxHighlighter>
+#include <QObject>
+#include <QTextDocument>
+#include <QTextLayout>
+#include <QTimer>
+#include <limits>
 
-class TSyntaxHighlighter : public QSyntaxHighlighter {
+class TBlockData;
+
+// Viewport-first highlighter. Rather than QSyntaxHighlighter's eager cascade
+// to the end of the document, edited blocks are highlighted immediately,
+// visible blocks next, and the rest in idle chunks that restart whenever the
+// user keeps typing. Those chunks are lexed on THighlightWorker's thread; the
+// GUI thread only applies the resulting format ranges in time slices.
+class TSyntaxHighlighter : public QObject {
     Q_OBJECT
 public:
+    // Edited blocks beyond this count (e.g. a paste or setPlainText) are
+    // left to the visible and background passes.
+    static constexpr int SyncBlockLimit = 32;
+
     explicit TSyntaxHighlighter(QTextDocument* parent = nullptr);
 
-    // Switch theme
+    // Switch theme. Blocks whose cached tokens are still valid are
+    // recolored without being lexed again.
     void setTheme(const std::shared_ptr<SyntaxTheme>& theme);
 
-protected:
-    void highlightBlock(const QString& text) override;
+    // Block range currently shown by the editor; highlighted ahead of the rest.
+    void setVisibleBlocks(int first, int last);
+
+    // Mark every block stale and start over (visible blocks first).
+    void rehighlight();
+
+    // True while off-screen blocks still wait for the background pass.
+    bool hasPendingBlocks() const { return !cascades.isEmpty() || backlogFrom != NoPendingBlock; }
+
+    // Blocks lexed and colored on the GUI thread so far; lets tests and
+    // benchmarks check how much work an edit costs.
+    int highlightedBlockCount() const { return highlightCount; }
+
+    // Tokens of `block` from the shared per-block cache, lexed on a miss.
+    // Folding, hover, bracket handling and completion read these instead of
+    // scanning the text themselves. The reference is valid until the block
+    // is edited or re-lexed.
+    const QVector<TTokenSpan>& tokensFor(const QTextBlock& block);
+
+    // The token covering `positionInBlock`, or a TokenType::None span.
+    TTokenSpan tokenAt(const QTextBlock& block, int positionInBlock);
+
+signals:
+    // A block's cached tokens were replaced without its text changing,
+    // because the lexer state flowing into it changed.
+    void tokensRelexed(int blockNumber);
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void processPendingBlocks();
+    void onJobFinished(const THighlightResult& result);
 
 private:
+    static constexpr int NoPendingBlock = std::numeric_limits<int>::max();
+    // Size of one background snapshot.
+    static constexpr int ChunkBlockLimit = 512;
+    static constexpr int ChunkCharLimit = 64 * 1024;
+
+    void highlightBlock(QTextBlock block);
+    // Fills the block's token cache for `startState` unless it already holds it.
+    TBlockData* lexBlock(QTextBlock block, int startState);
+    static TBlockData* dataOf(QTextBlock block);
+    void applyFormats(QTextBlock block, int startState, int endState,
+                      const QList<QTextLayout::FormatRange>& formats);
+    bool applyCachedTokens();
+    void submitPendingChunk();
+    void applyReadyResult();
+    void cancelBackgroundWork();
+    void highlightVisibleBlocks();
+    bool isUpToDate(const QTextBlock& block) const;
+    int startStateOf(const QTextBlock& block) const;
+
+    int pendingFrom() const;
+    bool hasConverged(const QTextBlock& block) const;
+    // Blocks [from, to) were just highlighted in order.
+    void markVerified(int from, int to);
+    void markStale(const QTextBlock& block);
+    void shiftPendingBlocks(int first, int oldLast, int delta);
+
+    QTextDocument* document{};
     std::unique_ptr<TLexer> lexer{};
-    QHash<TokenType, QTextCharFormat> currentThemeFormats{};
+    // Reused across blocks so steady-state highlighting does not allocate.
+    QVector<TTokenSpan> tokens{};
+    QList<QTextLayout::FormatRange> ranges{};
+    TTokenFormats currentThemeFormats{};
+
+    QTimer* idleTimer{};
+    // Pending work is tracked in two forms. Blocks from backlogFrom on have
+    // not been highlighted since the last rehighlight(). Before it, blocks
+    // are correct except where an end state changed under a block that was
+    // not re-highlighted: each such block starts a cascade that runs until
+    // the incoming state matches the one a block was highlighted from.
+    int backlogFrom{NoPendingBlock};
+    QList<int> cascades{};
+    int highlightCount{};
+    int firstVisible{};
+    int lastVisible{-1};
+    int blockCount{};
+    // Bumped by rehighlight() so every block reads as stale.
+    int generation{};
+
+    // Background lexing: at most one job in flight; its result is applied
+    // from readyIndex on across as many slices as it takes.
+    quint64 ownerId{};
+    quint64 jobSerial{};
+    bool jobInFlight{false};
+    int jobLastBlock{-1};
+    THighlightResult readyResult{};
+    qsizetype readyIndex{};
 };
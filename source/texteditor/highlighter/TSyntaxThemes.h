@@ -4,6 +4,40 @@
 
 #include <QString>
 #include <QTextCharFormat>
+#include <array>
+
+// ==================== Format Table ====================
+
+// Theme formats in a dense table indexed by TokenType. Types a theme leaves
+// unset keep the document's default format. Types whose formats are equal
+// share a slot, so adjacent tokens of either type can form one format range.
+class TTokenFormats {
+public:
+    TTokenFormats() { slots.fill(-1); }
+
+    void set(TokenType type, const QTextCharFormat& format) {
+        formats[static_cast<int>(type)] = format;
+        slots[static_cast<int>(type)] = static_cast<int>(type);
+        for (int t = 0; t < TokenTypeCount; ++t) {
+            if (slots[t] < 0) continue;
+            slots[t] = t;
+            for (int u = 0; u < t; ++u) {
+                if (slots[u] == u && formats[u] == formats[t]) {
+                    slots[t] = u;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Slot of the format used for `type`, or -1 if the theme leaves it unset.
+    int slotOf(TokenType type) const { return slots[static_cast<int>(type)]; }
+    const QTextCharFormat& format(int slot) const { return formats[slot]; }
+
+private:
+    std::array<QTextCharFormat, TokenTypeCount> formats{};
+    std::array<int, TokenTypeCount> slots{};
+};
 
 // ==================== Themes ====================
 
@@ -12,17 +46,17 @@ class SyntaxTheme {
 public:
     virtual ~SyntaxTheme() = default;
     virtual QString name() const = 0;
-    virtual void apply(QHash<TokenType, QTextCharFormat>& formats) const = 0;
+    virtual void apply(TTokenFormats& formats) const = 0;
 
 protected:
     // Helper to reduce boilerplate in concrete themes
-    void setFormat(QHash<TokenType, QTextCharFormat>& formats, TokenType type,
+    void setFormat(TTokenFormats& formats, TokenType type,
                    QColor color, bool bold = false, bool italic = false) const {
         QTextCharFormat f;
         f.setForeground(color);
         if(bold) f.setFontWeight(QFont::Bold);
         if(italic) f.setFontItalic(true);
-        formats[type] = f;
+        formats.set(type, f);
     }
 };
 
@@ -32,7 +66,7 @@ protected:
 class VSCodeDarkTheme : public SyntaxTheme {
 public:
     QString name() const override { return "باهت لطيف"; }
-    void apply(QHash<TokenType, QTextCharFormat>& formats) const override {
+    void apply(TTokenFormats& formats) const override {
         setFormat(formats, TokenType::Keyword,      QColor(197, 134, 192), false);
         setFormat(formats, TokenType::BuiltinFunc,  QColor(78, 201, 176));
         setFormat(formats, TokenType::Function,     QColor(220, 220, 170));
@@ -50,7 +84,7 @@ public:
 class MonokaiTheme : public SyntaxTheme {
 public:
     QString name() const override { return "تباين دموي"; }
-    void apply(QHash<TokenType, QTextCharFormat>& formats) const override {
+    void apply(TTokenFormats& formats) const override {
         setFormat(formats, TokenType::Keyword,      QColor(249, 38, 114), false); // Pink
         setFormat(formats, TokenType::BuiltinFunc,  QColor(102, 217, 239));       // Light Blue
         setFormat(formats, TokenType::Function,     QColor(166, 226, 46));       // Green
@@ -68,7 +102,7 @@ public:
 class OceanicTheme : public SyntaxTheme {
 public:
     QString name() const override { return "محيطي عميق"; }
-    void apply(QHash<TokenType, QTextCharFormat>& formats) const override {
+    void apply(TTokenFormats& formats) const override {
         setFormat(formats, TokenType::Keyword,      QColor(199, 146, 234), false); // Purple
         setFormat(formats, TokenType::BuiltinFunc,  QColor(130, 170, 255));       // Blue
         setFormat(formats, TokenType::Function,     QColor(130, 170, 255));       // Blue
@@ -86,7 +120,7 @@ public:
 class QalamGlowTheme : public SyntaxTheme {
 public:
     QString name() const override { return "قلمي متوهج"; }
-    void apply(QHash<TokenType, QTextCharFormat>& formats) const override {
+    void apply(TTokenFormats& formats) const override {
         setFormat(formats, TokenType::Keyword,      QColor(255, 100, 100), false); // Purple
         setFormat(formats, TokenType::BuiltinFunc,  QColor(90, 180, 255));       // Blue
         setFormat(formats, TokenType::Function,     QColor(210, 160, 255));       // Blue
@@ -36,6 +36,17 @@ enum class TokenType {
     BooleanLiteral
 };
 
+// Number of TokenType values, for tables indexed by token type.
+constexpr int TokenTypeCount = static_cast<int>(TokenType::BooleanLiteral) + 1;
+
+// Compact token produced by the allocation-free tokenization path.
+// It carries no text: start/length index into the block it was lexed from.
+struct TTokenSpan {
+    TokenType type{TokenType::None};
+    int start{};
+    int length{};
+};
+
 struct TToken {
     TokenType type;
     int start;
@@ -0,0 +1,138 @@
+#include "WorkspaceWordIndex.h"
+
+#include "AutoComplete.h"
+#include "TEditorScheduler.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringConverter>
+#include <QTextStream>
+#include <tuple>
+
+namespace {
+WorkspaceWordIndex *workspaceWords = nullptr;
+
+void shutdownWorkspaceWords()
+{
+    delete workspaceWords;
+    workspaceWords = nullptr;
+}
+}
+
+WorkspaceWordIndex::WorkspaceWordIndex(QObject *parent)
+    : QObject(parent)
+{
+}
+
+WorkspaceWordIndex *WorkspaceWordIndex::instance()
+{
+    if (!workspaceWords) {
+        workspaceWords = new WorkspaceWordIndex;
+        qAddPostRoutine(shutdownWorkspaceWords);
+    }
+    return workspaceWords;
+}
+
+bool WorkspaceWordIndex::isIndexedFile(const QString &filePath)
+{
+    const QString suffix = QFileInfo(filePath).suffix();
+    return suffix.compare("baa", Qt::CaseInsensitive) == 0 || suffix.compare("baahd", Qt::CaseInsensitive) == 0;
+}
+
+QString WorkspaceWordIndex::keyFor(const QString &filePath)
+{
+    // The folder scan and FileManager spell paths differently.
+    const QString canonical = QFileInfo(filePath).canonicalFilePath();
+    return QDir::cleanPath(canonical.isEmpty() ? filePath : canonical);
+}
+
+WorkspaceWordIndex::FileWords WorkspaceWordIndex::listOf(const TWordIndex &words)
+{
+    FileWords list;
+    list.reserve(words.size());
+    words.forEach([&list](const QString &word, int occurrences) { list.append({word, occurrences}); });
+    return list;
+}
+
+void WorkspaceWordIndex::setFiles(const QStringList &files)
+{
+    QStringList sources;
+    for (const QString &filePath : files) {
+        if (isIndexedFile(filePath)) sources << filePath;
+    }
+
+    TEditorScheduler::instance()->runInBackground(this, TEditorScheduler::Task::IndexRebuild, [this, sources]() {
+        QList<std::pair<QString, FileWords>> results;
+        results.reserve(sources.size());
+        for (const QString &filePath : sources) {
+            QFile file(filePath);
+            if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) continue;
+            QTextStream in(&file);
+            in.setEncoding(QStringConverter::Utf8);
+            results.emplaceBack(keyFor(filePath), listOf(DynamicWordStrategy::collectWords(in.readAll())));
+        }
+        return std::function<void()>([this, results = std::move(results)]() mutable {
+            m_words.reset({});
+            m_files.clear();
+            m_strings.clear();
+            for (auto &[key, words] : results) addFile(key, std::move(words));
+            emit indexUpdated();
+        });
+    });
+}
+
+void WorkspaceWordIndex::updateFile(const QString &filePath, const TDocumentSnapshot &content)
+{
+    if (!isIndexedFile(filePath)) return;
+    m_pendingSaves.insert(keyFor(filePath), {++m_saveSerial, content});
+
+    // A newer job supersedes this one's result, so each carries every
+    // save still pending.
+    const auto pending = m_pendingSaves;
+    TEditorScheduler::instance()->runInBackground(this, TEditorScheduler::Task::IndexUpdate, [this, pending]() {
+        QList<std::tuple<QString, quint64, FileWords>> results;
+        results.reserve(pending.size());
+        for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+            results.emplaceBack(it.key(), it->first, listOf(DynamicWordStrategy::collectWords(it->second)));
+        }
+        return std::function<void()>([this, results = std::move(results)]() mutable {
+            for (auto &[key, serial, words] : results) {
+                removeFile(key);
+                addFile(key, std::move(words));
+                if (m_pendingSaves.value(key).first == serial) m_pendingSaves.remove(key);
+            }
+            emit indexUpdated();
+        });
+    });
+}
+
+void WorkspaceWordIndex::addFile(const QString &key, FileWords words)
+{
+    TWordIndex &index = m_words.edit();
+    for (auto &[word, occurrences] : words) {
+        word = intern(word);
+        index.add(word, occurrences);
+    }
+    m_files.insert(key, std::move(words));
+}
+
+void WorkspaceWordIndex::removeFile(const QString &key)
+{
+    const FileWords words = m_files.take(key);
+    if (words.isEmpty()) return;
+    TWordIndex &index = m_words.edit();
+    for (const auto &[word, occurrences] : words) {
+        index.remove(word, occurrences);
+        if (index.occurrences(word) == 0) m_strings.remove(word);
+    }
+}
+
+QString WorkspaceWordIndex::intern(const QString &word)
+{
+    const auto it = m_strings.constFind(word);
+    if (it != m_strings.cend()) return *it;
+    m_strings.insert(word);
+    return word;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "TDocumentSnapshot.h"
+#include "TWordIndex.h"
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <memory>
+#include <utility>
+
+// Words of every Baa source file in the open folder, for completion in any
+// editor. One instance serves the whole process.
+//
+// Files are read and scanned on TEditorScheduler's background thread; the
+// index is only changed on the GUI thread. Completion queries read a
+// snapshot() of it from their own thread, and the next change after that
+// edits a copy, so lookups need no locking and, like the per-document
+// TWordIndex, only walk the words starting with the first typed character.
+//
+// Each distinct word is stored once: the per-file word lists and the
+// merged index share the interned QString, and a word's string is released
+// when the last file using it drops it.
+class WorkspaceWordIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WorkspaceWordIndex(QObject *parent = nullptr);
+
+    static WorkspaceWordIndex *instance();
+
+    // Replaces the index with the words of the .baa/.baahd files among
+    // `files`, read from disk in the background.
+    void setFiles(const QStringList &files);
+    // Re-indexes one file from the text just written to it.
+    void updateFile(const QString &filePath, const TDocumentSnapshot &content);
+
+    const TWordIndex &words() const { return *m_words; }
+    std::shared_ptr<const TWordIndex> snapshot() const { return m_words.snapshot(); }
+    qsizetype fileCount() const { return m_files.size(); }
+    // Distinct word strings held in memory.
+    qsizetype stringCount() const { return m_strings.size(); }
+
+    static bool isIndexedFile(const QString &filePath);
+
+signals:
+    void indexUpdated();
+
+private:
+    // Distinct words of one file with their occurrence counts.
+    using FileWords = QList<std::pair<QString, int>>;
+
+    static QString keyFor(const QString &filePath);
+    static FileWords listOf(const TWordIndex &words);
+
+    void addFile(const QString &key, FileWords words);
+    void removeFile(const QString &key);
+    QString intern(const QString &word);
+
+    TSharedWordIndex m_words{};
+    QHash<QString, FileWords> m_files{};
+    QSet<QString> m_strings{};
+    // Saves not indexed yet, each with a serial. Every update job carries
+    // all of them, because a job's result supersedes the one before it;
+    // the serial says whether a result covers a file's latest save.
+    QHash<QString, std::pair<quint64, TDocumentSnapshot>> m_pendingSaves{};
+    quint64 m_saveSerial{};
+};
@@ -0,0 +1,185 @@
+#include "AutoComplete.h"
+#include "TDocumentSnapshot.h"
+#include "TEditorScheduler.h"
+#include "WordIndexTestHelpers.h"
+
+#include <QtTest/QtTest>
+#include <QSemaphore>
+#include <QTextDocument>
+
+class TestAsyncCompletion : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void queryKeepsItsSnapshot();
+    void editsInPlaceWithoutReaders();
+    void copiesLeaveEachOtherAlone();
+    void cancelledQueryStops();
+    void completionsDoNotWaitForIndexing();
+    void newerRequestSupersedesOlder();
+    void benchmarkEditWhileSnapshotHeld();
+};
+
+namespace {
+using Task = TEditorScheduler::Task;
+
+QStringList run(const TCompletionQuery &query, const QString &prefix)
+{
+    TCompletionCollector collector(prefix);
+    query(collector);
+    QStringList labels;
+    for (const CompletionItem &item : collector.take()) labels << item.label;
+    labels.sort();
+    return labels;
+}
+}
+
+void TestAsyncCompletion::queryKeepsItsSnapshot()
+{
+    QTextDocument document;
+    document.setPlainText(QStringLiteral("صحيح عداد_أول = ١.\nصحيح عداد_ثان = ٢."));
+    DynamicWordStrategy strategy;
+    follow(document, strategy);
+
+    const TCompletionQuery query = strategy.prepare();
+    QTextCursor cursor(document.findBlockByNumber(1));
+    cursor.select(QTextCursor::BlockUnderCursor);
+    cursor.insertText(QStringLiteral("\nصحيح عداد_ثالث = ٣."));
+
+    // The query still sees the words of the moment it was prepared...
+    QCOMPARE(run(query, QStringLiteral("عداد")), (QStringList{QStringLiteral("عداد_أول"), QStringLiteral("عداد_ثان")}));
+    // ...while the editor's index has moved on.
+    QCOMPARE(run(strategy.prepare(), QStringLiteral("عداد")),
+             (QStringList{QStringLiteral("عداد_أول"), QStringLiteral("عداد_ثالث")}));
+}
+
+void TestAsyncCompletion::editsInPlaceWithoutReaders()
+{
+    QTextDocument document;
+    document.setPlainText(QStringLiteral("صحيح عدد = ١."));
+    DynamicWordStrategy strategy;
+    follow(document, strategy);
+
+    // Nobody holds a snapshot: typing does not copy the index.
+    const TWordIndex *index = &strategy.words();
+    QTextCursor cursor(&document);
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(QStringLiteral("\nعدد = عدد + ١."));
+    QCOMPARE(&strategy.words(), index);
+
+    // A held snapshot is left alone; the edit goes to a copy.
+    std::shared_ptr<const TWordIndex> held = strategy.snapshot();
+    cursor.insertText(QStringLiteral("\nاطبع(عدد)."));
+    QVERIFY(&strategy.words() != held.get());
+    QCOMPARE(held->occurrences(QStringLiteral("اطبع")), 0);
+    QCOMPARE(strategy.words().occurrences(QStringLiteral("اطبع")), 1);
+    QCOMPARE(strategy.words().occurrences(QStringLiteral("عدد")), 4);
+}
+
+void TestAsyncCompletion::copiesLeaveEachOtherAlone()
+{
+    // Enough words for many chunks.
+    TWordIndex index;
+    for (int i = 0; i < 5000; ++i) index.add(QStringLiteral("عداد_%1").arg(i), i % 3 + 1);
+    const TWordIndex copy = index;
+    const QStringList before = entries(copy);
+
+    TWordIndex edited = index;
+    for (int i = 0; i < 5000; i += 7) edited.remove(QStringLiteral("عداد_%1").arg(i), 3);
+    for (int i = 0; i < 500; ++i) edited.add(QStringLiteral("مجموع_%1").arg(i));
+    edited.add(QStringLiteral("عداد_1"));
+
+    QCOMPARE(entries(copy), before);
+    QCOMPARE(entries(index), before);
+    QCOMPARE(edited.size(), 5000 - (5000 + 6) / 7 + 500);
+    QCOMPARE(edited.occurrences(QStringLiteral("عداد_1")), 3);
+    QCOMPARE(edited.occurrences(QStringLiteral("عداد_7")), 0);
+    QCOMPARE(copy.occurrences(QStringLiteral("عداد_7")), 2);
+
+    // Emptied down to nothing and filled again.
+    for (int i = 0; i < 5000; ++i) index.remove(QStringLiteral("عداد_%1").arg(i), 3);
+    QCOMPARE(index.size(), 0);
+    index.add(QStringLiteral("جديد"));
+    QCOMPARE(entries(index), QStringList{QStringLiteral("جديد:1")});
+    QCOMPARE(entries(copy), before);
+}
+
+void TestAsyncCompletion::cancelledQueryStops()
+{
+    QStringList lines;
+    for (int i = 0; i < 1000; ++i) lines << QStringLiteral("متغير_%1 = ٠.").arg(i);
+    QTextDocument document;
+    document.setPlainText(lines.join('\n'));
+    DynamicWordStrategy strategy;
+    strategy.rebuildIndex(TDocumentMirror::of(&document)->snapshot());
+
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    TCompletionCollector collector(QStringLiteral("متغ"), nullptr, 1000);
+    collector.setCancelFlag(cancelled);
+    cancelled->store(true);
+    strategy.suggest(collector);
+    // At most the word in hand when the flag was seen.
+    QVERIFY(collector.take().size() <= 1);
+
+    cancelled->store(false);
+    strategy.suggest(collector);
+    QCOMPARE(collector.take().size(), size_t(1000));
+}
+
+void TestAsyncCompletion::completionsDoNotWaitForIndexing()
+{
+    auto *scheduler = TEditorScheduler::instance();
+    QObject owner;
+    QSemaphore indexing;
+    scheduler->runInBackground(&owner, Task::IndexRebuild, [&indexing]() {
+        indexing.acquire();
+        return std::function<void()>();
+    });
+
+    bool delivered = false;
+    scheduler->runInBackground(&owner, Task::Completion, [&delivered]() {
+        return std::function<void()>([&delivered]() { delivered = true; });
+    });
+    QTRY_VERIFY(delivered);
+
+    indexing.release();
+    scheduler->waitForBackground();
+}
+
+void TestAsyncCompletion::newerRequestSupersedesOlder()
+{
+    auto *scheduler = TEditorScheduler::instance();
+    QObject owner;
+    QStringList delivered;
+    for (const QString &prefix : {QStringLiteral("ع"), QStringLiteral("عد"), QStringLiteral("عدد")}) {
+        scheduler->runInBackground(&owner, Task::Completion, [&delivered, prefix]() {
+            return std::function<void()>([&delivered, prefix]() { delivered << prefix; });
+        });
+    }
+
+    QTRY_COMPARE(delivered, QStringList{QStringLiteral("عدد")});
+    scheduler->waitForBackground();
+    QCoreApplication::processEvents();
+    QCOMPARE(delivered, QStringList{QStringLiteral("عدد")});
+}
+
+void TestAsyncCompletion::benchmarkEditWhileSnapshotHeld()
+{
+    // A keystroke's index update while a query still reads a snapshot of
+    // 50k words: one chunk is copied, not the whole index.
+    TSharedWordIndex words;
+    TWordIndex all;
+    for (int i = 0; i < 50000; ++i) all.add(QStringLiteral("متغير_%1").arg(i));
+    words.reset(std::move(all));
+
+    QBENCHMARK {
+        const std::shared_ptr<const TWordIndex> held = words.snapshot();
+        words.edit().add(QStringLiteral("متغير_جديد"));
+        words.edit().remove(QStringLiteral("متغير_جديد"));
+    }
+    QCOMPARE(words->size(), 50000);
+}
+
+QTEST_MAIN(TestAsyncCompletion)
+#include "TestAsyncCompletion.moc"
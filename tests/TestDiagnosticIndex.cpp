@@ -0,0 +1,68 @@
+#include "TDiagnosticIndex.h"
+
+#include <QtTest/QtTest>
+
+class TestDiagnosticIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sortsByLineAndColumn();
+    void findsDiagnosticsOnLineRange();
+    void hoverPicksClosestDiagnostic();
+};
+
+namespace {
+TEditorDiagnostic diagnostic(int line, int column, const QString &message)
+{
+    TEditorDiagnostic result;
+    result.line = line;
+    result.column = column;
+    result.severity = "error";
+    result.message = message;
+    return result;
+}
+
+QStringList messages(const TDiagnosticIndex &index, int firstLine, int lastLine)
+{
+    QStringList result;
+    const auto [begin, end] = index.onLines(firstLine, lastLine);
+    for (auto it = begin; it != end; ++it) result << it->message;
+    return result;
+}
+}
+
+void TestDiagnosticIndex::sortsByLineAndColumn()
+{
+    TDiagnosticIndex index;
+    index.setDiagnostics({diagnostic(9, 1, "c"), diagnostic(2, 8, "b"), diagnostic(2, 3, "a"), diagnostic(0, 0, "first")});
+
+    QCOMPARE(index.size(), 4);
+    QCOMPARE(messages(index, 1, 100), QStringList({"first", "a", "b", "c"}));
+}
+
+void TestDiagnosticIndex::findsDiagnosticsOnLineRange()
+{
+    QVector<TEditorDiagnostic> diagnostics;
+    for (int line = 1; line <= 10000; ++line) diagnostics << diagnostic(line, 1, QString::number(line));
+    TDiagnosticIndex index;
+    index.setDiagnostics(diagnostics);
+
+    QCOMPARE(messages(index, 5000, 5002), QStringList({"5000", "5001", "5002"}));
+    QVERIFY(messages(index, 20000, 20100).isEmpty());
+}
+
+void TestDiagnosticIndex::hoverPicksClosestDiagnostic()
+{
+    TDiagnosticIndex index;
+    index.setDiagnostics({diagnostic(4, 3, "near"), diagnostic(4, 20, "far"), diagnostic(5, 10, "other")});
+
+    QCOMPARE(index.at(4, 1)->message, QString("near"));
+    QCOMPARE(index.at(4, 18)->message, QString("far"));
+    QCOMPARE(index.at(4, 12)->message, QString("near"));
+    QVERIFY(!index.at(5, 3));
+    QVERIFY(!index.at(6, 1));
+}
+
+QTEST_MAIN(TestDiagnosticIndex)
+#include "TestDiagnosticIndex.moc"
@@ -0,0 +1,129 @@
+#include "TDocumentSnapshot.h"
+
+#include <QtTest/QtTest>
+#include <QRandomGenerator>
+#include <QTextCursor>
+#include <QTextDocument>
+
+class TestDocumentSnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void followsEditsAcrossLines();
+    void snapshotsAreImmutable();
+    void matchesDocumentAfterRandomEdits();
+    void restylingKeepsRevision();
+    void writesJoinedLines();
+};
+
+namespace {
+QString numberedLines(int count)
+{
+    QStringList lines;
+    for (int i = 0; i < count; ++i) lines << QString("سطر %1").arg(i);
+    return lines.join('\n');
+}
+}
+
+void TestDocumentSnapshot::followsEditsAcrossLines()
+{
+    QTextDocument document;
+    document.setPlainText(numberedLines(1000));
+    auto *mirror = TDocumentMirror::of(&document);
+    QCOMPARE(TDocumentMirror::of(&document), mirror);
+    QCOMPARE(mirror->snapshot().lineCount(), 1000);
+
+    QTextCursor cursor(document.findBlockByNumber(500));
+    cursor.insertText("أ\nب\n");
+    QCOMPARE(mirror->snapshot().lineCount(), 1002);
+    QCOMPARE(mirror->snapshot().line(501), QStringLiteral("ب"));
+    QCOMPARE(mirror->snapshot().line(502), QStringLiteral("سطر 500"));
+
+    // Join lines 200..799 into one.
+    cursor.setPosition(document.findBlockByNumber(200).position() + 2);
+    cursor.setPosition(document.findBlockByNumber(799).position() + 2, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    QCOMPARE(mirror->snapshot().lineCount(), document.blockCount());
+    QCOMPARE(mirror->snapshot().toPlainText(), document.toPlainText());
+
+    while (document.isUndoAvailable()) document.undo();
+    QCOMPARE(mirror->snapshot().toPlainText(), numberedLines(1000));
+    QCOMPARE(mirror->snapshot().length(), document.toPlainText().size());
+}
+
+void TestDocumentSnapshot::snapshotsAreImmutable()
+{
+    QTextDocument document;
+    document.setPlainText(numberedLines(2000));
+    auto *mirror = TDocumentMirror::of(&document);
+    const TDocumentSnapshot before = mirror->snapshot();
+
+    QTextCursor cursor(document.findBlockByNumber(1500));
+    cursor.insertText("جديد ");
+    document.setPlainText("بديل");
+
+    QCOMPARE(before.lineCount(), 2000);
+    QCOMPARE(before.line(1500), QStringLiteral("سطر 1500"));
+    QCOMPARE(before.toPlainText(), numberedLines(2000));
+    QVERIFY(mirror->snapshot().revision() > before.revision());
+    QCOMPARE(mirror->snapshot().toPlainText(), QStringLiteral("بديل"));
+}
+
+void TestDocumentSnapshot::matchesDocumentAfterRandomEdits()
+{
+    QTextDocument document;
+    document.setPlainText(numberedLines(3000));
+    auto *mirror = TDocumentMirror::of(&document);
+    QRandomGenerator random(19);
+
+    for (int edit = 0; edit < 500; ++edit) {
+        const int size = document.characterCount() - 1;
+        QTextCursor cursor(&document);
+        cursor.setPosition(random.bounded(size + 1));
+        switch (random.bounded(3)) {
+        case 0:
+            cursor.insertText(QString("س%1\n").arg(edit).repeated(random.bounded(1, 4)));
+            break;
+        case 1:
+            cursor.setPosition(std::min(size, cursor.position() + random.bounded(2000)), QTextCursor::KeepAnchor);
+            cursor.removeSelectedText();
+            break;
+        default:
+            cursor.insertText(QStringLiteral("ع"));
+            break;
+        }
+        if (edit % 50 == 0) QCOMPARE(mirror->snapshot().toPlainText(), document.toPlainText());
+    }
+    QCOMPARE(mirror->snapshot().lineCount(), document.blockCount());
+    QCOMPARE(mirror->snapshot().toPlainText(), document.toPlainText());
+}
+
+void TestDocumentSnapshot::restylingKeepsRevision()
+{
+    QTextDocument document;
+    document.setPlainText(numberedLines(10));
+    auto *mirror = TDocumentMirror::of(&document);
+    const quint64 revision = mirror->snapshot().revision();
+
+    const QTextBlock block = document.findBlockByNumber(4);
+    document.markContentsDirty(block.position(), block.length());
+    QCOMPARE(mirror->snapshot().revision(), revision);
+
+    QTextCursor(block).insertText("x");
+    QCOMPARE(mirror->snapshot().revision(), revision + 1);
+}
+
+void TestDocumentSnapshot::writesJoinedLines()
+{
+    QTextDocument document;
+    document.setPlainText(QStringLiteral("اطبع(١).\n\nإرجع ٠.\n"));
+    QString written;
+    QTextStream out(&written);
+    TDocumentMirror::of(&document)->snapshot().write(out);
+    out.flush();
+    QCOMPARE(written, document.toPlainText());
+}
+
+QTEST_MAIN(TestDocumentSnapshot)
+#include "TestDocumentSnapshot.moc"
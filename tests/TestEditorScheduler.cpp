@@ -0,0 +1,83 @@
+#include "TEditorScheduler.h"
+
+#include <QtTest/QtTest>
+#include <memory>
+
+class TestEditorScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void runsTaskAfterDelay();
+    void reschedulingMovesDeadline();
+    void cancelAndDestroyedOwnerDropTask();
+    void runsTasksInDeadlineOrder();
+};
+
+namespace {
+using Task = TEditorScheduler::Task;
+}
+
+void TestEditorScheduler::runsTaskAfterDelay()
+{
+    QObject owner;
+    int runs = 0;
+    TEditorScheduler::instance()->schedule(&owner, Task::AutoSave, 20, [&runs]() { ++runs; });
+
+    QVERIFY(TEditorScheduler::instance()->isPending(&owner, Task::AutoSave));
+    QCOMPARE(runs, 0);
+    QTRY_COMPARE(runs, 1);
+    QVERIFY(!TEditorScheduler::instance()->isPending(&owner, Task::AutoSave));
+}
+
+void TestEditorScheduler::reschedulingMovesDeadline()
+{
+    QObject owner;
+    QStringList runs;
+    auto *scheduler = TEditorScheduler::instance();
+    scheduler->schedule(&owner, Task::IndexRebuild, 20, [&runs]() { runs << "first"; });
+    scheduler->schedule(&owner, Task::IndexRebuild, 500, [&runs]() { runs << "second"; });
+    // A different task of the same owner is kept apart.
+    scheduler->schedule(&owner, Task::AutoSave, 20, [&runs]() { runs << "save"; });
+    QCOMPARE(scheduler->pendingCount(), 2);
+
+    // Only the order is checked: "first" never runs, and the moved
+    // deadline puts "second" after "save".
+    QTRY_COMPARE(runs, (QStringList{"save", "second"}));
+}
+
+void TestEditorScheduler::cancelAndDestroyedOwnerDropTask()
+{
+    auto *scheduler = TEditorScheduler::instance();
+    int runs = 0;
+    QObject kept;
+    auto destroyed = std::make_unique<QObject>();
+    scheduler->schedule(&kept, Task::AutoSave, 10, [&runs]() { ++runs; });
+    scheduler->schedule(destroyed.get(), Task::AutoSave, 10, [&runs]() { ++runs; });
+
+    scheduler->cancel(&kept, Task::AutoSave);
+    destroyed.reset();
+    QCOMPARE(scheduler->pendingCount(), 0);
+
+    QTest::qWait(40);
+    QCOMPARE(runs, 0);
+}
+
+void TestEditorScheduler::runsTasksInDeadlineOrder()
+{
+    auto *scheduler = TEditorScheduler::instance();
+    QObject early, late;
+    QStringList runs;
+    scheduler->schedule(&late, Task::AutoSave, 500, [&runs]() { runs << "late"; });
+    scheduler->schedule(&early, Task::AutoSave, 10, [&runs, &early, scheduler]() {
+        runs << "early";
+        // Work may schedule more work.
+        scheduler->schedule(&early, Task::IndexRebuild, 10, [&runs]() { runs << "follow-up"; });
+    });
+
+    QTRY_COMPARE(runs, (QStringList{"early", "follow-up", "late"}));
+    QCOMPARE(scheduler->pendingCount(), 0);
+}
+
+QTEST_MAIN(TestEditorScheduler)
+#include "TestEditorScheduler.moc"
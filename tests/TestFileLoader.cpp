@@ -0,0 +1,99 @@
+#include "FileLoader.h"
+#include "Constants.h"
+
+#include <QtTest/QtTest>
+#include <QDateTime>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+class TestFileLoader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readsUtf8Text();
+    void reportsMissingFile();
+    void flagsNewerBackup();
+    void loadsFilesInParallel();
+};
+
+namespace {
+QString writeFile(const QTemporaryDir &dir, const QString &name, const QByteArray &content)
+{
+    const QString path = dir.filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) file.write(content);
+    return path;
+}
+}
+
+void TestFileLoader::readsUtf8Text()
+{
+    QTemporaryDir dir;
+    const QString path = writeFile(dir, "برنامج.baa", "صحيح الرئيسية() {\n    إرجع ٠.\n}\n");
+
+    const FileLoadResult result = FileLoader::read(path);
+    QVERIFY(result.errorString.isEmpty());
+    QCOMPARE(result.filePath, path);
+    QCOMPARE(result.text, QStringLiteral("صحيح الرئيسية() {\n    إرجع ٠.\n}\n"));
+    QVERIFY(!result.hasBackup);
+}
+
+void TestFileLoader::reportsMissingFile()
+{
+    QTemporaryDir dir;
+    const FileLoadResult result = FileLoader::read(dir.filePath("مفقود.baa"));
+    QVERIFY(!result.errorString.isEmpty());
+    QVERIFY(result.text.isEmpty());
+}
+
+void TestFileLoader::flagsNewerBackup()
+{
+    QTemporaryDir dir;
+    const QString path = writeFile(dir, "أ.baa", "اطبع(١).");
+    const QString backupPath = writeFile(dir, "أ.baa" + Constants::BackupExtension, "اطبع(٢).");
+
+    QFile source(path);
+    QVERIFY(source.open(QIODevice::ReadWrite));
+    QVERIFY(source.setFileTime(QDateTime::currentDateTime().addSecs(-60), QFileDevice::FileModificationTime));
+    source.close();
+
+    FileLoadResult result = FileLoader::read(path);
+    QVERIFY(result.hasBackup);
+    QVERIFY(result.backupIsNewer);
+
+    QFile backup(backupPath);
+    QVERIFY(backup.open(QIODevice::ReadWrite));
+    QVERIFY(backup.setFileTime(QDateTime::currentDateTime().addSecs(-120), QFileDevice::FileModificationTime));
+    backup.close();
+
+    result = FileLoader::read(path);
+    QVERIFY(result.hasBackup);
+    QVERIFY(!result.backupIsNewer);
+}
+
+void TestFileLoader::loadsFilesInParallel()
+{
+    QTemporaryDir dir;
+    QSet<QString> expected;
+    for (int i = 0; i < 32; ++i) {
+        expected.insert(writeFile(dir, QString("ملف%1.baa").arg(i), QByteArray::number(i)));
+    }
+
+    FileLoader loader;
+    QSignalSpy loaded(&loader, &FileLoader::loaded);
+    for (const QString &path : expected) loader.load(path);
+    QTRY_COMPARE_WITH_TIMEOUT(loaded.count(), 32, 10000);
+
+    QSet<QString> seen;
+    for (const QList<QVariant> &arguments : loaded) {
+        const auto result = arguments.first().value<FileLoadResult>();
+        QVERIFY(result.errorString.isEmpty());
+        QCOMPARE(result.text, QFileInfo(result.filePath).completeBaseName().mid(3));
+        seen.insert(result.filePath);
+    }
+    QCOMPARE(seen, expected);
+}
+
+QTEST_MAIN(TestFileLoader)
+#include "TestFileLoader.moc"
@@ -0,0 +1,201 @@
+#include "TFoldEngine.h"
+#include "TSyntaxHighlighter.h"
+
+#include <QtTest/QtTest>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+
+class TestFoldEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void findsNestedRegions();
+    void ignoresBracesInStringsAndComments();
+    void keystrokeInsideLineKeepsRegions();
+    void incrementalEditsMatchRebuild();
+    void foldingHidesOnlyRegionBody();
+    void editKeepsFoldedState();
+    void largeDocumentIsAnalyzedInSlices();
+};
+
+namespace {
+const QString nestedSource = QStringLiteral(
+    "صحيح الرئيسية() {\n"           // 0
+    "    إذا (س > ٠) {\n"            // 1
+    "        اطبع(س).\n"             // 2
+    "    } وإلا {\n"                 // 3
+    "        لكل (صحيح ع = 0؛ ع < ٣؛ ع++) {\n" // 4
+    "            اطبع(ع).\n"         // 5
+    "        }\n"                    // 6
+    "    }\n"                        // 7
+    "    إرجع ٠.\n"                  // 8
+    "}\n"                            // 9
+    "#إذا_عرف تصحيح\n"               // 10
+    "اطبع(\"تصحيح\").\n"             // 11
+    "#وإلا\n"                        // 12
+    "اطبع(\"إصدار\").\n"             // 13
+    "#نهاية");                       // 14
+
+QList<QPair<int, int>> spans(const TFoldEngine &engine)
+{
+    QList<QPair<int, int>> result;
+    for (const TFoldEngine::Region &region : engine.regions()) result.append({region.start, region.end});
+    return result;
+}
+
+struct Fixture {
+    QTextDocument document;
+    TSyntaxHighlighter highlighter{&document};
+    TFoldEngine engine{&document, &highlighter};
+};
+}
+
+void TestFoldEngine::findsNestedRegions()
+{
+    Fixture fixture;
+    fixture.document.setPlainText(nestedSource);
+
+    // Each region ends before its closing line, which stays visible.
+    const QList<QPair<int, int>> expected = {{0, 8}, {1, 2}, {3, 6}, {4, 5}, {10, 11}, {12, 13}};
+    QCOMPARE(spans(fixture.engine), expected);
+    QVERIFY(fixture.engine.regionAt(3));
+    QVERIFY(!fixture.engine.regionAt(2));
+}
+
+void TestFoldEngine::ignoresBracesInStringsAndComments()
+{
+    Fixture fixture;
+    fixture.document.setPlainText(QStringLiteral(
+        "صحيح د() {\n"
+        "    اطبع(\"{\").\n"
+        "    // {\n"
+        "    اطبع(\"}}\").\n"
+        "}"));
+
+    const QList<QPair<int, int>> expected = {{0, 3}};
+    QCOMPARE(spans(fixture.engine), expected);
+}
+
+void TestFoldEngine::keystrokeInsideLineKeepsRegions()
+{
+    Fixture fixture;
+    fixture.document.setPlainText(nestedSource);
+    QSignalSpy changes(&fixture.engine, &TFoldEngine::regionsChanged);
+
+    QTextCursor cursor(fixture.document.findBlockByNumber(2));
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    cursor.insertText(QStringLiteral("س"));
+    QCOMPARE(changes.count(), 0);
+
+    cursor.insertText(QStringLiteral("{"));
+    QCOMPARE(changes.count(), 1);
+    cursor.deletePreviousChar();
+    const QList<QPair<int, int>> expected = {{0, 8}, {1, 2}, {3, 6}, {4, 5}, {10, 11}, {12, 13}};
+    QCOMPARE(spans(fixture.engine), expected);
+}
+
+void TestFoldEngine::incrementalEditsMatchRebuild()
+{
+    const QStringList pieces = {
+        QStringLiteral("إذا (س) {"), QStringLiteral("}"), QStringLiteral("} وإلا {"),
+        QStringLiteral("    اطبع(س)."), QStringLiteral(""), QStringLiteral("{ {"),
+        QStringLiteral("} }"), QStringLiteral("#إذا_عرف س"), QStringLiteral("#وإلا"),
+        QStringLiteral("#نهاية"), QStringLiteral("// }"), QStringLiteral("اطبع(\"{\")."),
+    };
+
+    QRandomGenerator random(7);
+    for (int round = 0; round < 50; ++round) {
+        Fixture fixture;
+        QStringList lines;
+        for (int i = 0; i < 30; ++i) lines << pieces[random.bounded(int(pieces.size()))];
+        fixture.document.setPlainText(lines.join('\n'));
+
+        for (int edit = 0; edit < 20; ++edit) {
+            QTextCursor cursor(fixture.document.findBlockByNumber(random.bounded(fixture.document.blockCount())));
+            switch (random.bounded(4)) {
+            case 0: // Replace a line.
+                cursor.select(QTextCursor::BlockUnderCursor);
+                cursor.insertText((cursor.block().blockNumber() ? "\n" : "") + pieces[random.bounded(int(pieces.size()))]);
+                break;
+            case 1: // Split a line.
+                cursor.insertText(QStringLiteral("\n") + pieces[random.bounded(int(pieces.size()))] + QStringLiteral("\n"));
+                break;
+            case 2: // Join with the next line.
+                cursor.movePosition(QTextCursor::EndOfBlock);
+                cursor.deleteChar();
+                break;
+            default: // Type a brace.
+                cursor.insertText(random.bounded(2) ? QStringLiteral("{") : QStringLiteral("}"));
+                break;
+            }
+
+            TFoldEngine rebuilt(&fixture.document, &fixture.highlighter);
+            QCOMPARE(spans(fixture.engine), spans(rebuilt));
+        }
+    }
+}
+
+void TestFoldEngine::foldingHidesOnlyRegionBody()
+{
+    Fixture fixture;
+    fixture.document.setPlainText(nestedSource);
+
+    QVERIFY(fixture.engine.toggle(4));
+    QVERIFY(fixture.document.findBlockByNumber(4).isVisible());
+    QVERIFY(!fixture.document.findBlockByNumber(5).isVisible());
+    QVERIFY(fixture.document.findBlockByNumber(6).isVisible());
+
+    // Folding and unfolding the parent leaves the nested fold in place.
+    QVERIFY(fixture.engine.toggle(0));
+    for (int block = 1; block <= 8; ++block) QVERIFY(!fixture.document.findBlockByNumber(block).isVisible());
+    QVERIFY(fixture.document.findBlockByNumber(9).isVisible());
+    QVERIFY(fixture.engine.toggle(0));
+    QVERIFY(fixture.document.findBlockByNumber(4).isVisible());
+    QVERIFY(!fixture.document.findBlockByNumber(5).isVisible());
+    QVERIFY(fixture.document.findBlockByNumber(6).isVisible());
+
+    QVERIFY(!fixture.engine.toggle(2));
+}
+
+void TestFoldEngine::editKeepsFoldedState()
+{
+    Fixture fixture;
+    fixture.document.setPlainText(nestedSource);
+    QVERIFY(fixture.engine.toggle(10));
+
+    // Lines added above shift the folded region with its header.
+    QTextCursor cursor(&fixture.document);
+    cursor.insertText(QStringLiteral("صحيح ع = ١.\n\n"));
+
+    const TFoldEngine::Region *region = fixture.engine.regionAt(12);
+    QVERIFY(region);
+    QVERIFY(region->folded);
+    QCOMPARE(region->end, 13);
+    QVERIFY(!fixture.document.findBlockByNumber(13).isVisible());
+    QVERIFY(fixture.document.findBlockByNumber(14).isVisible());
+}
+
+void TestFoldEngine::largeDocumentIsAnalyzedInSlices()
+{
+    QStringList lines;
+    for (int i = 0; i < 5000; ++i) {
+        lines << QStringLiteral("صحيح د%1() {").arg(i) << QStringLiteral("    إرجع %1.").arg(i) << QStringLiteral("}");
+    }
+
+    Fixture fixture;
+    fixture.document.setPlainText(lines.join('\n'));
+    QVERIFY(fixture.engine.hasPendingLines());
+    QTRY_VERIFY_WITH_TIMEOUT(!fixture.engine.hasPendingLines(), 10000);
+
+    QCOMPARE(fixture.engine.regions().size(), 5000);
+    TFoldEngine rebuilt(&fixture.document, &fixture.highlighter);
+    QTRY_VERIFY_WITH_TIMEOUT(!rebuilt.hasPendingLines(), 10000);
+    QCOMPARE(spans(fixture.engine), spans(rebuilt));
+}
+
+QTEST_MAIN(TestFoldEngine)
+#include "TestFoldEngine.moc"
@@ -0,0 +1,168 @@
+#include "AutoComplete.h"
+#include "TDocumentSnapshot.h"
+#include "TFuzzyMatcher.h"
+
+#include <QtTest/QtTest>
+#include <QTextDocument>
+
+class TestFuzzyCompletion : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void foldsCaseHamzaAndHarakat();
+    void matchesCharactersInOrder();
+    void ranksPrefixAboveScattered();
+    void keepsOnlyTheBestItems();
+    void historyRaisesAcceptedLabels();
+    void benchmarkRankedTopK();
+    void benchmarkBuildAllThenSort();
+
+private:
+    QTextDocument m_document;
+    DynamicWordStrategy m_words;
+};
+
+namespace {
+QStringList labels(const std::vector<CompletionItem> &items)
+{
+    QStringList all;
+    for (const CompletionItem &item : items) all << item.label;
+    return all;
+}
+
+std::vector<CompletionItem> rank(const QString &prefix, const QStringList &words,
+                                 const TCompletionHistory *history = nullptr)
+{
+    TCompletionCollector collector(prefix, history);
+    for (const QString &word : words) {
+        collector.offer(word, [&word] { return CompletionItem(word, word); });
+    }
+    return collector.take();
+}
+
+// Typed while completing: a short prefix, a longer one and a skipping one.
+const QStringList benchmarkPrefixes = {QStringLiteral("مت"), QStringLiteral("متغير_12"),
+                                       QStringLiteral("مجم9")};
+}
+
+void TestFuzzyCompletion::initTestCase()
+{
+    // 50k identifiers, as in TestWordIndex.
+    const QStringList stems = {QStringLiteral("متغير_"), QStringLiteral("عداد_"), QStringLiteral("نص_"),
+                               QStringLiteral("value_"), QStringLiteral("Value_"), QStringLiteral("مجموع")};
+    QStringList lines;
+    for (int i = 0; i < 50000; i += 5) {
+        QStringList names;
+        for (int j = i; j < i + 5; ++j) names << stems[j % stems.size()] + QString::number(j / stems.size());
+        lines << names.join(QStringLiteral(" + "));
+    }
+    m_document.setPlainText(lines.join('\n'));
+    m_words.rebuildIndex(TDocumentMirror::of(&m_document)->snapshot());
+    QCOMPARE(m_words.words().size(), 50000);
+}
+
+void TestFuzzyCompletion::foldsCaseHamzaAndHarakat()
+{
+    QCOMPARE(TFuzzyMatcher::fold(QStringLiteral("أكبر_قيمة")), QStringLiteral("اكبر_قيمه"));
+    QCOMPARE(TFuzzyMatcher::fold(QStringLiteral("مُحَمَّد")), QStringLiteral("محمد"));
+    QCOMPARE(TFuzzyMatcher::fold(QStringLiteral("مؤشر_ـطويل")), QStringLiteral("موشر_طويل"));
+    QCOMPARE(TFuzzyMatcher::fold(QStringLiteral("Value")), QStringLiteral("value"));
+
+    // Nothing to fold: the text is shared, not copied.
+    const QString plain = QStringLiteral("عدد_كلي");
+    QCOMPARE(TFuzzyMatcher::fold(plain).constData(), plain.constData());
+}
+
+void TestFuzzyCompletion::matchesCharactersInOrder()
+{
+    QVERIFY(TFuzzyMatcher(QStringLiteral("اكبر")).score(QStringLiteral("أكبر_قيمة")) >= 0);
+    QVERIFY(TFuzzyMatcher(QStringLiteral("حسم")).score(QStringLiteral("حساب_المجموع")) >= 0);
+    QVERIFY(TFuzzyMatcher(QStringLiteral("VAL")).score(QStringLiteral("value_1")) >= 0);
+    QCOMPARE(TFuzzyMatcher(QStringLiteral("محس")).score(QStringLiteral("حساب_المجموع")), TFuzzyMatcher::NoMatch);
+    // A single letter only at the start.
+    QVERIFY(TFuzzyMatcher(QStringLiteral("ع")).score(QStringLiteral("عدد")) >= 0);
+    QCOMPARE(TFuzzyMatcher(QStringLiteral("ع")).score(QStringLiteral("العدد")), TFuzzyMatcher::NoMatch);
+}
+
+void TestFuzzyCompletion::ranksPrefixAboveScattered()
+{
+    const QStringList words = {QStringLiteral("عبد_الدائم"), QStringLiteral("العدد"), QStringLiteral("عدد_الطلاب")};
+    QCOMPARE(labels(rank(QStringLiteral("عدد"), words)), (QStringList{QStringLiteral("عدد_الطلاب"),
+                                                                       QStringLiteral("العدد"),
+                                                                       QStringLiteral("عبد_الدائم")}));
+    // A match after '_' beats one in the middle of a word.
+    QCOMPARE(labels(rank(QStringLiteral("مج"), {QStringLiteral("المجموع"), QStringLiteral("حساب_مجموع")})).first(),
+             QStringLiteral("حساب_مجموع"));
+}
+
+void TestFuzzyCompletion::keepsOnlyTheBestItems()
+{
+    TCompletionCollector collector(QStringLiteral("عدد"), nullptr, 5);
+    int built = 0;
+    for (int i = 0; i < 1000; ++i) {
+        const QString word = QStringLiteral("عدد_%1").arg(i);
+        collector.offer(word, [&] {
+            ++built;
+            return CompletionItem(word, word);
+        });
+    }
+    // Shorter words score higher, and ties go to the earlier offer, so
+    // only the first five are ever built.
+    QCOMPARE(built, 5);
+    QCOMPARE(labels(collector.take()), (QStringList{"عدد_0", "عدد_1", "عدد_2", "عدد_3", "عدد_4"}));
+
+    // A label offered twice, e.g. as keyword and as document word, is kept once.
+    collector.offer(QStringLiteral("عدد"), [] { return CompletionItem("عدد", "عدد", "", CompletionType::Keyword); });
+    collector.offer(QStringLiteral("عدد"), [] { return CompletionItem("عدد", "عدد", "", CompletionType::DynamicWord); });
+    const std::vector<CompletionItem> kept = collector.take();
+    QCOMPARE(kept.size(), size_t(1));
+    QCOMPARE(kept.front().type, CompletionType::Keyword);
+}
+
+void TestFuzzyCompletion::historyRaisesAcceptedLabels()
+{
+    const QStringList words = {QStringLiteral("عدد"), QStringLiteral("عددهم")};
+    TCompletionHistory history;
+    QCOMPARE(labels(rank(QStringLiteral("عد"), words, &history)).first(), QStringLiteral("عدد"));
+
+    history.record(QStringLiteral("عددهم"));
+    QCOMPARE(labels(rank(QStringLiteral("عد"), words, &history)).first(), QStringLiteral("عددهم"));
+
+    history.clear();
+    QCOMPARE(history.boost(QStringLiteral("عددهم")), 0);
+}
+
+void TestFuzzyCompletion::benchmarkRankedTopK()
+{
+    QBENCHMARK {
+        for (const QString &prefix : benchmarkPrefixes) {
+            TCompletionCollector collector(prefix);
+            m_words.suggest(collector);
+            const std::vector<CompletionItem> items = collector.take();
+            Q_UNUSED(items);
+        }
+    }
+}
+
+void TestFuzzyCompletion::benchmarkBuildAllThenSort()
+{
+    // Without the bounded heap: an item for every match, then a full sort.
+    QBENCHMARK {
+        for (const QString &prefix : benchmarkPrefixes) {
+            const TFuzzyMatcher matcher(prefix);
+            std::vector<std::pair<int, CompletionItem>> all;
+            m_words.words().forEach([&](const QString &word, int) {
+                const int score = matcher.score(word);
+                if (score != TFuzzyMatcher::NoMatch) {
+                    all.emplace_back(score, CompletionItem(word, word, "نص ضمن الملف الحالي", CompletionType::DynamicWord));
+                }
+            });
+            std::stable_sort(all.begin(), all.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+        }
+    }
+}
+
+QTEST_MAIN(TestFuzzyCompletion)
+#include "TestFuzzyCompletion.moc"
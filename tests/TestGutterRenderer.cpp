@@ -0,0 +1,84 @@
+#include "TGutterRenderer.h"
+
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QPainter>
+
+class TestGutterRenderer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void unchangedRowsNeedNoRepaint();
+    void repaintsOnlyChangedRows();
+    void scrolledRowsStayClean();
+    void removedRowsAreRepainted();
+};
+
+namespace {
+constexpr int Width = 60;
+constexpr int LineHeight = 20;
+const QRect Area(0, 0, Width, 10 * LineHeight);
+
+QVector<TGutterRenderer::Row> rowsFrom(int firstBlock, int count, int top = 0)
+{
+    QVector<TGutterRenderer::Row> rows;
+    for (int i = 0; i < count; ++i) rows.append({firstBlock + i, top + i * LineHeight, LineHeight});
+    return rows;
+}
+
+void paint(TGutterRenderer &renderer, const QVector<TGutterRenderer::Row> &rows)
+{
+    QImage image(Area.size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    renderer.paint(painter, Area, Width, LineHeight, rows);
+}
+}
+
+void TestGutterRenderer::unchangedRowsNeedNoRepaint()
+{
+    TGutterRenderer renderer;
+    const QVector<TGutterRenderer::Row> rows = rowsFrom(0, 10);
+    QCOMPARE(renderer.dirtyBand(rows, Area), QRect(0, 0, Width, 10 * LineHeight));
+
+    paint(renderer, rows);
+    QVERIFY(renderer.dirtyBand(rows, Area).isEmpty());
+}
+
+void TestGutterRenderer::repaintsOnlyChangedRows()
+{
+    TGutterRenderer renderer;
+    QVector<TGutterRenderer::Row> rows = rowsFrom(0, 10);
+    paint(renderer, rows);
+
+    rows[3].marker = TGutterRenderer::Marker::Folded;
+    QCOMPARE(renderer.dirtyBand(rows, Area), QRect(0, 3 * LineHeight, Width, LineHeight));
+
+    // Folding hides blocks: rows below the header now show other numbers.
+    rows = rowsFrom(0, 4) + rowsFrom(8, 6, 4 * LineHeight);
+    QCOMPARE(renderer.dirtyBand(rows, Area), QRect(0, 4 * LineHeight, Width, 6 * LineHeight));
+}
+
+void TestGutterRenderer::scrolledRowsStayClean()
+{
+    TGutterRenderer renderer;
+    paint(renderer, rowsFrom(0, 10));
+
+    // Scrolling two lines moves the painted pixels; only the exposed rows
+    // at the bottom are new.
+    renderer.scroll(-2 * LineHeight);
+    const QRect band = renderer.dirtyBand(rowsFrom(2, 10), Area);
+    QCOMPARE(band, QRect(0, 8 * LineHeight, Width, 2 * LineHeight));
+}
+
+void TestGutterRenderer::removedRowsAreRepainted()
+{
+    TGutterRenderer renderer;
+    paint(renderer, rowsFrom(0, 10));
+
+    QCOMPARE(renderer.dirtyBand(rowsFrom(0, 7), Area), QRect(0, 7 * LineHeight, Width, 3 * LineHeight));
+}
+
+QTEST_MAIN(TestGutterRenderer)
+#include "TestGutterRenderer.moc"
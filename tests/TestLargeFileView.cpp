@@ -0,0 +1,151 @@
+#include "TLargeFileView.h"
+
+#include <QtTest/QtTest>
+#include <QScrollBar>
+#include <QTemporaryFile>
+#include <memory>
+
+class TestLargeFileView : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void indexesLinesAcrossCheckpoints();
+    void stripsBomAndCarriageReturns();
+    void goToLineMovesCurrentLine();
+    void findsForwardAndBackward();
+    void findHonorsCaseAndWholeWords();
+    void findScrollsToMatchInLongLine();
+};
+
+namespace {
+// Writes `content` to a temporary file that lives as long as the returned object.
+std::unique_ptr<QTemporaryFile> writeFile(const QByteArray &content)
+{
+    auto file = std::make_unique<QTemporaryFile>();
+    if (file->open()) {
+        file->write(content);
+        file->flush();
+    }
+    return file;
+}
+
+QByteArray numberedLines(int count)
+{
+    QByteArray content;
+    for (int i = 0; i < count; ++i) content += "سطر " + QByteArray::number(i) + '\n';
+    return content;
+}
+}
+
+void TestLargeFileView::indexesLinesAcrossCheckpoints()
+{
+    const auto file = writeFile(numberedLines(5000));
+    TLargeFileView view;
+    QVERIFY(view.openFile(file->fileName()));
+    view.finishIndexing();
+
+    // The trailing line break starts an empty last line, as in TEditor.
+    QCOMPARE(view.lineCount(), 5001);
+    QCOMPARE(view.lineText(0), QStringLiteral("سطر 0"));
+    QCOMPARE(view.lineText(1023), QStringLiteral("سطر 1023"));
+    QCOMPARE(view.lineText(1024), QStringLiteral("سطر 1024"));
+    QCOMPARE(view.lineText(4999), QStringLiteral("سطر 4999"));
+    QCOMPARE(view.lineText(5000), QString());
+    QCOMPARE(view.lineText(3), QStringLiteral("سطر 3"));
+}
+
+void TestLargeFileView::stripsBomAndCarriageReturns()
+{
+    const auto file = writeFile("\xEF\xBB\xBF" "اطبع(١).\r\nإرجع ٠.");
+    TLargeFileView view;
+    QVERIFY(view.openFile(file->fileName()));
+
+    QCOMPARE(view.lineCount(), 2);
+    QCOMPARE(view.lineText(0), QStringLiteral("اطبع(١)."));
+    QCOMPARE(view.lineText(1), QStringLiteral("إرجع ٠."));
+}
+
+void TestLargeFileView::goToLineMovesCurrentLine()
+{
+    const auto file = writeFile(numberedLines(3000));
+    TLargeFileView view;
+    QVERIFY(view.openFile(file->fileName()));
+
+    view.goToLine(2500);
+    QCOMPARE(view.currentLine(), 2500);
+    view.goToLine(100000);
+    QCOMPARE(view.currentLine(), 3000);
+}
+
+void TestLargeFileView::findsForwardAndBackward()
+{
+    const auto file = writeFile(numberedLines(3000));
+    TLargeFileView view;
+    QVERIFY(view.openFile(file->fileName()));
+
+    QVERIFY(view.find(QStringLiteral("سطر 2999")));
+    QCOMPARE(view.currentLine(), 2999);
+    QVERIFY(!view.find(QStringLiteral("سطر 2999")));
+
+    QVERIFY(view.find(QStringLiteral("سطر 12"), QTextDocument::FindBackward));
+    QCOMPARE(view.currentLine(), 1299);
+    QVERIFY(view.find(QStringLiteral("سطر 12"), QTextDocument::FindBackward));
+    QCOMPARE(view.currentLine(), 1298);
+
+    view.moveToEnd();
+    QVERIFY(view.find(QStringLiteral("سطر 0"), QTextDocument::FindBackward));
+    QCOMPARE(view.currentLine(), 0);
+}
+
+void TestLargeFileView::findHonorsCaseAndWholeWords()
+{
+    const auto file = writeFile("صحيح عدد = ١.\nصحيح عدد_كلي = ٢.\nInt عدد.\n");
+    TLargeFileView view;
+    QVERIFY(view.openFile(file->fileName()));
+
+    const auto whole = QTextDocument::FindWholeWords;
+    QVERIFY(view.find(QStringLiteral("عدد"), whole));
+    QCOMPARE(view.currentLine(), 0);
+    QVERIFY(view.find(QStringLiteral("عدد"), whole));
+    QCOMPARE(view.currentLine(), 2);
+
+    view.moveToStart();
+    QVERIFY(view.find(QStringLiteral("int")));
+    QCOMPARE(view.currentLine(), 2);
+    view.moveToStart();
+    QVERIFY(!view.find(QStringLiteral("int"), QTextDocument::FindCaseSensitively));
+}
+
+void TestLargeFileView::findScrollsToMatchInLongLine()
+{
+    // A match at the start of a long line, one past the MaxLineBytes cut
+    // of the next, and a short one.
+    const auto file = writeFile("هدف " + QByteArray("عدد ").repeated(3000) + "\n"
+                                + QByteArray(70000, 'b') + " هدف\nهدف\n");
+    TLargeFileView view;
+    QVERIFY(view.openFile(file->fileName()));
+    view.resize(400, 300);
+    view.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&view));
+
+    // Scrolled to the left end of the right-aligned line; the match is
+    // at the right end, so find() scrolls all the way back.
+    QScrollBar *hbar = view.horizontalScrollBar();
+    QTRY_VERIFY(hbar->maximum() > 0);
+    const int leftEnd = view.isRightToLeft() ? hbar->maximum() : 0;
+    const int rightEnd = view.isRightToLeft() ? 0 : hbar->maximum();
+    hbar->setValue(leftEnd);
+    QVERIFY(view.find(QStringLiteral("هدف")));
+    QCOMPARE(view.currentLine(), 0);
+    QCOMPARE(hbar->value(), rightEnd);
+
+    // lineText() stops before the second match, so find() moves past it.
+    QVERIFY(view.find(QStringLiteral("هدف")));
+    QCOMPARE(view.currentLine(), 2);
+    QVERIFY(view.find(QStringLiteral("هدف"), QTextDocument::FindBackward));
+    QCOMPARE(view.currentLine(), 0);
+}
+
+QTEST_MAIN(TestLargeFileView)
+#include "TestLargeFileView.moc"
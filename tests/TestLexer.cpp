@@ -0,0 +1,308 @@
+#include "TLexer.h"
+#include "TScanKernels.h"
+
+#include <QtTest/QtTest>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Count global operator new calls so the tests can prove the span path
+// tokenizes without touching the heap once its buffer is warm.
+namespace {
+std::atomic<qint64> newCalls{0};
+}
+
+void *operator new(std::size_t size)
+{
+    ++newCalls;
+    if (void *block = std::malloc(size ? size : 1)) return block;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void *block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+class TestLexer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void spanPathMatchesLegacyTokens_data();
+    void spanPathMatchesLegacyTokens();
+    void carriesStringStateAcrossBlocks();
+    void scansNumberLiterals();
+    void spanPathDoesNotAllocate();
+    void classifierMatchesLanguageSets();
+    void scanKernelsMatchScalar();
+    void scansLongLiteralsAndIndentation();
+    void benchmarkLegacyTokenize();
+    void benchmarkSpanTokenize();
+    void benchmarkNumericTokenize();
+    void benchmarkLongLiteralTokenize();
+    void benchmarkClassifySets();
+    void benchmarkClassifyPerfectHash();
+};
+
+namespace {
+const QString sampleLine = QStringLiteral(
+    "صحيح الرئيسية() { اطبع(\"مرحبا \\\" بالعالم\")؛ إذا (س >= ص) { س += ص. } // تعليق");
+
+const QString numericLine = QStringLiteral(
+    "صحيح جدول[٨] = {١٢, 0x1F, 42, ٧, 0XFF, ١٠٠٠, 7, ٣٢١}.");
+
+// Deep indentation and a long literal with escapes, as in generated sources.
+const QString longLiteralLine = QString(48, u' ') + QStringLiteral("نص رسالة = \"")
+    + QString(40, u'ب').repeated(8) + QStringLiteral("\\\" وسط \\n") + QString(200, u'ت')
+    + QStringLiteral("\". // نهاية");
+
+// Mix of reserved words and ordinary identifiers, as seen by the lexer.
+const QStringList classifierWords = {
+    QStringLiteral("صحيح"), QStringLiteral("العداد"), QStringLiteral("اطبع"),
+    QStringLiteral("إذا"), QStringLiteral("المجموع"), QStringLiteral("صواب"),
+    QStringLiteral("#تضمين"), QStringLiteral("قيمة_مؤقتة"), QStringLiteral("إرجع"),
+    QStringLiteral("س"), QStringLiteral("طالما"), QStringLiteral("الرئيسية_الثانية")
+};
+
+// The lookup sequence the lexer used before the perfect-hash classifier.
+TokenType classifyWithSets(const LanguageDefinition &lang, QStringView view)
+{
+    const QString word = view.toString();
+    if (word == "صواب" || word == "خطأ") return TokenType::BooleanLiteral;
+    if (lang.keywordSet.contains(word)) return TokenType::Keyword;
+    if (lang.builtinSet.contains(word)) return TokenType::BuiltinFunc;
+    if (lang.preprocessorSet.contains(word)) return TokenType::Preprocessor;
+    return TokenType::None;
+}
+}
+
+void TestLexer::spanPathMatchesLegacyTokens_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("initialState");
+
+    QTest::newRow("code") << sampleLine << StateMasks::Normal;
+    QTest::newRow("numbers") << QStringLiteral("صحيح س = ١٢٣ + 0x1F + 42.") << StateMasks::Normal;
+    QTest::newRow("preprocessor") << QStringLiteral("#تضمين \"ملف.baahd\"") << StateMasks::Normal;
+    QTest::newRow("open-string") << QStringLiteral("نص س = 'بلا نهاية") << StateMasks::Normal;
+    QTest::newRow("inside-string") << QStringLiteral("تتمة\" اطبع(س).")
+                                   << (StateMasks::String | StateMasks::Double);
+}
+
+void TestLexer::spanPathMatchesLegacyTokens()
+{
+    QFETCH(QString, text);
+    QFETCH(int, initialState);
+
+    TLexer legacyLexer;
+    const QVector<TToken> legacy = legacyLexer.tokenize(text, initialState);
+
+    TLexer spanLexer;
+    QVector<TTokenSpan> spans;
+    const int endState = spanLexer.tokenize(text, initialState, spans);
+
+    QCOMPARE(spans.size(), legacy.size());
+    for (qsizetype i = 0; i < spans.size(); ++i) {
+        QCOMPARE(spans[i].type, legacy[i].type);
+        QCOMPARE(spans[i].start, legacy[i].start);
+        QCOMPARE(spans[i].length, legacy[i].length);
+    }
+    QCOMPARE(endState, legacyLexer.getFinalState());
+    QCOMPARE(spanLexer.getFinalState(), endState);
+}
+
+void TestLexer::carriesStringStateAcrossBlocks()
+{
+    TLexer lexer;
+    QVector<TTokenSpan> spans;
+
+    const int openState = lexer.tokenize(QStringLiteral("نص س = \"سطر أول"), StateMasks::Normal, spans);
+    QCOMPARE(openState, StateMasks::String | StateMasks::Double);
+
+    const int closedState = lexer.tokenize(QStringLiteral("سطر ثان\" اطبع"), openState, spans);
+    QCOMPARE(closedState, StateMasks::Normal);
+    QVERIFY(!spans.isEmpty());
+    QCOMPARE(spans.first().type, TokenType::String);
+    QCOMPARE(spans.first().start, 0);
+    QCOMPARE(spans.first().length, 8);
+    QCOMPARE(spans.last().type, TokenType::BuiltinFunc);
+}
+
+void TestLexer::scansNumberLiterals()
+{
+    TLexer lexer;
+    QVector<TTokenSpan> spans;
+    lexer.tokenize(QStringLiteral("١٢٣ 0x1F 42 0x ٧أ"), StateMasks::Normal, spans);
+
+    QVector<int> numberLengths;
+    for (const TTokenSpan &span : std::as_const(spans)) {
+        if (span.type == TokenType::Number) numberLengths << span.length;
+    }
+    // "0x" with no hex digits is a lone 0 followed by an identifier.
+    QCOMPARE(numberLengths, (QVector<int>{3, 4, 2, 1, 1}));
+    QCOMPARE(spans.last().type, TokenType::Identifier);
+
+    // Extended Arabic-Indic digits (U+06F0..U+06F9), as typed on Persian
+    // and Urdu layouts, make one literal too.
+    lexer.tokenize(QStringLiteral("۱۲۳ ٤۵6"), StateMasks::Normal, spans);
+    numberLengths.clear();
+    for (const TTokenSpan &span : std::as_const(spans)) {
+        if (span.type == TokenType::Number) numberLengths << span.length;
+    }
+    QCOMPARE(numberLengths, (QVector<int>{3, 3}));
+}
+
+void TestLexer::spanPathDoesNotAllocate()
+{
+    TLexer lexer;
+    QVector<TTokenSpan> spans;
+    lexer.tokenize(numericLine, StateMasks::Normal, spans);
+    lexer.tokenize(sampleLine, StateMasks::Normal, spans);
+    const TTokenSpan *buffer = spans.constData();
+
+    const qint64 before = newCalls.load();
+    for (int i = 0; i < 100; ++i) {
+        lexer.tokenize(sampleLine, StateMasks::Normal, spans);
+        lexer.tokenize(numericLine, StateMasks::Normal, spans);
+    }
+    const qint64 spanAllocations = newCalls.load() - before;
+
+    QCOMPARE(spanAllocations, qint64(0));
+    QCOMPARE(spans.constData(), buffer);
+
+    const qint64 legacyBefore = newCalls.load();
+    const QVector<TToken> legacy = lexer.tokenize(sampleLine, StateMasks::Normal);
+    QVERIFY(newCalls.load() - legacyBefore >= legacy.size());
+}
+
+void TestLexer::classifierMatchesLanguageSets()
+{
+    const LanguageDefinition &lang = LanguageDefinition::instance();
+
+    QStringList words = classifierWords;
+    words << lang.keywordList << lang.builtinList << lang.preprocessorList;
+    for (const QString &word : std::as_const(words)) {
+        QCOMPARE(lang.classify(word), classifyWithSets(lang, word));
+    }
+    QCOMPARE(lang.classify(QString()), TokenType::None);
+}
+
+void TestLexer::benchmarkLegacyTokenize()
+{
+    TLexer lexer;
+    QBENCHMARK {
+        const QVector<TToken> tokens = lexer.tokenize(sampleLine, StateMasks::Normal);
+        Q_UNUSED(tokens);
+    }
+}
+
+void TestLexer::benchmarkSpanTokenize()
+{
+    TLexer lexer;
+    QVector<TTokenSpan> spans;
+    QBENCHMARK {
+        lexer.tokenize(sampleLine, StateMasks::Normal, spans);
+    }
+}
+
+void TestLexer::benchmarkNumericTokenize()
+{
+    TLexer lexer;
+    QVector<TTokenSpan> spans;
+    QBENCHMARK {
+        lexer.tokenize(numericLine, StateMasks::Normal, spans);
+    }
+}
+
+void TestLexer::scanKernelsMatchScalar()
+{
+    // Short and long runs around the 8- and 16-unit vector widths, with
+    // every character class the kernels distinguish.
+    const char16_t pool[] = {u' ', u'\t', u'\n', u'\r', u'\v', u'\f', u'\x08', u'\x0E',
+                             u'a', u'"', u'\'', u'\\', u'ب', u'\u00A0', u'\u2009', u'\uFF20'};
+    QRandomGenerator random(42);
+    QList<char16_t> text;
+    for (int round = 0; round < 20000; ++round) {
+        const int length = random.bounded(70);
+        const bool mostlySpaces = random.bounded(2);
+        text.resize(length);
+        for (char16_t &c : text) {
+            c = mostlySpaces && random.bounded(4) ? u' ' : pool[random.bounded(int(std::size(pool)))];
+        }
+        const qsizetype from = length ? random.bounded(length) : 0;
+
+        QCOMPARE(TScanKernels::skipAsciiSpaces(text.constData(), from, length),
+                 TScanKernels::Scalar::skipAsciiSpaces(text.constData(), from, length));
+        QCOMPARE(TScanKernels::findQuoteOrBackslash(text.constData(), from, length, u'"'),
+                 TScanKernels::Scalar::findQuoteOrBackslash(text.constData(), from, length, u'"'));
+    }
+    qInfo("Scan kernels: %s", TScanKernels::activeVariant());
+}
+
+void TestLexer::scansLongLiteralsAndIndentation()
+{
+    TLexer lexer;
+    QVector<TTokenSpan> spans;
+    QCOMPARE(lexer.tokenize(longLiteralLine, StateMasks::Normal, spans), StateMasks::Normal);
+
+    QCOMPARE(spans.first().type, TokenType::Whitespace);
+    QCOMPARE(spans.first().length, 48);
+    QCOMPARE(spans.last().type, TokenType::Comment);
+
+    // The escaped quote does not end the literal.
+    const qsizetype open = longLiteralLine.indexOf(u'"');
+    const qsizetype close = longLiteralLine.lastIndexOf(u'"');
+    int stringChars = 0;
+    for (const TTokenSpan &span : spans) {
+        if (span.type == TokenType::String) stringChars += span.length;
+    }
+    QCOMPARE(stringChars, int(close - open + 1));
+
+    // Unicode spaces still count as whitespace, after a vectorized ASCII run.
+    const QString mixed = QString(20, u' ') + QChar(0x00A0) + QString(3, u'\t') + QStringLiteral("س");
+    lexer.tokenize(mixed, StateMasks::Normal, spans);
+    QCOMPARE(spans.size(), 2);
+    QCOMPARE(spans.first().length, 24);
+}
+
+void TestLexer::benchmarkLongLiteralTokenize()
+{
+    TLexer lexer;
+    QVector<TTokenSpan> spans;
+    QBENCHMARK {
+        lexer.tokenize(longLiteralLine, StateMasks::Normal, spans);
+    }
+}
+
+void TestLexer::benchmarkClassifySets()
+{
+    const LanguageDefinition &lang = LanguageDefinition::instance();
+    int reserved = 0;
+    QBENCHMARK {
+        for (const QString &word : classifierWords) {
+            reserved += classifyWithSets(lang, word) != TokenType::None;
+        }
+    }
+    QVERIFY(reserved > 0);
+}
+
+void TestLexer::benchmarkClassifyPerfectHash()
+{
+    const LanguageDefinition &lang = LanguageDefinition::instance();
+    int reserved = 0;
+    QBENCHMARK {
+        for (const QString &word : classifierWords) {
+            reserved += lang.classify(word) != TokenType::None;
+        }
+    }
+    QVERIFY(reserved > 0);
+}
+
+QTEST_MAIN(TestLexer)
+#include "TestLexer.moc"
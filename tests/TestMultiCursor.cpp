@@ -0,0 +1,115 @@
+#include "TMultiCursor.h"
+
+#include <QtTest/QtTest>
+#include <QPlainTextEdit>
+#include <QTextBlock>
+
+class TestMultiCursor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void renamesAllOccurrencesInOneEdit();
+    void nextOccurrenceMatchesWholeWordsAndWraps();
+    void columnSelectionSpansLines();
+    void movesAndDeletesAtEveryCursor();
+};
+
+namespace {
+void type(QPlainTextEdit &editor, TMultiCursor &cursors, int key, const QString &text = QString())
+{
+    QKeyEvent event(QEvent::KeyPress, key, Qt::NoModifier, text);
+    if (!cursors.handleKeyPress(&event)) QCoreApplication::sendEvent(&editor, &event);
+}
+
+void placeCaret(QPlainTextEdit &editor, int position)
+{
+    QTextCursor cursor = editor.textCursor();
+    cursor.setPosition(position);
+    editor.setTextCursor(cursor);
+}
+}
+
+void TestMultiCursor::renamesAllOccurrencesInOneEdit()
+{
+    QPlainTextEdit editor;
+    QStringList lines;
+    for (int i = 0; i < 500; ++i) lines << QString("عدد = عددي + %1.").arg(i);
+    editor.setPlainText(lines.join('\n'));
+    TMultiCursor cursors(&editor);
+
+    placeCaret(editor, 1);
+    cursors.selectAllOccurrences();
+    // The word under the caret, whole words only: عددي is left alone.
+    QCOMPARE(cursors.cursors().size(), 500);
+
+    QSignalSpy changes(editor.document(), &QTextDocument::contentsChange);
+    type(editor, cursors, Qt::Key_unknown, QStringLiteral("س"));
+    QCOMPARE(changes.size(), 1);
+    QCOMPARE(editor.document()->findBlockByNumber(499).text(), QStringLiteral("س = عددي + 499."));
+
+    editor.undo();
+    QCOMPARE(editor.toPlainText(), lines.join('\n'));
+}
+
+void TestMultiCursor::nextOccurrenceMatchesWholeWordsAndWraps()
+{
+    QPlainTextEdit editor;
+    editor.setPlainText(QStringLiteral("س سس س\nس"));
+    TMultiCursor cursors(&editor);
+
+    placeCaret(editor, 5);
+    cursors.addNextOccurrence();
+    QVERIFY(!cursors.isActive());
+    QCOMPARE(editor.textCursor().selectedText(), QStringLiteral("س"));
+
+    cursors.addNextOccurrence();
+    QCOMPARE(editor.textCursor().selectionStart(), 7);
+    cursors.addNextOccurrence();
+    QCOMPARE(editor.textCursor().selectionStart(), 0);
+    QCOMPARE(cursors.cursors().size(), 3);
+
+    // Every whole-word occurrence is taken.
+    cursors.addNextOccurrence();
+    QCOMPARE(cursors.cursors().size(), 3);
+}
+
+void TestMultiCursor::columnSelectionSpansLines()
+{
+    QPlainTextEdit editor;
+    editor.setPlainText(QStringLiteral("أبجد\nهو\nحطي"));
+    TMultiCursor cursors(&editor);
+    const QTextDocument *document = editor.document();
+
+    cursors.selectColumn(1, document->findBlockByNumber(2).position() + 3);
+    const QList<QTextCursor> all = cursors.cursors();
+    QCOMPARE(all.size(), 3);
+    QCOMPARE(all[0].selectedText(), QStringLiteral("بج"));
+    QCOMPARE(all[1].selectedText(), QStringLiteral("و"));
+    QCOMPARE(all[2].selectedText(), QStringLiteral("طي"));
+
+    type(editor, cursors, Qt::Key_Backspace);
+    QCOMPARE(editor.toPlainText(), QStringLiteral("أد\nه\nح"));
+}
+
+void TestMultiCursor::movesAndDeletesAtEveryCursor()
+{
+    QPlainTextEdit editor;
+    editor.setPlainText(QStringLiteral("اطبع(١).\nاطبع(٢).\nاطبع(٣)."));
+    TMultiCursor cursors(&editor);
+
+    placeCaret(editor, 0);
+    cursors.addCursorVertically(1);
+    cursors.addCursorVertically(1);
+    QCOMPARE(cursors.cursors().size(), 3);
+
+    type(editor, cursors, Qt::Key_End);
+    type(editor, cursors, Qt::Key_Backspace);
+    QCOMPARE(editor.toPlainText(), QStringLiteral("اطبع(١)\nاطبع(٢)\nاطبع(٣)"));
+
+    type(editor, cursors, Qt::Key_Escape);
+    QVERIFY(!cursors.isActive());
+}
+
+QTEST_MAIN(TestMultiCursor)
+#include "TestMultiCursor.moc"
@@ -0,0 +1,196 @@
+#include "FileManager.h"
+#include "TEditorPlaceholder.h"
+
+#include <QtTest/QtTest>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QTabWidget>
+#include <QTemporaryDir>
+
+class TestSessionRestore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void restoredTabsBecomeEditorsWhenShown();
+    void openingRestoredFileMaterializesIt();
+    void bigFileFillsInChunks();
+    void reopeningIgnoresStaleRead();
+    // Lazy first, so memory freed by the eager run doesn't flatter it.
+    void benchmarkLazyRestore();
+    void benchmarkEagerRestore();
+
+private:
+    QTemporaryDir m_dir;
+    QStringList m_files;
+};
+
+namespace {
+constexpr int SessionTabs = 40;
+
+int editorCount(const QTabWidget &tabs)
+{
+    int count = 0;
+    for (int i = 0; i < tabs.count(); ++i) count += qobject_cast<TEditor*>(tabs.widget(i)) != nullptr;
+    return count;
+}
+
+// Resident set size in KiB, or -1 where /proc is unavailable.
+qint64 residentKiB()
+{
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly | QIODevice::Text)) return -1;
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith("VmRSS:")) return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+    return -1;
+}
+
+void waitForLoads(const FileManager &fileManager)
+{
+    QTRY_VERIFY_WITH_TIMEOUT(!fileManager.hasPendingLoads(), 30000);
+}
+}
+
+void TestSessionRestore::initTestCase()
+{
+    // Keep the recent-files list of the test run out of the user's settings.
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.filePath("settings"));
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.filePath("settings"));
+
+    for (int i = 0; i < SessionTabs; ++i) {
+        const QString path = m_dir.filePath(QString("وحدة%1.baa").arg(i));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        for (int line = 0; line < 400; ++line) {
+            file.write(QString("صحيح دالة%1_%2(صحيح س) { إرجع س * %2. }\n").arg(i).arg(line).toUtf8());
+        }
+        m_files << path;
+    }
+}
+
+void TestSessionRestore::restoredTabsBecomeEditorsWhenShown()
+{
+    QTabWidget tabs;
+    FileManager fileManager(&tabs, &tabs);
+    fileManager.restoreFiles(m_files);
+
+    QCOMPARE(tabs.count(), SessionTabs);
+    QTRY_VERIFY(qobject_cast<TEditor*>(tabs.currentWidget()));
+    QCOMPARE(editorCount(tabs), 1);
+
+    tabs.setCurrentIndex(7);
+    QTRY_VERIFY(qobject_cast<TEditor*>(tabs.widget(7)));
+    QCOMPARE(tabs.currentIndex(), 7);
+    QCOMPARE(tabs.count(), SessionTabs);
+    QCOMPARE(tabs.tabText(7), QFileInfo(m_files[7]).fileName());
+    QCOMPARE(editorCount(tabs), 2);
+
+    waitForLoads(fileManager);
+    auto *editor = qobject_cast<TEditor*>(tabs.widget(7));
+    QVERIFY(!editor->isLoading());
+    QVERIFY(editor->toPlainText().startsWith(QStringLiteral("صحيح دالة7_0")));
+}
+
+void TestSessionRestore::openingRestoredFileMaterializesIt()
+{
+    QTabWidget tabs;
+    FileManager fileManager(&tabs, &tabs);
+    fileManager.restoreFiles(m_files);
+
+    fileManager.openFile(m_files[12]);
+    QVERIFY(qobject_cast<TEditor*>(tabs.widget(12)));
+    QCOMPARE(tabs.currentIndex(), 12);
+    QCOMPARE(tabs.count(), SessionTabs);
+    QVERIFY(qobject_cast<TEditorPlaceholder*>(tabs.widget(11)));
+    waitForLoads(fileManager);
+}
+
+void TestSessionRestore::bigFileFillsInChunks()
+{
+    // Several times TEditor's append chunk, all well below the large-file threshold.
+    const QString path = m_dir.filePath(QStringLiteral("كبير.baa"));
+    QByteArray content;
+    for (int line = 0; line < 20000; ++line) content += "صحيح س" + QByteArray::number(line) + " = ٠.\n";
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(content);
+    file.close();
+
+    QTabWidget tabs;
+    FileManager fileManager(&tabs, &tabs);
+    fileManager.openFile(path);
+    auto *editor = qobject_cast<TEditor*>(tabs.currentWidget());
+    QVERIFY(editor);
+    QVERIFY(editor->isLoading());
+    QSignalSpy changes(editor->document(), &QTextDocument::contentsChange);
+
+    waitForLoads(fileManager);
+    QVERIFY(!editor->isLoading());
+    QVERIFY(changes.count() > 1);
+    QCOMPARE(editor->toPlainText(), QString::fromUtf8(content));
+    QVERIFY(!editor->document()->isModified());
+    QVERIFY(!editor->document()->isUndoAvailable());
+}
+
+void TestSessionRestore::reopeningIgnoresStaleRead()
+{
+    const QString path = m_dir.filePath(QStringLiteral("مفتوح_مرتين.baa"));
+    QByteArray content;
+    for (int line = 0; line < 20000; ++line) content += "صحيح ع" + QByteArray::number(line) + " = ١.\n";
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(content);
+    file.close();
+
+    QTabWidget tabs;
+    FileManager fileManager(&tabs, &tabs);
+    fileManager.openFile(path);
+    auto *first = qobject_cast<TEditor*>(tabs.currentWidget());
+    QVERIFY(first);
+
+    // Closed and opened again before the first read has been delivered.
+    tabs.removeTab(tabs.indexOf(first));
+    delete first;
+    fileManager.openFile(path);
+    auto *second = qobject_cast<TEditor*>(tabs.currentWidget());
+    QVERIFY(second);
+    QVERIFY(second->isLoading());
+
+    waitForLoads(fileManager);
+    QVERIFY(!second->isLoading());
+    QCOMPARE(second->toPlainText(), QString::fromUtf8(content));
+    QVERIFY(!second->document()->isModified());
+}
+
+void TestSessionRestore::benchmarkLazyRestore()
+{
+    const qint64 before = residentKiB();
+    QTabWidget tabs;
+    FileManager fileManager(&tabs, &tabs);
+    QBENCHMARK_ONCE {
+        fileManager.restoreFiles(m_files);
+        QTRY_VERIFY(qobject_cast<TEditor*>(tabs.currentWidget()));
+        waitForLoads(fileManager);
+    }
+    QCOMPARE(editorCount(tabs), 1);
+    if (before >= 0) qInfo("Lazy restore of %d tabs: +%lld KiB resident", SessionTabs, residentKiB() - before);
+}
+
+void TestSessionRestore::benchmarkEagerRestore()
+{
+    const qint64 before = residentKiB();
+    QTabWidget tabs;
+    FileManager fileManager(&tabs, &tabs);
+    QBENCHMARK_ONCE {
+        for (const QString &file : std::as_const(m_files)) fileManager.openFile(file);
+        waitForLoads(fileManager);
+    }
+    QCOMPARE(editorCount(tabs), SessionTabs);
+    if (before >= 0) qInfo("Eager restore of %d tabs: +%lld KiB resident", SessionTabs, residentKiB() - before);
+}
+
+QTEST_MAIN(TestSessionRestore)
+#include "TestSessionRestore.moc"
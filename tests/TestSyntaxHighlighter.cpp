@@ -0,0 +1,232 @@
+#include "TSyntaxHighlighter.h"
+#include "ThemeManager.h"
+
+#include <QtTest/QtTest>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QScopeGuard>
+
+class TestSyntaxHighlighter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void defersOffscreenBlocksToBackgroundPass();
+    void recolorsVisibleBlocksAfterOpeningString();
+    void workerLexesSnapshotsOffTheGuiThread();
+    void tokenCacheFollowsBlockRevision();
+    void mergesAdjacentTokensSharingAFormat();
+    void themeSwitchReusesCachedTokens();
+    void keystrokeHighlightsOnlyTheEditedBlock();
+    void closingStringStopsAtConvergence();
+};
+
+namespace {
+QString generatedSource(int lines)
+{
+    QStringList text;
+    text.reserve(lines);
+    for (int i = 0; i < lines; ++i) {
+        text << QStringLiteral("صحيح س%1 = ٤٢. // تعليق").arg(i);
+    }
+    return text.join('\n');
+}
+
+QColor firstForeground(const QTextBlock &block)
+{
+    const auto formats = block.layout()->formats();
+    return formats.isEmpty() ? QColor() : formats.first().format.foreground().color();
+}
+}
+
+void TestSyntaxHighlighter::defersOffscreenBlocksToBackgroundPass()
+{
+    QTextDocument document;
+    TSyntaxHighlighter highlighter(&document);
+    highlighter.setTheme(ThemeManager::getThemeByIndex(0));
+    highlighter.setVisibleBlocks(0, 9);
+
+    document.setPlainText(generatedSource(20000));
+
+    QVERIFY(!document.firstBlock().layout()->formats().isEmpty());
+    QVERIFY(document.lastBlock().layout()->formats().isEmpty());
+    QVERIFY(highlighter.hasPendingBlocks());
+
+    QTRY_VERIFY_WITH_TIMEOUT(!highlighter.hasPendingBlocks(), 30000);
+    QVERIFY(!document.lastBlock().layout()->formats().isEmpty());
+}
+
+void TestSyntaxHighlighter::recolorsVisibleBlocksAfterOpeningString()
+{
+    QTextDocument document;
+    TSyntaxHighlighter highlighter(&document);
+    highlighter.setTheme(ThemeManager::getThemeByIndex(0));
+    document.setPlainText(generatedSource(3));
+    highlighter.setVisibleBlocks(0, 2);
+    QTRY_VERIFY(!highlighter.hasPendingBlocks());
+
+    const QColor keyword = firstForeground(document.lastBlock());
+
+    QTextCursor cursor(&document);
+    cursor.insertText(QStringLiteral("\""));
+
+    // The visible tail is recolored synchronously, before any idle pass runs.
+    const QColor string = firstForeground(document.lastBlock());
+    QVERIFY(string.isValid());
+    QVERIFY(string != keyword);
+    QCOMPARE(document.lastBlock().previous().userState(), StateMasks::String | StateMasks::Double);
+}
+
+void TestSyntaxHighlighter::workerLexesSnapshotsOffTheGuiThread()
+{
+    THighlightWorker *worker = THighlightWorker::instance();
+    QVERIFY(worker->thread() != QThread::currentThread());
+
+    // Results arrive through a queued connection, as highlighters get them.
+    THighlightResult result;
+    bool received = false;
+    const auto connection = connect(worker, &THighlightWorker::jobFinished, this,
+                                    [&](const THighlightResult &finished) {
+                                        if (finished.owner != 0) return;
+                                        result = finished;
+                                        received = true;
+                                    });
+    const auto disconnectGuard = qScopeGuard([&] { disconnect(connection); });
+
+    THighlightJob job;
+    job.owner = 0;
+    job.serial = 7;
+    job.firstBlock = 3;
+    job.startState = StateMasks::Normal;
+    job.texts = {QStringLiteral("نص س = \"بداية"), QStringLiteral("نهاية\" اطبع")};
+    job.revisions = {11, 12};
+    ThemeManager::getThemeByIndex(0)->apply(job.formats);
+    worker->submit(job);
+
+    QTRY_VERIFY(received);
+    QCOMPARE(result.serial, quint64(7));
+    QCOMPARE(result.firstBlock, 3);
+    QCOMPARE(result.blocks.size(), 2);
+    QCOMPARE(result.blocks[0].revision, 11);
+    QCOMPARE(result.blocks[0].endState, StateMasks::String | StateMasks::Double);
+    QCOMPARE(result.blocks[1].startState, StateMasks::String | StateMasks::Double);
+    QCOMPARE(result.blocks[1].endState, StateMasks::Normal);
+    QVERIFY(!result.blocks[1].formats.isEmpty());
+}
+
+void TestSyntaxHighlighter::tokenCacheFollowsBlockRevision()
+{
+    QTextDocument document;
+    TSyntaxHighlighter highlighter(&document);
+    document.setPlainText(QStringLiteral("اطبع س. // تعليق"));
+    const QTextBlock block = document.firstBlock();
+
+    // Repeated queries are served from the same cached storage.
+    const TTokenSpan *cached = highlighter.tokensFor(block).constData();
+    QCOMPARE(highlighter.tokensFor(block).constData(), cached);
+    QCOMPARE(highlighter.tokenAt(block, 0).type, TokenType::BuiltinFunc);
+    QCOMPARE(highlighter.tokenAt(block, block.length() - 2).type, TokenType::Comment);
+    QCOMPARE(highlighter.tokenAt(block, block.length()).type, TokenType::None);
+
+    // Editing bumps the block revision, which invalidates the cache.
+    QTextCursor cursor(&document);
+    cursor.insertText(QStringLiteral("\""));
+    QCOMPARE(highlighter.tokenAt(document.firstBlock(), 1).type, TokenType::String);
+}
+
+void TestSyntaxHighlighter::mergesAdjacentTokensSharingAFormat()
+{
+    TTokenFormats formats;
+    ThemeManager::getThemeByIndex(0)->apply(formats);
+
+    // An opening quote and the string body are lexed as two String tokens.
+    const QVector<TTokenSpan> tokens = {
+        {TokenType::String, 0, 1},
+        {TokenType::String, 1, 5},
+        {TokenType::Whitespace, 6, 1},
+        {TokenType::String, 7, 2},
+    };
+    QList<QTextLayout::FormatRange> ranges;
+    THighlightWorker::appendFormatRanges(tokens, formats, ranges);
+
+    QCOMPARE(ranges.size(), 2);
+    QCOMPARE(ranges[0].start, 0);
+    QCOMPARE(ranges[0].length, 6);
+    QCOMPARE(ranges[1].start, 7);
+}
+
+void TestSyntaxHighlighter::themeSwitchReusesCachedTokens()
+{
+    QTextDocument document;
+    TSyntaxHighlighter highlighter(&document);
+    highlighter.setTheme(ThemeManager::getThemeByIndex(0));
+    highlighter.setVisibleBlocks(0, 9);
+    document.setPlainText(generatedSource(2000));
+    QTRY_VERIFY_WITH_TIMEOUT(!highlighter.hasPendingBlocks(), 30000);
+
+    // Worker results are adopted as-is, so re-lexing the last block on the
+    // worker would replace its token storage.
+    const QTextBlock last = document.lastBlock();
+    const TTokenSpan *cached = highlighter.tokensFor(last).constData();
+    const QColor before = firstForeground(last);
+
+    highlighter.setTheme(ThemeManager::getThemeByIndex(1));
+    QTRY_VERIFY_WITH_TIMEOUT(!highlighter.hasPendingBlocks(), 30000);
+
+    QVERIFY(firstForeground(last) != before);
+    QCOMPARE(highlighter.tokensFor(last).constData(), cached);
+}
+
+void TestSyntaxHighlighter::keystrokeHighlightsOnlyTheEditedBlock()
+{
+    QTextDocument document;
+    TSyntaxHighlighter highlighter(&document);
+    highlighter.setVisibleBlocks(990, 1010);
+    document.setPlainText(generatedSource(2000));
+    QTRY_VERIFY_WITH_TIMEOUT(!highlighter.hasPendingBlocks(), 30000);
+
+    QTextCursor cursor(document.findBlockByNumber(1000));
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    for (int i = 0; i < 10; ++i) {
+        const int before = highlighter.highlightedBlockCount();
+        cursor.insertText(QStringLiteral("س"));
+        QCOMPARE(highlighter.highlightedBlockCount() - before, 1);
+        QVERIFY(!highlighter.hasPendingBlocks());
+    }
+
+    // A new line splits one block into two.
+    const int before = highlighter.highlightedBlockCount();
+    cursor.insertText(QStringLiteral("\nصحيح ع = ١."));
+    QCOMPARE(highlighter.highlightedBlockCount() - before, 2);
+    QVERIFY(!highlighter.hasPendingBlocks());
+}
+
+void TestSyntaxHighlighter::closingStringStopsAtConvergence()
+{
+    QTextDocument document;
+    TSyntaxHighlighter highlighter(&document);
+    highlighter.setTheme(ThemeManager::getThemeByIndex(0));
+    document.setPlainText(generatedSource(2000));
+    QTRY_VERIFY_WITH_TIMEOUT(!highlighter.hasPendingBlocks(), 30000);
+    const QColor untouched = firstForeground(document.findBlockByNumber(1500));
+
+    // Opening a string turns the rest of the document into one; only a
+    // bounded run is recolored synchronously, the rest waits for idle time.
+    QTextCursor cursor(document.findBlockByNumber(1000));
+    cursor.insertText(QStringLiteral("\""));
+    QVERIFY(highlighter.hasPendingBlocks());
+
+    // Closing it right away: blocks are re-highlighted only until they meet
+    // one still highlighted from the state now flowing into it, which stays
+    // within one synchronous run (plus a block of slack).
+    const int before = highlighter.highlightedBlockCount();
+    cursor.insertText(QStringLiteral("\""));
+    QVERIFY(highlighter.highlightedBlockCount() - before <= TSyntaxHighlighter::SyncBlockLimit + 1);
+    QVERIFY(!highlighter.hasPendingBlocks());
+    QCOMPARE(firstForeground(document.findBlockByNumber(1010)), untouched);
+    QCOMPARE(firstForeground(document.findBlockByNumber(1500)), untouched);
+}
+
+QTEST_MAIN(TestSyntaxHighlighter)
+#include "TestSyntaxHighlighter.moc"
@@ -0,0 +1,317 @@
+#include "AutoComplete.h"
+#include "TDocumentSnapshot.h"
+#include "TFuzzyMatcher.h"
+#include "TWordIndex.h"
+#include "WordIndexTestHelpers.h"
+
+#include <QtTest/QtTest>
+#include <QTextDocument>
+
+class TestWordIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void countsOccurrences();
+    void findsPrefixIgnoringCase();
+    void matchesLinearScan();
+    void fuzzyCandidatesShareFirstCharacter();
+    void collectsWordsFromSnapshot();
+    void followsEditsExactly();
+    void benchmarkLinearScan();
+    void benchmarkPrefixLookup();
+    void benchmarkFuzzyAllWords();
+    void benchmarkFuzzyCandidates();
+    void benchmarkCollectWords();
+    void benchmarkEditUpdate();
+
+private:
+    QStringList m_identifiers;
+    QSet<QString> m_set;
+    TWordIndex m_index;
+};
+
+namespace {
+constexpr int DocumentIdentifiers = 50000;
+// Prefixes a user types while completing: short and ambiguous to nearly unique.
+const QStringList lookupPrefixes = {
+    QStringLiteral("مت"), QStringLiteral("متغير_12"), QStringLiteral("عداد_4"),
+    QStringLiteral("val"), QStringLiteral("Value_99"), QStringLiteral("نص_"),
+};
+
+QStringList linearScan(const QSet<QString> &words, const QString &prefix)
+{
+    QStringList matches;
+    for (const QString &word : words) {
+        if (word.startsWith(prefix, Qt::CaseInsensitive)) matches << word;
+    }
+    return matches;
+}
+
+QStringList prefixLookup(const TWordIndex &index, const QString &prefix)
+{
+    QStringList matches;
+    index.forEachWithPrefix(prefix, [&matches](const QString &word, int) { matches << word; });
+    return matches;
+}
+
+// Words of `index` the fuzzy matcher accepts for `pattern`, as completion walks them.
+QStringList fuzzyLookup(const TWordIndex &index, const QString &pattern)
+{
+    const TFuzzyMatcher matcher(pattern);
+    QStringList matches;
+    index.forEachCandidate(matcher, [&](const QString &word, int) {
+        if (matcher.score(word) != TFuzzyMatcher::NoMatch) matches << word;
+        return true;
+    });
+    return matches;
+}
+
+// Typed while completing, scattered ones included.
+const QStringList fuzzyPatterns = {QStringLiteral("مت"), QStringLiteral("متغ12"), QStringLiteral("مجم9"),
+                                   QStringLiteral("vl"), QStringLiteral("Value_99"), QStringLiteral("عد_4")};
+}
+
+void TestWordIndex::initTestCase()
+{
+    // 50k identifiers in the shapes a Baa file has: Arabic names with
+    // numeric suffixes and some Latin ones in mixed case.
+    const QStringList stems = {QStringLiteral("متغير_"), QStringLiteral("عداد_"), QStringLiteral("نص_"),
+                               QStringLiteral("value_"), QStringLiteral("Value_"), QStringLiteral("مجموع")};
+    for (int i = 0; i < DocumentIdentifiers; ++i) {
+        m_identifiers << stems[i % stems.size()] + QString::number(i / stems.size());
+    }
+    for (const QString &identifier : std::as_const(m_identifiers)) {
+        m_set.insert(identifier);
+        m_index.add(identifier);
+    }
+}
+
+void TestWordIndex::countsOccurrences()
+{
+    TWordIndex index;
+    index.add(QStringLiteral("العداد"));
+    index.add(QStringLiteral("العداد"), 2);
+    QCOMPARE(index.occurrences(QStringLiteral("العداد")), 3);
+
+    index.remove(QStringLiteral("العداد"), 2);
+    QCOMPARE(index.size(), 1);
+    index.remove(QStringLiteral("العداد"));
+    QCOMPARE(index.size(), 0);
+    QCOMPARE(index.occurrences(QStringLiteral("العداد")), 0);
+
+    // Removing what is not there changes nothing.
+    index.remove(QStringLiteral("غائب"));
+    QCOMPARE(index.size(), 0);
+}
+
+void TestWordIndex::findsPrefixIgnoringCase()
+{
+    TWordIndex index;
+    for (const char *word : {"count", "Counter", "COUNTRY", "cat", "coun"}) index.add(QString::fromLatin1(word));
+    index.add(QStringLiteral("عدد"));
+    index.add(QStringLiteral("عداد"));
+
+    QCOMPARE(prefixLookup(index, QStringLiteral("COUNT")),
+             (QStringList{"count", "Counter", "COUNTRY"}));
+    QCOMPARE(prefixLookup(index, QStringLiteral("عد")), (QStringList{QStringLiteral("عداد"), QStringLiteral("عدد")}));
+    QVERIFY(prefixLookup(index, QStringLiteral("x")).isEmpty());
+}
+
+void TestWordIndex::matchesLinearScan()
+{
+    for (const QString &prefix : lookupPrefixes) {
+        QStringList expected = linearScan(m_set, prefix);
+        QStringList actual = prefixLookup(m_index, prefix);
+        expected.sort();
+        actual.sort();
+        QCOMPARE(actual, expected);
+    }
+}
+
+void TestWordIndex::fuzzyCandidatesShareFirstCharacter()
+{
+    for (const QString &pattern : fuzzyPatterns) {
+        const TFuzzyMatcher matcher(pattern);
+        QStringList expected;
+        for (const QString &word : std::as_const(m_set)) {
+            if (TFuzzyMatcher::fold(word).startsWith(matcher.pattern().left(1))
+                && matcher.score(word) != TFuzzyMatcher::NoMatch) {
+                expected << word;
+            }
+        }
+        QStringList actual = fuzzyLookup(m_index, pattern);
+        expected.sort();
+        actual.sort();
+        QVERIFY(!actual.isEmpty());
+        QCOMPARE(actual, expected);
+    }
+
+    // A stop from the callback ends the walk.
+    int visited = 0;
+    m_index.forEachCandidate(TFuzzyMatcher(QStringLiteral("مت")), [&visited](const QString &, int) {
+        return ++visited < 3;
+    });
+    QCOMPARE(visited, 3);
+}
+
+void TestWordIndex::collectsWordsFromSnapshot()
+{
+    QTextDocument document;
+    document.setPlainText(QStringLiteral("صحيح س = عدد + عدد.\nاطبع(عدد)."));
+    const TWordIndex words = DynamicWordStrategy::collectWords(TDocumentMirror::of(&document)->snapshot());
+
+    QCOMPARE(words.occurrences(QStringLiteral("عدد")), 3);
+    QCOMPARE(words.occurrences(QStringLiteral("اطبع")), 1);
+    // Single letters are not worth completing.
+    QCOMPARE(words.occurrences(QStringLiteral("س")), 0);
+}
+
+void TestWordIndex::followsEditsExactly()
+{
+    QTextDocument document;
+    document.setPlainText(QStringLiteral("صحيح عدد = ١.\nعدد = عدد + مجموع.\nاطبع(مجموع)."));
+    DynamicWordStrategy strategy;
+    follow(document, strategy);
+    const auto check = [&]() {
+        QCOMPARE(entries(strategy.words()),
+                 entries(DynamicWordStrategy::collectWords(TDocumentMirror::of(&document)->snapshot())));
+    };
+
+    // Typing inside a line.
+    QTextCursor cursor(document.findBlockByNumber(1));
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    cursor.insertText(QStringLiteral(" + الباقي"));
+    check();
+
+    // Deleting the last use of a word drops it.
+    cursor = QTextCursor(document.findBlockByNumber(2));
+    cursor.select(QTextCursor::BlockUnderCursor);
+    cursor.removeSelectedText();
+    check();
+    QCOMPARE(strategy.words().occurrences(QStringLiteral("اطبع")), 0);
+    QCOMPARE(strategy.words().occurrences(QStringLiteral("مجموع")), 1);
+
+    // A deletion spanning lines, then a new line.
+    cursor.setPosition(3);
+    cursor.setPosition(document.findBlockByNumber(1).position() + 4, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    check();
+    cursor.insertBlock();
+    cursor.insertText(QStringLiteral("ثابت حد = ١٠."));
+    check();
+
+    // Several lines replaced in one edit block.
+    cursor.beginEditBlock();
+    cursor.movePosition(QTextCursor::Start);
+    cursor.insertText(QStringLiteral("دالة رئيسية() {\n"));
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(QStringLiteral("\n}"));
+    cursor.endEditBlock();
+    check();
+
+    document.undo();
+    check();
+    document.setPlainText(QStringLiteral("جديد"));
+    check();
+    QCOMPARE(entries(strategy.words()), QStringList{QStringLiteral("جديد:1")});
+}
+
+void TestWordIndex::benchmarkLinearScan()
+{
+    // The previous index: startsWith() on every word of a QSet.
+    QBENCHMARK {
+        for (const QString &prefix : lookupPrefixes) {
+            const QStringList matches = linearScan(m_set, prefix);
+            Q_UNUSED(matches);
+        }
+    }
+}
+
+void TestWordIndex::benchmarkPrefixLookup()
+{
+    QBENCHMARK {
+        for (const QString &prefix : lookupPrefixes) {
+            const QStringList matches = prefixLookup(m_index, prefix);
+            Q_UNUSED(matches);
+        }
+    }
+}
+
+void TestWordIndex::benchmarkFuzzyAllWords()
+{
+    // Completion before the first-character range: the mask test on every
+    // word, then scoring.
+    std::vector<std::pair<QString, quint64>> words;
+    m_index.forEach([&words](const QString &word, int) {
+        words.emplace_back(word, TFuzzyMatcher::maskOf(TFuzzyMatcher::fold(word)));
+    });
+    QBENCHMARK {
+        for (const QString &pattern : fuzzyPatterns) {
+            const TFuzzyMatcher matcher(pattern);
+            int matches = 0;
+            for (const auto &[word, mask] : words) {
+                if ((mask & matcher.mask()) == matcher.mask() && matcher.score(word) != TFuzzyMatcher::NoMatch) {
+                    ++matches;
+                }
+            }
+            Q_UNUSED(matches);
+        }
+    }
+}
+
+void TestWordIndex::benchmarkFuzzyCandidates()
+{
+    QBENCHMARK {
+        for (const QString &pattern : fuzzyPatterns) {
+            const QStringList matches = fuzzyLookup(m_index, pattern);
+            Q_UNUSED(matches);
+        }
+    }
+}
+
+void TestWordIndex::benchmarkCollectWords()
+{
+    QStringList lines;
+    for (int i = 0; i < DocumentIdentifiers; i += 5) {
+        lines << QString("صحيح %1 = %2 + %3 * %4 - %5.")
+                     .arg(m_identifiers[i], m_identifiers[i + 1], m_identifiers[i + 2],
+                          m_identifiers[i + 3], m_identifiers[i + 4]);
+    }
+    QTextDocument document;
+    document.setPlainText(lines.join('\n'));
+    const TDocumentSnapshot snapshot = TDocumentMirror::of(&document)->snapshot();
+
+    QBENCHMARK {
+        const TWordIndex words = DynamicWordStrategy::collectWords(snapshot);
+        Q_UNUSED(words);
+    }
+}
+
+void TestWordIndex::benchmarkEditUpdate()
+{
+    // One keystroke in a 50k-identifier document; before, each deletion
+    // led to collectWords() over all of it.
+    QStringList lines;
+    for (int i = 0; i < DocumentIdentifiers; i += 5) {
+        lines << QString("%1 = %2 + %3 * %4 - %5.")
+                     .arg(m_identifiers[i], m_identifiers[i + 1], m_identifiers[i + 2],
+                          m_identifiers[i + 3], m_identifiers[i + 4]);
+    }
+    QTextDocument document;
+    document.setPlainText(lines.join('\n'));
+    DynamicWordStrategy strategy;
+    follow(document, strategy);
+
+    QTextCursor cursor(document.findBlockByNumber(document.blockCount() / 2));
+    cursor.movePosition(QTextCursor::EndOfWord);
+    QBENCHMARK {
+        cursor.insertText(QStringLiteral("س"));
+        cursor.deletePreviousChar();
+    }
+    QCOMPARE(strategy.words().size(), m_index.size());
+}
+
+QTEST_MAIN(TestWordIndex)
+#include "TestWordIndex.moc"
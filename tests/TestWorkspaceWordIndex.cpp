@@ -0,0 +1,164 @@
+#include "WorkspaceWordIndex.h"
+#include "AutoComplete.h"
+#include "TDocumentSnapshot.h"
+
+#include <QtTest/QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextDocument>
+#include <QTextStream>
+
+class TestWorkspaceWordIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void indexesBaaFilesInTheBackground();
+    void updatesSavedFileAndReleasesWords();
+    void workspaceStrategyLeavesLocalWords();
+    void benchmarkPrefixLookup();
+};
+
+namespace {
+void writeUtf8File(const QString &path, const QString &content)
+{
+    QFile file(path);
+    QVERIFY2(file.open(QIODevice::WriteOnly | QIODevice::Text), qPrintable(file.errorString()));
+    QTextStream stream(&file);
+    stream.setEncoding(QStringConverter::Utf8);
+    stream << content;
+}
+
+// Loads `files` and waits for the background scan to land.
+bool load(WorkspaceWordIndex &index, const QStringList &files)
+{
+    QSignalSpy spy(&index, &WorkspaceWordIndex::indexUpdated);
+    index.setFiles(files);
+    return spy.wait(5000);
+}
+
+QStringList lookup(const TWordIndex &words, const QString &prefix)
+{
+    QStringList matches;
+    words.forEachWithPrefix(prefix, [&matches](const QString &word, int) { matches << word; });
+    return matches;
+}
+}
+
+void TestWorkspaceWordIndex::indexesBaaFilesInTheBackground()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QDir root(tempDir.path());
+    writeUtf8File(root.filePath("main.baa"), "#تضمين \"مكتبة.baahd\"\nصحيح البداية() {\n    اطبع(حساب_المجموع(٢)).\n}\n");
+    writeUtf8File(root.filePath("مكتبة.baahd"), "صحيح حساب_المجموع(صحيح س).\nصحيح حساب_المتوسط(صحيح س).\n");
+    writeUtf8File(root.filePath("notes.txt"), "حساب_الملاحظات\n");
+
+    WorkspaceWordIndex index;
+    QVERIFY(load(index, {root.filePath("main.baa"), root.filePath("مكتبة.baahd"), root.filePath("notes.txt")}));
+
+    QCOMPARE(index.fileCount(), 2);
+    QCOMPARE(lookup(index.words(), QStringLiteral("حساب")),
+             (QStringList{QStringLiteral("حساب_المتوسط"), QStringLiteral("حساب_المجموع")}));
+    // Counted across files.
+    QCOMPARE(index.words().occurrences(QStringLiteral("حساب_المجموع")), 2);
+    QCOMPARE(index.stringCount(), index.words().size());
+}
+
+void TestWorkspaceWordIndex::updatesSavedFileAndReleasesWords()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QDir root(tempDir.path());
+    writeUtf8File(root.filePath("a.baa"), "صحيح الحد_الأعلى = ٩.\nصحيح العداد = الحد_الأعلى.\n");
+    writeUtf8File(root.filePath("b.baa"), "صحيح العداد = ٠.\n");
+
+    WorkspaceWordIndex index;
+    QVERIFY(load(index, {root.filePath("a.baa"), root.filePath("b.baa")}));
+    // Shared by both files, stored once.
+    QCOMPARE(index.words().occurrences(QStringLiteral("العداد")), 2);
+    const qsizetype strings = index.stringCount();
+
+    // Saving a.baa without الحد_الأعلى drops it and its string.
+    QTextDocument document;
+    document.setPlainText(QStringLiteral("صحيح العداد = ٥."));
+    QSignalSpy spy(&index, &WorkspaceWordIndex::indexUpdated);
+    index.updateFile(root.filePath("a.baa"), TDocumentMirror::of(&document)->snapshot());
+    QVERIFY(spy.wait(5000));
+
+    QCOMPARE(index.words().occurrences(QStringLiteral("الحد_الأعلى")), 0);
+    QCOMPARE(index.words().occurrences(QStringLiteral("العداد")), 2);
+    QCOMPARE(index.stringCount(), strings - 1);
+    QCOMPARE(index.fileCount(), 2);
+
+    // Other files are left out.
+    index.updateFile(root.filePath("README.md"), TDocumentMirror::of(&document)->snapshot());
+    QVERIFY(!spy.wait(100));
+    QCOMPARE(index.fileCount(), 2);
+}
+
+void TestWorkspaceWordIndex::workspaceStrategyLeavesLocalWords()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString path = QDir(tempDir.path()).filePath("lib.baahd");
+    writeUtf8File(path, "صحيح مساحة_الدائرة(عشري نق).\nصحيح مساحة_المربع(عشري ض).\n");
+    QVERIFY(load(*WorkspaceWordIndex::instance(), {path}));
+
+    QTextDocument document;
+    document.setPlainText(QStringLiteral("عشري م = مساحة_المربع(٢)."));
+    DynamicWordStrategy local;
+    local.rebuildIndex(TDocumentMirror::of(&document)->snapshot());
+    WorkspaceWordStrategy workspace(&local);
+
+    TCompletionCollector collector(QStringLiteral("مساحة"));
+    workspace.suggest(collector);
+    const std::vector<CompletionItem> items = collector.take();
+    QCOMPARE(items.size(), size_t(1));
+    QCOMPARE(items.front().completion, QStringLiteral("مساحة_الدائرة"));
+
+    QVERIFY(load(*WorkspaceWordIndex::instance(), {}));
+    workspace.suggest(collector);
+    QVERIFY(collector.take().empty());
+}
+
+void TestWorkspaceWordIndex::benchmarkPrefixLookup()
+{
+    // 200 files declaring 250 identifiers each, every one also used in a
+    // shared header.
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QDir root(tempDir.path());
+    QStringList files;
+    QStringList header;
+    for (int f = 0; f < 200; ++f) {
+        QStringList lines;
+        for (int i = 0; i < 250; ++i) {
+            const QString name = QString("متغير_%1_%2").arg(f).arg(i);
+            lines << QString("صحيح %1.").arg(name);
+            header << QString("صحيح %1.").arg(name);
+        }
+        files << root.filePath(QString("file%1.baa").arg(f));
+        writeUtf8File(files.last(), lines.join('\n'));
+    }
+    files << root.filePath("all.baahd");
+    writeUtf8File(files.last(), header.join('\n'));
+
+    WorkspaceWordIndex index;
+    QVERIFY(load(index, files));
+    QCOMPARE(index.words().size(), 50000 + 1);
+    QCOMPARE(index.stringCount(), index.words().size());
+
+    const QStringList prefixes = {QStringLiteral("متغير_123_1"), QStringLiteral("متغير_12_"),
+                                  QStringLiteral("متغير_199_24"), QStringLiteral("غير_موجود")};
+    QBENCHMARK {
+        for (const QString &prefix : prefixes) {
+            const QStringList matches = lookup(index.words(), prefix);
+            Q_UNUSED(matches);
+        }
+    }
+}
+
+QTEST_MAIN(TestWorkspaceWordIndex)
+#include "TestWorkspaceWordIndex.moc"
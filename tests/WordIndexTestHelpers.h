@@ -0,0 +1,29 @@
+#pragma once
+
+#include "AutoComplete.h"
+#include "TDocumentSnapshot.h"
+#include "TWordIndex.h"
+
+#include <QStringList>
+#include <QTextDocument>
+
+// Shared by TestWordIndex and TestAsyncCompletion.
+
+// Every word of the index with its count, as "word:count", in folded order.
+inline QStringList entries(const TWordIndex &index)
+{
+    QStringList all;
+    index.forEach([&all](const QString &word, int count) { all << word + QLatin1Char(':') + QString::number(count); });
+    return all;
+}
+
+// A strategy kept current by a document's mirror, as TEditor keeps its own.
+inline void follow(QTextDocument &document, DynamicWordStrategy &strategy)
+{
+    TDocumentMirror *mirror = TDocumentMirror::of(&document);
+    strategy.rebuildIndex(mirror->snapshot());
+    QObject::connect(mirror, &TDocumentMirror::linesReplaced, &document,
+                     [&strategy, mirror](const TDocumentSnapshot &before, int first, int removed, int added) {
+        strategy.replaceLines(before, mirror->snapshot(), first, removed, added);
+    });
+}